@@ -0,0 +1,129 @@
+// File: bench/bench_tiled.c
+//
+// Micro-benchmark of the MP2 pair loop over <ij|ab>/<ij|ba>: the flat MO_TEI
+// layout (for fixed i,j the (a,b) block has row stride mo_num) against the
+// cache-tiled layout of tiled_oovv.h.
+//
+// Usage: bench_tiled [mo_num ...]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "tiled_oovv.h"
+
+// Occupied orbitals used for every size; the (a,b) block is what is being measured
+#define BENCH_N_OCC 4
+
+// Flat MO_TEI addressing restricted to occupied (i,j): the (k,l) block keeps row stride mo_num
+#define MO_TEI(i,j,k,l, arr, mo_num) \
+    (arr[ (((size_t)(i)*BENCH_N_OCC + (j))*(mo_num) + (k))*(mo_num) + (l) ])
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+/**
+ * @brief Runs both layouts for one mo_num and prints a result line.
+ */
+static void bench_size(int mo_num) {
+    int n_occ = BENCH_N_OCC;
+    int n_virt = mo_num - n_occ;
+
+    double* mo_energy = (double*)malloc(mo_num * sizeof(double));
+    double* flat = (double*)calloc((size_t)n_occ * n_occ * mo_num * mo_num, sizeof(double));
+    if (!mo_energy || !flat) {
+        fprintf(stderr, "Memory allocation failed for benchmark mo_num=%d.\n", mo_num);
+        exit(EXIT_FAILURE);
+    }
+    for (int p = 0; p < mo_num; p++) {
+        mo_energy[p] = p < n_occ ? -1.0 + 0.1 * p : 0.1 + 0.01 * p;
+    }
+
+    tiled_oovv tiled;
+    if (tiled_oovv_init(&tiled, n_occ, n_virt) != 0) {
+        exit(EXIT_FAILURE);
+    }
+
+    // Same pseudo-random <ij|ab> in both layouts
+    srand(12345);
+    for (int i = 0; i < n_occ; i++) {
+        for (int j = 0; j < n_occ; j++) {
+            for (int a = n_occ; a < mo_num; a++) {
+                for (int b = n_occ; b < mo_num; b++) {
+                    double v = (double)rand() / RAND_MAX - 0.5;
+                    MO_TEI(i, j, a, b, flat, mo_num) = v;
+                    tiled.data[tiled_oovv_offset(&tiled, i, j, a - n_occ, b - n_occ)] = v;
+                }
+            }
+        }
+    }
+
+    // Repeat so that every size runs for a comparable amount of work
+    int reps = (int)(4.0e7 / ((double)n_occ * n_occ * n_virt * n_virt)) + 1;
+
+    double e_flat = 0.0;
+    double t0 = now();
+    for (int r = 0; r < reps; r++) {
+        for (int i = 0; i < n_occ; i++) {
+            for (int j = 0; j < n_occ; j++) {
+                for (int a = n_occ; a < mo_num; a++) {
+                    for (int b = n_occ; b < mo_num; b++) {
+                        double denom = (mo_energy[i] + mo_energy[j]) - (mo_energy[a] + mo_energy[b]);
+                        double ijab = MO_TEI(i, j, a, b, flat, mo_num);
+                        double ijba = MO_TEI(i, j, b, a, flat, mo_num);
+                        e_flat += ijab * (2.0 * ijab - ijba) / denom;
+                    }
+                }
+            }
+        }
+    }
+    double t_flat = (now() - t0) / reps;
+
+    double e_tiled = 0.0;
+    t0 = now();
+    for (int r = 0; r < reps; r++) {
+        for (int i = 0; i < n_occ; i++) {
+            for (int j = 0; j < n_occ; j++) {
+                e_tiled += tiled_oovv_pair_energy(&tiled, mo_energy, i, j);
+            }
+        }
+    }
+    double t_tiled = (now() - t0) / reps;
+
+    double rel = fabs(e_flat - e_tiled) / (fabs(e_flat) > 0.0 ? fabs(e_flat) : 1.0);
+    printf("%6d %6d %12.3f %12.3f %8.2f %10.1e\n",
+           mo_num, n_virt, 1e3 * t_flat, 1e3 * t_tiled, t_flat / t_tiled, rel);
+
+    free_tiled_oovv(&tiled);
+    free(flat);
+    free(mo_energy);
+}
+
+int main(int argc, char* argv[]) {
+    int default_sizes[] = { 50, 100, 200, 300, 400, 500 };
+    int n_default = (int)(sizeof(default_sizes) / sizeof(default_sizes[0]));
+
+    printf("# TILE_DIM = %d, n_occ = %d, times per full (ij,ab) sweep\n", TILE_DIM, BENCH_N_OCC);
+    printf("%6s %6s %12s %12s %8s %10s\n", "mo_num", "n_virt", "flat [ms]", "tiled [ms]",
+           "speedup", "rel.diff");
+
+    if (argc > 1) {
+        for (int arg = 1; arg < argc; arg++) {
+            int mo_num = atoi(argv[arg]);
+            if (mo_num <= BENCH_N_OCC) {
+                fprintf(stderr, "mo_num must be larger than %d: '%s'\n", BENCH_N_OCC, argv[arg]);
+                return EXIT_FAILURE;
+            }
+            bench_size(mo_num);
+        }
+    } else {
+        for (int s = 0; s < n_default; s++) {
+            bench_size(default_sizes[s]);
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
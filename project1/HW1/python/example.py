@@ -0,0 +1,34 @@
+# File: python/example.py
+#
+# Computes HF and MP2 energies from integrals held in NumPy arrays, without
+# writing a TREXIO file or spawning compute_energy. The arrays here are read
+# from a TREXIO file only to have realistic input; a pipeline would pass the
+# arrays it built itself (e.g. from psi4 as in generate_water_trexio.py).
+#
+# Usage: python3 example.py <trexio_file>
+
+import sys
+import numpy as np
+import trexio
+import hfmp2
+
+with trexio.File(sys.argv[1], "r", trexio.TREXIO_AUTO) as f:
+    e_nn = trexio.read_nucleus_repulsion(f)
+    n_occ = trexio.read_electron_up_num(f)
+    core = np.ascontiguousarray(trexio.read_mo_1e_int_core_hamiltonian(f))
+    mo_energy = np.ascontiguousarray(trexio.read_mo_energy(f))
+    n = trexio.read_mo_2e_int_eri_size(f)
+    index, value, _, _ = trexio.read_mo_2e_int_eri(f, 0, n)
+
+# uint8 indices are enough below 256 orbitals and are used as-is, without a copy
+index = np.ascontiguousarray(index, dtype=np.uint8 if len(mo_energy) <= 256 else np.int32)
+value = np.ascontiguousarray(value, dtype=np.float64)
+
+e_hf = hfmp2.hf_energy(e_nn, core, index, value, n_occ)
+e_mp2 = hfmp2.mp2_energy(mo_energy, index, value, n_occ)
+fock = np.empty_like(core)
+hfmp2.fock_matrix(core, index, value, n_occ, fock)
+
+print(f"E(HF)  = {e_hf:.8f}")
+print(f"E(MP2) = {e_hf + e_mp2:.8f}")
+print(f"max |F_pp - e_p| = {np.abs(np.diag(fock) - mo_energy).max():.3e}")
@@ -0,0 +1,264 @@
+// File: python/hfmp2module.c
+//
+// CPython bindings over the hf_energy/mp2_energy/fock API. Arrays are taken
+// through the buffer protocol (NumPy arrays, memoryviews, array.array, ...) and
+// handed to the C kernels without copying; the GIL is released while they run.
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <errno.h>
+#include <math.h>
+#include "eri_index.h"
+#include "fock.h"
+#include "hf_energy.h"
+#include "mp2_energy.h"
+
+/**
+ * @brief Gets a C-contiguous buffer of doubles with at least `count` elements (count < 0: any).
+ */
+static int get_double_buffer(PyObject* obj, Py_buffer* view, int writable, Py_ssize_t count,
+                             const char* name) {
+    int flags = PyBUF_C_CONTIGUOUS | PyBUF_FORMAT | (writable ? PyBUF_WRITABLE : 0);
+    if (PyObject_GetBuffer(obj, view, flags) != 0) {
+        return -1;
+    }
+    if (view->itemsize != sizeof(double) || strcmp(view->format, "d") != 0) {
+        PyErr_Format(PyExc_TypeError, "%s must be a contiguous float64 array", name);
+        PyBuffer_Release(view);
+        return -1;
+    }
+    if (count >= 0 && view->len / view->itemsize != count) {
+        PyErr_Format(PyExc_ValueError, "%s must have %zd elements, got %zd",
+                     name, count, view->len / view->itemsize);
+        PyBuffer_Release(view);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Wraps an (n, 4) uint8/uint16/int32 index array and its values as an eri_index.
+ *
+ * Every index is checked to lie in [0, mo_num): the kernels use them as array offsets
+ * without further checks, so a bad entry would write out of bounds.
+ */
+static int get_eri(PyObject* index_obj, PyObject* value_obj, int mo_num,
+                   Py_buffer* index_view, Py_buffer* value_view, eri_index* eri) {
+    if (PyObject_GetBuffer(index_obj, index_view, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) != 0) {
+        return -1;
+    }
+    const char* fmt = index_view->format;
+    char code = fmt[0] == '<' || fmt[0] == '=' || fmt[0] == '@' ? fmt[1] : fmt[0];
+    int width = (int)index_view->itemsize;
+    // Exactly the layouts eri_iter_next decodes: unsigned 1 and 2 bytes, signed 4 bytes
+    int supported = (code == 'B' && width == 1) || (code == 'H' && width == 2) ||
+                    (code == 'i' && width == 4);
+    if (!supported || index_view->ndim != 2 || index_view->shape[1] != 4) {
+        PyErr_SetString(PyExc_TypeError,
+                        "eri_index must be a contiguous (n, 4) uint8, uint16 or int32 array");
+        PyBuffer_Release(index_view);
+        return -1;
+    }
+    Py_ssize_t n_integrals = index_view->shape[0];
+    if (width < eri_index_width_for(mo_num) && width != 4) {
+        PyErr_Format(PyExc_ValueError, "%d-byte indices cannot address %d orbitals", width, mo_num);
+        PyBuffer_Release(index_view);
+        return -1;
+    }
+    for (Py_ssize_t k = 0; k < 4 * n_integrals; k++) {
+        long idx = width == 1 ? (long)((const uint8_t*)index_view->buf)[k] :
+                   width == 2 ? (long)((const uint16_t*)index_view->buf)[k] :
+                                (long)((const int32_t*)index_view->buf)[k];
+        if (idx < 0 || idx >= mo_num) {
+            PyErr_Format(PyExc_ValueError, "eri_index[%zd, %zd] = %ld is not an orbital index in [0, %d)",
+                         k / 4, k % 4, idx, mo_num);
+            PyBuffer_Release(index_view);
+            return -1;
+        }
+    }
+
+    if (get_double_buffer(value_obj, value_view, 0, n_integrals, "eri_value") != 0) {
+        PyBuffer_Release(index_view);
+        return -1;
+    }
+
+    eri_index_wrap(eri, mo_num, n_integrals, width, index_view->buf);
+    return 0;
+}
+
+/**
+ * @brief Returns the number of orbitals of a square mo_num x mo_num buffer, or -1.
+ */
+static int square_dim(const Py_buffer* view) {
+    Py_ssize_t n2 = view->len / view->itemsize;
+    int n = (int)floor(sqrt((double)n2) + 0.5);
+    return (Py_ssize_t)n * n == n2 ? n : -1;
+}
+
+PyDoc_STRVAR(hf_energy_doc,
+"hf_energy(e_nn, core_hamiltonian, eri_index, eri_value, n_occ) -> float\n\n"
+"Hartree-Fock energy. core_hamiltonian is (mo_num, mo_num) float64, eri_index is\n"
+"(n, 4) uint8/uint16/int32 in TREXIO <ij|kl> order and eri_value is (n,) float64.");
+
+static PyObject* py_hf_energy(PyObject* self, PyObject* args) {
+    double e_nn;
+    int n_occ;
+    PyObject *core_obj, *index_obj, *value_obj;
+    if (!PyArg_ParseTuple(args, "dOOOi", &e_nn, &core_obj, &index_obj, &value_obj, &n_occ)) {
+        return NULL;
+    }
+
+    Py_buffer core, index, value;
+    if (get_double_buffer(core_obj, &core, 0, -1, "core_hamiltonian") != 0) {
+        return NULL;
+    }
+    int mo_num = square_dim(&core);
+    if (mo_num <= 0 || n_occ < 0 || n_occ > mo_num) {
+        PyErr_SetString(PyExc_ValueError, "core_hamiltonian must be square and n_occ <= mo_num");
+        PyBuffer_Release(&core);
+        return NULL;
+    }
+    eri_index eri;
+    if (get_eri(index_obj, value_obj, mo_num, &index, &value, &eri) != 0) {
+        PyBuffer_Release(&core);
+        return NULL;
+    }
+
+    // The kernels report a failed allocation as NAN with errno = ENOMEM instead of exiting
+    double energy;
+    int failed;
+    Py_BEGIN_ALLOW_THREADS
+    errno = 0;
+    energy = compute_HF_energy(e_nn, (double*)core.buf, &eri, (double*)value.buf, mo_num, n_occ);
+    failed = isnan(energy) && errno == ENOMEM;
+    Py_END_ALLOW_THREADS
+
+    free_eri_index(&eri);
+    PyBuffer_Release(&core);
+    PyBuffer_Release(&index);
+    PyBuffer_Release(&value);
+    return failed ? PyErr_NoMemory() : PyFloat_FromDouble(energy);
+}
+
+PyDoc_STRVAR(mp2_energy_doc,
+"mp2_energy(mo_energy, eri_index, eri_value, n_occ) -> float\n\n"
+"MP2 correlation energy; mo_num is taken from len(mo_energy).");
+
+static PyObject* py_mp2_energy(PyObject* self, PyObject* args) {
+    int n_occ;
+    PyObject *energy_obj, *index_obj, *value_obj;
+    if (!PyArg_ParseTuple(args, "OOOi", &energy_obj, &index_obj, &value_obj, &n_occ)) {
+        return NULL;
+    }
+
+    Py_buffer mo_energy, index, value;
+    if (get_double_buffer(energy_obj, &mo_energy, 0, -1, "mo_energy") != 0) {
+        return NULL;
+    }
+    int mo_num = (int)(mo_energy.len / mo_energy.itemsize);
+    if (n_occ < 0 || n_occ > mo_num) {
+        PyErr_SetString(PyExc_ValueError, "n_occ must lie between 0 and len(mo_energy)");
+        PyBuffer_Release(&mo_energy);
+        return NULL;
+    }
+    eri_index eri;
+    if (get_eri(index_obj, value_obj, mo_num, &index, &value, &eri) != 0) {
+        PyBuffer_Release(&mo_energy);
+        return NULL;
+    }
+
+    double energy;
+    int failed;
+    Py_BEGIN_ALLOW_THREADS
+    errno = 0;
+    energy = compute_MP2_energy((double*)mo_energy.buf, mo_num, n_occ, &eri, (double*)value.buf, NULL);
+    failed = isnan(energy) && errno == ENOMEM;
+    Py_END_ALLOW_THREADS
+
+    free_eri_index(&eri);
+    PyBuffer_Release(&mo_energy);
+    PyBuffer_Release(&index);
+    PyBuffer_Release(&value);
+    return failed ? PyErr_NoMemory() : PyFloat_FromDouble(energy);
+}
+
+PyDoc_STRVAR(fock_matrix_doc,
+"fock_matrix(core_hamiltonian, eri_index, eri_value, n_occ, out) -> None\n\n"
+"Builds F = h + 2J - K for the closed-shell occupied density into the writable\n"
+"(mo_num, mo_num) float64 buffer out.");
+
+static PyObject* py_fock_matrix(PyObject* self, PyObject* args) {
+    int n_occ;
+    PyObject *core_obj, *index_obj, *value_obj, *out_obj;
+    if (!PyArg_ParseTuple(args, "OOOiO", &core_obj, &index_obj, &value_obj, &n_occ, &out_obj)) {
+        return NULL;
+    }
+
+    Py_buffer core, index, value, out;
+    if (get_double_buffer(core_obj, &core, 0, -1, "core_hamiltonian") != 0) {
+        return NULL;
+    }
+    int mo_num = square_dim(&core);
+    if (mo_num <= 0 || n_occ < 0 || n_occ > mo_num) {
+        PyErr_SetString(PyExc_ValueError, "core_hamiltonian must be square and n_occ <= mo_num");
+        PyBuffer_Release(&core);
+        return NULL;
+    }
+    if (get_double_buffer(out_obj, &out, 1, (Py_ssize_t)mo_num * mo_num, "out") != 0) {
+        PyBuffer_Release(&core);
+        return NULL;
+    }
+    eri_index eri;
+    if (get_eri(index_obj, value_obj, mo_num, &index, &value, &eri) != 0) {
+        PyBuffer_Release(&core);
+        PyBuffer_Release(&out);
+        return NULL;
+    }
+
+    double* density = (double*)malloc((size_t)mo_num * mo_num * sizeof(double));
+    if (!density) {
+        free_eri_index(&eri);
+        PyBuffer_Release(&core);
+        PyBuffer_Release(&out);
+        PyBuffer_Release(&index);
+        PyBuffer_Release(&value);
+        return PyErr_NoMemory();
+    }
+
+    int status;
+    Py_BEGIN_ALLOW_THREADS
+    occupied_density(mo_num, n_occ, density);
+    status = build_fock_matrix((double*)core.buf, &eri, (double*)value.buf, density, mo_num,
+                               (double*)out.buf);
+    Py_END_ALLOW_THREADS
+
+    free(density);
+    free_eri_index(&eri);
+    PyBuffer_Release(&core);
+    PyBuffer_Release(&out);
+    PyBuffer_Release(&index);
+    PyBuffer_Release(&value);
+    if (status != 0) {
+        return PyErr_NoMemory();
+    }
+    Py_RETURN_NONE;
+}
+
+static PyMethodDef hfmp2_methods[] = {
+    { "hf_energy", py_hf_energy, METH_VARARGS, hf_energy_doc },
+    { "mp2_energy", py_mp2_energy, METH_VARARGS, mp2_energy_doc },
+    { "fock_matrix", py_fock_matrix, METH_VARARGS, fock_matrix_doc },
+    { NULL, NULL, 0, NULL }
+};
+
+static struct PyModuleDef hfmp2_module = {
+    PyModuleDef_HEAD_INIT,
+    "hfmp2",
+    "Zero-copy bindings for the HF/MP2 energy kernels.",
+    -1,
+    hfmp2_methods
+};
+
+PyMODINIT_FUNC PyInit_hfmp2(void) {
+    return PyModule_Create(&hfmp2_module);
+}
@@ -0,0 +1,26 @@
+# File: python/setup.py
+#
+# Builds the hfmp2 extension in place:  python3 setup.py build_ext --inplace
+# (or `make python` from the project directory).
+
+import os
+from setuptools import setup, Extension
+
+here = os.path.dirname(os.path.abspath(__file__))
+src = os.path.join(here, "..", "src")
+
+hfmp2 = Extension(
+    "hfmp2",
+    sources=[os.path.join(here, "hfmp2module.c")] + [
+        os.path.join(src, name)
+        for name in ("hf_energy.c", "mp2_energy.c", "eri_index.c",
+                     "tiled_oovv.c", "fock.c", "numa_util.c", "mp2_checkpoint.c")
+    ],
+    include_dirs=[src, "/usr/local/include"],
+    library_dirs=["/usr/local/lib"],
+    libraries=["trexio", "m"],
+    extra_compile_args=["-O2", "-fopenmp"],
+    extra_link_args=["-fopenmp"],
+)
+
+setup(name="hfmp2", version="0.1", ext_modules=[hfmp2])
@@ -0,0 +1,199 @@
+// File: src/eri_index.c
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "eri_index.h"
+
+/**
+ * @brief Returns the smallest index width (1, 2 or 4 bytes) able to hold orbitals of mo_num.
+ */
+int eri_index_width_for(int mo_num) {
+    if (mo_num <= 256) {
+        return 1;
+    }
+    if (mo_num <= 65536) {
+        return 2;
+    }
+    return 4;
+}
+
+/**
+ * @brief Allocates packed-quadruplet storage for n_integrals integrals.
+ */
+void eri_index_init(eri_index* eri, int mo_num, int64_t n_integrals) {
+    memset(eri, 0, sizeof(*eri));
+    eri->n_integrals = n_integrals;
+    eri->mo_num = mo_num;
+    eri->width = eri_index_width_for(mo_num);
+
+    eri->packed = malloc((size_t)(4 * n_integrals) * (size_t)eri->width + 1);
+    if (!eri->packed) {
+        fprintf(stderr, "Memory allocation failed for packed two-electron integral indices.\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+/**
+ * @brief Packs a block of int32 quadruplets (as returned by TREXIO) starting at integral offset.
+ */
+void eri_index_pack(eri_index* eri, int64_t offset, int64_t count, const int32_t* index) {
+    size_t first = (size_t)(4 * offset);
+    size_t len = (size_t)(4 * count);
+
+    switch (eri->width) {
+        case 1: {
+            uint8_t* p = (uint8_t*)eri->packed + first;
+            for (size_t n = 0; n < len; n++) {
+                p[n] = (uint8_t)index[n];
+            }
+            break;
+        }
+        case 2: {
+            uint16_t* p = (uint16_t*)eri->packed + first;
+            for (size_t n = 0; n < len; n++) {
+                p[n] = (uint16_t)index[n];
+            }
+            break;
+        }
+        default:
+            memcpy((int32_t*)eri->packed + first, index, len * sizeof(int32_t));
+            break;
+    }
+}
+
+/**
+ * @brief Uses caller-owned packed quadruplets as an index without copying them.
+ */
+void eri_index_wrap(eri_index* eri, int mo_num, int64_t n_integrals, int width, void* packed) {
+    memset(eri, 0, sizeof(*eri));
+    eri->n_integrals = n_integrals;
+    eri->mo_num = mo_num;
+    eri->width = width;
+    eri->packed = packed;
+    eri->borrowed = 1;
+}
+
+// Key/value pair used while sorting the integrals
+typedef struct {
+    uint64_t key;
+    double val;
+} eri_keyed;
+
+static int compare_keyed(const void* a, const void* b) {
+    uint64_t ka = ((const eri_keyed*)a)->key;
+    uint64_t kb = ((const eri_keyed*)b)->key;
+    return (ka > kb) - (ka < kb);
+}
+
+/**
+ * @brief Sorts the integrals by key and re-encodes the index as a delta stream.
+ */
+void eri_index_encode_deltas(eri_index* eri, double* value) {
+    if (eri->width == 0) {
+        return;
+    }
+    if (eri->mo_num > ERI_DELTA_MAX_MO) {
+        fprintf(stderr, "Delta-encoded indices support at most %d orbitals (mo_num = %d); keeping the packed index.\n",
+                ERI_DELTA_MAX_MO, eri->mo_num);
+        return;
+    }
+    int64_t n_integrals = eri->n_integrals;
+    uint64_t m = (uint64_t)eri->mo_num;
+
+    eri_keyed* keyed = (eri_keyed*)malloc((size_t)n_integrals * sizeof(eri_keyed) + 1);
+    if (!keyed) {
+        fprintf(stderr, "Memory allocation failed for sorting two-electron integrals.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    eri_iter it;
+    eri_iter_init(&it, eri);
+    for (int64_t n = 0; n < n_integrals; n++) {
+        int idx[4];
+        eri_iter_next(&it, idx);
+        keyed[n].key = (((uint64_t)idx[0] * m + (uint64_t)idx[1]) * m + (uint64_t)idx[2]) * m +
+                       (uint64_t)idx[3];
+        keyed[n].val = value[n];
+    }
+    qsort(keyed, (size_t)n_integrals, sizeof(eri_keyed), compare_keyed);
+
+    // A delta never needs more than 10 LEB128 bytes; sorted lists use far fewer
+    size_t capacity = (size_t)n_integrals * 2 + 16;
+    uint8_t* deltas = (uint8_t*)malloc(capacity);
+    if (!deltas) {
+        fprintf(stderr, "Memory allocation failed for delta-encoded integral indices.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    int64_t n_blocks = (n_integrals + ERI_SEEK_BLOCK - 1) / ERI_SEEK_BLOCK;
+    eri->block_pos = (size_t*)malloc((size_t)n_blocks * sizeof(size_t) + 1);
+    eri->block_key = (uint64_t*)malloc((size_t)n_blocks * sizeof(uint64_t) + 1);
+    if (!eri->block_pos || !eri->block_key) {
+        fprintf(stderr, "Memory allocation failed for delta-encoded integral checkpoints.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    size_t pos = 0;
+    uint64_t previous = 0;
+    for (int64_t n = 0; n < n_integrals; n++) {
+        if (n % ERI_SEEK_BLOCK == 0) {
+            eri->block_pos[n / ERI_SEEK_BLOCK] = pos;
+            eri->block_key[n / ERI_SEEK_BLOCK] = previous;
+        }
+        if (pos + 10 > capacity) {
+            capacity *= 2;
+            uint8_t* grown = (uint8_t*)realloc(deltas, capacity);
+            if (!grown) {
+                fprintf(stderr, "Memory allocation failed for delta-encoded integral indices.\n");
+                exit(EXIT_FAILURE);
+            }
+            deltas = grown;
+        }
+
+        uint64_t delta = keyed[n].key - previous;
+        previous = keyed[n].key;
+        while (delta >= 0x80) {
+            deltas[pos++] = (uint8_t)(delta | 0x80);
+            delta >>= 7;
+        }
+        deltas[pos++] = (uint8_t)delta;
+        value[n] = keyed[n].val;
+    }
+    free(keyed);
+
+    // Trim the stream to its final size
+    uint8_t* trimmed = (uint8_t*)realloc(deltas, pos + 1);
+    if (!eri->borrowed) {
+        free(eri->packed);
+    }
+    eri->borrowed = 0;
+    eri->packed = NULL;
+    eri->deltas = trimmed ? trimmed : deltas;
+    eri->deltas_size = pos;
+    eri->width = 0;
+}
+
+/**
+ * @brief Returns the number of bytes used to store the indices.
+ */
+size_t eri_index_bytes(const eri_index* eri) {
+    if (eri->width == 0) {
+        size_t n_blocks = (size_t)((eri->n_integrals + ERI_SEEK_BLOCK - 1) / ERI_SEEK_BLOCK);
+        return eri->deltas_size + n_blocks * (sizeof(size_t) + sizeof(uint64_t));
+    }
+    return (size_t)(4 * eri->n_integrals) * (size_t)eri->width;
+}
+
+/**
+ * @brief Releases the storage held by an eri_index.
+ */
+void free_eri_index(eri_index* eri) {
+    if (!eri->borrowed) {
+        free(eri->packed);
+    }
+    free(eri->deltas);
+    free(eri->block_pos);
+    free(eri->block_key);
+    memset(eri, 0, sizeof(*eri));
+}
@@ -0,0 +1,227 @@
+// File: src/eri_index.h
+
+#ifndef ERI_INDEX_H
+#define ERI_INDEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Integrals per seek checkpoint in the delta stream; parallel loops split on this boundary
+#define ERI_SEEK_BLOCK 4096
+
+// Largest mo_num whose keys ((i*m + j)*m + k)*m + l fit in 64 bits (m^4 <= 2^64)
+#define ERI_DELTA_MAX_MO 65535
+
+/**
+ * @brief Compact storage for the orbital indices of the sparse two-electron integrals.
+ *
+ * Indices are stored either as packed quadruplets of 1, 2 or 4 bytes per orbital
+ * index (chosen from mo_num), or, after sorting, as a stream of LEB128-encoded
+ * deltas between consecutive keys ((i*mo_num + j)*mo_num + k)*mo_num + l.
+ * Kernels never see the raw layout; they walk the list with an eri_iter, which
+ * can be positioned at any multiple of ERI_SEEK_BLOCK.
+ */
+typedef struct {
+    int64_t n_integrals;  // Number of stored integrals
+    int mo_num;           // Number of molecular orbitals (needed to unpack keys)
+    int width;            // Bytes per orbital index: 1, 2 or 4, or 0 for delta-encoded keys
+    void* packed;         // Packed quadruplets (width > 0)
+    uint8_t* deltas;      // Delta stream (width == 0)
+    size_t deltas_size;   // Bytes used in the delta stream
+    size_t* block_pos;    // Delta stream offset of every ERI_SEEK_BLOCK-th integral
+    uint64_t* block_key;  // Key preceding every ERI_SEEK_BLOCK-th integral
+    int borrowed;         // Packed quadruplets belong to the caller (see eri_index_wrap)
+} eri_index;
+
+/**
+ * @brief Sequential decoder over an eri_index.
+ */
+typedef struct {
+    const eri_index* eri;
+    int64_t n;     // Next integral to decode
+    size_t pos;    // Byte position in the delta stream
+    uint64_t key;  // Last decoded key in the delta stream
+} eri_iter;
+
+/**
+ * @brief Returns the smallest index width (1, 2 or 4 bytes) able to hold orbitals of mo_num.
+ *
+ * @param mo_num Number of molecular orbitals.
+ * @return Bytes per orbital index.
+ */
+int eri_index_width_for(int mo_num);
+
+/**
+ * @brief Allocates packed-quadruplet storage for n_integrals integrals.
+ *
+ * @param eri Index to initialise.
+ * @param mo_num Number of molecular orbitals.
+ * @param n_integrals Number of integrals to hold.
+ */
+void eri_index_init(eri_index* eri, int mo_num, int64_t n_integrals);
+
+/**
+ * @brief Packs a block of int32 quadruplets (as returned by TREXIO) starting at integral offset.
+ *
+ * @param eri Index initialised with eri_index_init.
+ * @param offset Position of the first integral of the block.
+ * @param count Number of integrals in the block.
+ * @param index Block of 4 * count int32 indices.
+ */
+void eri_index_pack(eri_index* eri, int64_t offset, int64_t count, const int32_t* index);
+
+/**
+ * @brief Uses caller-owned packed quadruplets as an index without copying them.
+ *
+ * The buffer must hold 4 * n_integrals indices of `width` bytes each and must
+ * outlive the index; free_eri_index leaves it alone.
+ *
+ * @param eri Index to initialise.
+ * @param mo_num Number of molecular orbitals.
+ * @param n_integrals Number of integrals in the buffer.
+ * @param width Bytes per orbital index: 1, 2 or 4.
+ * @param packed Caller-owned index buffer.
+ */
+void eri_index_wrap(eri_index* eri, int mo_num, int64_t n_integrals, int width, void* packed);
+
+/**
+ * @brief Sorts the integrals by key and re-encodes the index as a delta stream.
+ *
+ * The value array is permuted alongside so that integral n keeps its value.
+ * For mo_num above ERI_DELTA_MAX_MO the keys would overflow, so the packed
+ * index is kept and a message is printed instead.
+ *
+ * @param eri Packed index to convert.
+ * @param value Values array for two-electron integrals.
+ */
+void eri_index_encode_deltas(eri_index* eri, double* value);
+
+/**
+ * @brief Returns the number of bytes used to store the indices.
+ */
+size_t eri_index_bytes(const eri_index* eri);
+
+/**
+ * @brief Releases the storage held by an eri_index.
+ */
+void free_eri_index(eri_index* eri);
+
+/**
+ * @brief Positions an iterator on the first integral.
+ */
+static inline void eri_iter_init(eri_iter* it, const eri_index* eri) {
+    it->eri = eri;
+    it->n = 0;
+    it->pos = 0;
+    it->key = 0;
+}
+
+/**
+ * @brief Positions an iterator on integral n, which must be a multiple of ERI_SEEK_BLOCK.
+ */
+static inline void eri_iter_seek(eri_iter* it, const eri_index* eri, int64_t n) {
+    eri_iter_init(it, eri);
+    it->n = n;
+    if (eri->width == 0 && n < eri->n_integrals) {
+        it->pos = eri->block_pos[n / ERI_SEEK_BLOCK];
+        it->key = eri->block_key[n / ERI_SEEK_BLOCK];
+    }
+}
+
+/**
+ * @brief Decodes the indices of the next integral into idx[0..3].
+ *
+ * Must be called exactly n_integrals times; integral n pairs with value[n].
+ */
+static inline void eri_iter_next(eri_iter* it, int idx[4]) {
+    const eri_index* eri = it->eri;
+    int64_t n = it->n++;
+
+    switch (eri->width) {
+        case 1: {
+            const uint8_t* p = (const uint8_t*)eri->packed + 4 * n;
+            idx[0] = p[0]; idx[1] = p[1]; idx[2] = p[2]; idx[3] = p[3];
+            break;
+        }
+        case 2: {
+            const uint16_t* p = (const uint16_t*)eri->packed + 4 * n;
+            idx[0] = p[0]; idx[1] = p[1]; idx[2] = p[2]; idx[3] = p[3];
+            break;
+        }
+        case 4: {
+            const int32_t* p = (const int32_t*)eri->packed + 4 * n;
+            idx[0] = p[0]; idx[1] = p[1]; idx[2] = p[2]; idx[3] = p[3];
+            break;
+        }
+        default: {
+            // LEB128 varint: 7 payload bits per byte, high bit set on all but the last
+            uint64_t delta = 0;
+            int shift = 0;
+            uint8_t byte;
+            do {
+                byte = eri->deltas[it->pos++];
+                delta |= (uint64_t)(byte & 0x7f) << shift;
+                shift += 7;
+            } while (byte & 0x80);
+            it->key += delta;
+
+            uint64_t key = it->key;
+            uint64_t m = (uint64_t)eri->mo_num;
+            idx[3] = (int)(key % m); key /= m;
+            idx[2] = (int)(key % m); key /= m;
+            idx[1] = (int)(key % m); key /= m;
+            idx[0] = (int)key;
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Expands one integral <ij|kl> into its 8 symmetry-equivalent index quadruplets.
+ *
+ * Integrals with repeated indices yield duplicate quadruplets; callers assign
+ * rather than accumulate, so duplicates are harmless.
+ */
+static inline void eri_permutations(const int idx[4], int perm[8][4]) {
+    int i = idx[0], j = idx[1], k = idx[2], l = idx[3];
+    int p[8][4] = {
+        {i, j, k, l}, {i, l, k, j}, {k, l, i, j}, {k, j, i, l},
+        {j, i, l, k}, {l, i, j, k}, {l, k, j, i}, {j, k, l, i}
+    };
+    for (int n = 0; n < 8; n++) {
+        perm[n][0] = p[n][0];
+        perm[n][1] = p[n][1];
+        perm[n][2] = p[n][2];
+        perm[n][3] = p[n][3];
+    }
+}
+
+/**
+ * @brief Like eri_permutations, but keeps each distinct quadruplet only once.
+ *
+ * Needed by kernels that accumulate into their target rather than assign.
+ *
+ * @return Number of distinct quadruplets written to perm.
+ */
+static inline int eri_unique_permutations(const int idx[4], int perm[8][4]) {
+    int all[8][4];
+    int count = 0;
+    eri_permutations(idx, all);
+    for (int n = 0; n < 8; n++) {
+        int seen = 0;
+        for (int m = 0; m < count && !seen; m++) {
+            seen = perm[m][0] == all[n][0] && perm[m][1] == all[n][1] &&
+                   perm[m][2] == all[n][2] && perm[m][3] == all[n][3];
+        }
+        if (!seen) {
+            perm[count][0] = all[n][0];
+            perm[count][1] = all[n][1];
+            perm[count][2] = all[n][2];
+            perm[count][3] = all[n][3];
+            count++;
+        }
+    }
+    return count;
+}
+
+#endif // ERI_INDEX_H
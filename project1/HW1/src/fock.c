@@ -0,0 +1,97 @@
+// File: src/fock.c
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "fock.h"
+
+/**
+ * @brief Fills the closed-shell occupied density: D_pq = 1 if p == q < n_occ, else 0.
+ */
+void occupied_density(int mo_num, int n_occ, double* density) {
+    memset(density, 0, (size_t)mo_num * mo_num * sizeof(double));
+    for (int i = 0; i < n_occ; i++) {
+        density[(size_t)i * mo_num + i] = 1.0;
+    }
+}
+
+/**
+ * @brief Builds the MO Fock matrix F = h + 2J - K directly from the sparse integral list.
+ */
+int build_fock_matrix(const double* one_e_integrals,
+                       const eri_index* eri,
+                       const double* value,
+                       const double* density,
+                       int mo_num,
+                       double* fock) {
+    size_t nm2 = (size_t)mo_num * mo_num;
+    int64_t n_blocks = (eri->n_integrals + ERI_SEEK_BLOCK - 1) / ERI_SEEK_BLOCK;
+
+    int n_threads = 1;
+#ifdef _OPENMP
+    n_threads = omp_get_max_threads();
+#endif
+
+    // One private 2J - K accumulator per thread, zeroed (first-touched) by its owner
+    double* partial = (double*)malloc((size_t)n_threads * nm2 * sizeof(double));
+    if (!partial) {
+        fprintf(stderr, "Memory allocation failed for Fock matrix accumulators.\n");
+        errno = ENOMEM;
+        return -1;
+    }
+
+    #pragma omp parallel num_threads(n_threads)
+    {
+        int tid = 0;
+#ifdef _OPENMP
+        tid = omp_get_thread_num();
+#endif
+        double* g = partial + (size_t)tid * nm2;
+        memset(g, 0, nm2 * sizeof(double));
+        int idx[4], perm[8][4];
+        eri_iter it;
+
+        #pragma omp barrier
+
+        // Blocks of ERI_SEEK_BLOCK integrals are the unit of work so delta streams can be split
+        #pragma omp for schedule(dynamic, 4)
+        for (int64_t block = 0; block < n_blocks; block++) {
+            int64_t first = block * ERI_SEEK_BLOCK;
+            int64_t last = first + ERI_SEEK_BLOCK < eri->n_integrals ?
+                           first + ERI_SEEK_BLOCK : eri->n_integrals;
+            eri_iter_seek(&it, eri, first);
+
+            for (int64_t n = first; n < last; n++) {
+                eri_iter_next(&it, idx);
+                double v = value[n];
+                int count = eri_unique_permutations(idx, perm);
+
+                // Each distinct <ab|cd> adds 2 D_bd v to F_ac (Coulomb) and -D_bc v to F_ad (exchange)
+                for (int p = 0; p < count; p++) {
+                    size_t a = (size_t)perm[p][0] * mo_num;
+                    size_t b = (size_t)perm[p][1] * mo_num;
+                    int c = perm[p][2], d = perm[p][3];
+                    g[a + c] += 2.0 * v * density[b + d];
+                    g[a + d] -= v * density[b + c];
+                }
+            }
+        }
+
+        // Reduce the private accumulators; every thread owns a disjoint slice of F
+        #pragma omp for schedule(static)
+        for (size_t pq = 0; pq < nm2; pq++) {
+            double sum = one_e_integrals[pq];
+            for (int t = 0; t < n_threads; t++) {
+                sum += partial[(size_t)t * nm2 + pq];
+            }
+            fock[pq] = sum;
+        }
+    }
+
+    free(partial);
+    return 0;
+}
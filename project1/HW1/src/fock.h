@@ -0,0 +1,43 @@
+// File: src/fock.h
+
+#ifndef FOCK_H
+#define FOCK_H
+
+#include "eri_index.h"
+
+/**
+ * @brief Fills the closed-shell occupied density: D_pq = 1 if p == q < n_occ, else 0.
+ *
+ * @param mo_num Number of molecular orbitals.
+ * @param n_occ Number of occupied orbitals.
+ * @param density Array of mo_num^2 doubles to fill.
+ */
+void occupied_density(int mo_num, int n_occ, double* density);
+
+/**
+ * @brief Builds the MO Fock matrix F = h + 2J - K directly from the sparse integral list.
+ *
+ * F_pq = h_pq + sum_rs D_rs (2 <pr|qs> - <pr|sq>)
+ *
+ * The sparse list is treated as a symmetric pair-indexed supermatrix: every stored
+ * integral is expanded into its distinct permutations and contracted with D in a
+ * single pass, so the cost scales with n_integrals rather than mo_num^4. The list
+ * is split across OpenMP threads, each accumulating into a private copy of F that
+ * is reduced at the end, so no two threads ever write the same element.
+ *
+ * @param one_e_integrals Core Hamiltonian (mo_num^2).
+ * @param eri Compact indices of the non-zero two-electron integrals.
+ * @param value Values array for two-electron integrals.
+ * @param density Density matrix D in the MO basis (mo_num^2).
+ * @param mo_num Number of molecular orbitals.
+ * @param fock Output Fock matrix (mo_num^2).
+ * @return 0 on success, -1 (with a message, errno = ENOMEM) if the accumulators cannot be allocated.
+ */
+int build_fock_matrix(const double* one_e_integrals,
+                       const eri_index* eri,
+                       const double* value,
+                       const double* density,
+                       int mo_num,
+                       double* fock);
+
+#endif // FOCK_H
@@ -1,13 +1,12 @@
 // File: src/hf_energy.c
 
+#include <errno.h>
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <trexio.h>
 #include "hf_energy.h"
-
-// Macro for 4D indexing into a flattened 4D array
-#define MO_TEI(i,j,k,l, arr, mo_num) \
-    (arr[ (((size_t)(i)*(mo_num) + (j))*(mo_num) + (k))*(mo_num) + (l) ])
+#include "fock.h"
 
 /**
  * @brief Reads the nuclear repulsion energy from a TREXIO file.
@@ -66,52 +65,72 @@ double* read_one_electron_integrals(trexio_t* trexio_file, int mo_num) {
     return integrals;
 }
 
+// Number of integrals fetched from TREXIO per read call
+#define ERI_READ_CHUNK (1 << 20)
+
 /**
  * @brief Reads two-electron integrals in sparse format from a TREXIO file.
  */
 void read_two_electron_integrals(trexio_t* trexio_file,
-                                 int64_t* n_integrals,
-                                 int32_t** index,
+                                 int mo_num,
+                                 eri_index* eri,
                                  double** value) {
     trexio_exit_code rc;
+    int64_t n_integrals = 0;
 
     // Read the number of non-zero two-electron integrals
-    rc = trexio_read_mo_2e_int_eri_size(trexio_file, n_integrals);
+    rc = trexio_read_mo_2e_int_eri_size(trexio_file, &n_integrals);
     if (rc != TREXIO_SUCCESS) {
         fprintf(stderr, "TREXIO Error reading number of two-electron integrals: %s\n",
                 trexio_string_of_error(rc));
         exit(EXIT_FAILURE);
     }
 
-    // Allocate memory for indices and values
-    *index = (int32_t*)malloc(4 * (*n_integrals) * sizeof(int32_t));
-    if (!(*index)) {
-        fprintf(stderr, "Memory allocation failed for two-electron integrals indices.\n");
-        exit(EXIT_FAILURE);
-    }
+    // Allocate memory for packed indices, values and one chunk of raw indices
+    eri_index_init(eri, mo_num, n_integrals);
 
-    *value = (double*)malloc((*n_integrals) * sizeof(double));
+    *value = (double*)malloc((n_integrals + 1) * sizeof(double));
     if (!(*value)) {
         fprintf(stderr, "Memory allocation failed for two-electron integrals values.\n");
-        free(*index);
+        free_eri_index(eri);
         exit(EXIT_FAILURE);
     }
 
-    // Read the two-electron integrals
-    int64_t buffer_size = *n_integrals;
-    rc = trexio_read_mo_2e_int_eri(trexio_file, 0, &buffer_size, *index, *value);
-    if (rc != TREXIO_SUCCESS) {
-        fprintf(stderr, "TREXIO Error reading two-electron integrals: %s\n",
-                trexio_string_of_error(rc));
-        free(*index);
+    int64_t chunk = n_integrals < ERI_READ_CHUNK ? n_integrals : ERI_READ_CHUNK;
+    int32_t* chunk_index = (int32_t*)malloc((4 * chunk + 1) * sizeof(int32_t));
+    if (!chunk_index) {
+        fprintf(stderr, "Memory allocation failed for two-electron integrals indices.\n");
+        free_eri_index(eri);
         free(*value);
         exit(EXIT_FAILURE);
     }
 
+    // Read the two-electron integrals chunk by chunk and pack their indices
+    int64_t offset = 0;
+    while (offset < n_integrals) {
+        int64_t buffer_size = n_integrals - offset < chunk ? n_integrals - offset : chunk;
+        rc = trexio_read_mo_2e_int_eri(trexio_file, offset, &buffer_size,
+                                       chunk_index, *value + offset);
+        if (rc != TREXIO_SUCCESS && rc != TREXIO_END) {
+            fprintf(stderr, "TREXIO Error reading two-electron integrals: %s\n",
+                    trexio_string_of_error(rc));
+            free(chunk_index);
+            free_eri_index(eri);
+            free(*value);
+            exit(EXIT_FAILURE);
+        }
+        if (buffer_size <= 0) {
+            break;
+        }
+        eri_index_pack(eri, offset, buffer_size, chunk_index);
+        offset += buffer_size;
+    }
+    free(chunk_index);
+
     // Verify that all integrals were read
-    if (buffer_size != *n_integrals) {
+    if (offset != n_integrals) {
         fprintf(stderr, "Mismatch in the number of two-electron integrals read.\n");
-        free(*index);
+        free_eri_index(eri);
         free(*value);
         exit(EXIT_FAILURE);
     }
@@ -137,60 +156,38 @@ trexio_exit_code read_mo_energies(trexio_t* trexio_file,
  */
 double compute_HF_energy(double E_NN,
                          double* one_e_integrals,
-                         int64_t n_integrals,
-                         int32_t* index,
+                         const eri_index* eri,
                          double* value,
                          int mo_num,
                          int n_occ) {
     double hf_energy = E_NN; // Start with nuclear repulsion energy
 
-    // Add kinetic and electron-nucleus potential terms: 2 * sum_{i in occ} h_{ii}
-    double sum_one_e = 0.0;
-    for (int i = 0; i < n_occ; i++) {
-        sum_one_e += 2.0 * one_e_integrals[i * mo_num + i];
+    // E(HF) = E_NN + sum_{i in occ} (h_ii + F_ii), with F built from the sparse list
+    size_t nm2 = (size_t)mo_num * mo_num;
+    double* density = (double*)malloc(nm2 * sizeof(double));
+    double* fock = (double*)malloc(nm2 * sizeof(double));
+    if (!density || !fock) {
+        fprintf(stderr, "Memory allocation failed for the HF Fock matrix.\n");
+        free(density);
+        free(fock);
+        errno = ENOMEM;
+        return NAN;
     }
-    hf_energy += sum_one_e;
-
-    // Allocate memory for full two-electron integrals (MO TEI) using 8-fold symmetry
-    size_t total_size = (size_t)mo_num * mo_num * mo_num * mo_num;
-    double* mo_tei = (double*)calloc(total_size, sizeof(double));
-    if (!mo_tei) {
-        fprintf(stderr, "Memory allocation failed for MO two-electron integrals.\n");
-        exit(EXIT_FAILURE);
-    }
-
-    // Populate the MO TEI array using the sparse integrals and symmetry
-    for (int64_t n = 0; n < n_integrals; n++) {
-        int i = index[4 * n + 0];
-        int j = index[4 * n + 1];
-        int k = index[4 * n + 2];
-        int l = index[4 * n + 3];
-        double val = value[n];
-
-        // Applying 8-fold permutational symmetry
-        MO_TEI(i, j, k, l, mo_tei, mo_num) = val;
-        MO_TEI(i, l, k, j, mo_tei, mo_num) = val;
-        MO_TEI(k, l, i, j, mo_tei, mo_num) = val;
-        MO_TEI(k, j, i, l, mo_tei, mo_num) = val;
-        MO_TEI(j, i, l, k, mo_tei, mo_num) = val;
-        MO_TEI(l, i, j, k, mo_tei, mo_num) = val;
-        MO_TEI(l, k, j, i, mo_tei, mo_num) = val;
-        MO_TEI(j, k, l, i, mo_tei, mo_num) = val;
+    occupied_density(mo_num, n_occ, density);
+    if (build_fock_matrix(one_e_integrals, eri, value, density, mo_num, fock) != 0) {
+        free(density);
+        free(fock);
+        errno = ENOMEM;
+        return NAN;
     }
 
-    // Add two-electron integrals: sum_{i,j in occ} [2 <ij|ij> - <ij|ji>]
-    double sum_two_e = 0.0;
     for (int i = 0; i < n_occ; i++) {
-        for (int j = 0; j < n_occ; j++) {
-            double coulomb = MO_TEI(i, j, i, j, mo_tei, mo_num);
-            double exchange = MO_TEI(i, j, j, i, mo_tei, mo_num);
-            sum_two_e += (2.0 * coulomb - exchange);
-        }
+        hf_energy += one_e_integrals[i * mo_num + i] + fock[i * mo_num + i];
     }
-    hf_energy += sum_two_e;
 
     // Free allocated memory
-    free(mo_tei);
+    free(density);
+    free(fock);
 
     return hf_energy;
 }
@@ -4,6 +4,7 @@
 #define HF_ENERGY_H
 
 #include <trexio.h>
+#include "eri_index.h"
 
 /**
  * @brief Reads the nuclear repulsion energy from a TREXIO file.
@@ -37,16 +38,19 @@ double* read_one_electron_integrals(trexio_t* trexio_file, int mo_num);
 /**
  * @brief Reads two-electron integrals in sparse format from a TREXIO file.
  *
- * The integrals are stored in two arrays: index[] (contains indices) and value[] (contains integral values).
+ * The integrals are stored in two arrays: the compact index (orbital quadruplets,
+ * packed to the narrowest width for mo_num) and value[] (contains integral values).
+ * The file is read in chunks so that the int32 indices returned by TREXIO never
+ * exist in full.
  *
  * @param trexio_file Pointer to an open TREXIO file.
- * @param n_integrals Pointer to store the number of non-zero integrals.
- * @param index Double pointer to store the indices array.
+ * @param mo_num Number of molecular orbitals.
+ * @param eri Index to fill; its n_integrals holds the number of non-zero integrals.
  * @param value Double pointer to store the values array.
  */
 void read_two_electron_integrals(trexio_t* trexio_file,
-                                 int64_t* n_integrals,
-                                 int32_t** index,
+                                 int mo_num,
+                                 eri_index* eri,
                                  double** value);
 
 /**
@@ -69,19 +73,20 @@ trexio_exit_code read_mo_energies(trexio_t* trexio_file,
  * The formula used:
  * E(HF) = E_NN + 2 * sum_{i in occ} h_{ii} + sum_{i,j in occ} [2 <ij|ij> - <ij|ji>]
  *
+ * evaluated as E_NN + sum_{i in occ} (h_{ii} + F_{ii}) from the sparse Fock build.
+ *
  * @param E_NN Nuclear repulsion energy.
  * @param one_e_integrals Array of one-electron integrals.
- * @param n_integrals Number of non-zero two-electron integrals.
- * @param index Indices array for two-electron integrals.
+ * @param eri Compact indices of the non-zero two-electron integrals.
  * @param value Values array for two-electron integrals.
  * @param mo_num Number of molecular orbitals.
  * @param n_occ Number of occupied orbitals.
- * @return Computed Hartree-Fock energy as a double.
+ * @return Computed Hartree-Fock energy as a double, or NAN (with a message, errno = ENOMEM)
+ *         if the Fock matrix cannot be allocated.
  */
 double compute_HF_energy(double E_NN,
                          double* one_e_integrals,
-                         int64_t n_integrals,
-                         int32_t* index,
+                         const eri_index* eri,
                          double* value,
                          int mo_num,
                          int n_occ);
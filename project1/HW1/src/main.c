@@ -2,19 +2,135 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
 #include <trexio.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "fock.h"
 #include "hf_energy.h"
 #include "mp2_energy.h"
+#include "mp2_noncanonical.h"
+#include "mp2_ooc.h"
+#include "numa_util.h"
+
+/**
+ * @brief Prints the command-line usage.
+ */
+static void print_usage(const char* prog) {
+    fprintf(stderr, "Usage: %s [options] <trexio_file>\n", prog);
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  --mem-budget <size>   Run MP2 out of core within <size> bytes (K/M/G suffix allowed)\n");
+    fprintf(stderr, "  --scratch-dir <dir>   Directory for MP2 spill files (default: $TMPDIR or /tmp)\n");
+    fprintf(stderr, "  --eri-delta           Store integral indices as sorted, delta-encoded keys (mo_num <= 65535)\n");
+    fprintf(stderr, "  --timings             Print the wall time of each phase\n");
+    fprintf(stderr, "  --threads <n>         Number of OpenMP threads (default: OMP_NUM_THREADS)\n");
+    fprintf(stderr, "  --bind <policy>       Pin threads: none, compact or scatter over NUMA nodes (default: none)\n");
+    fprintf(stderr, "  --numa-report         Print the NUMA node placement of the large integral arrays\n");
+    fprintf(stderr, "  --fock-check          Build the full Fock matrix and check it against the orbitals\n");
+    fprintf(stderr, "  --noncanonical        Run MP2 with the full Fock matrix instead of the orbital energies\n");
+    fprintf(stderr, "  --checkpoint <file>   Periodically save finished MP2 pairs to <file>\n");
+    fprintf(stderr, "  --checkpoint-interval <s>  Seconds between MP2 checkpoints (default: 60)\n");
+    fprintf(stderr, "  --resume              Skip the MP2 pairs already saved in the checkpoint file\n");
+}
+
+/**
+ * @brief Returns a monotonic wall-clock time in seconds.
+ */
+static double wall_time(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + 1e-9 * (double)ts.tv_nsec;
+}
 
 int main(int argc, char* argv[]) {
-    // Check for correct usage
-    if (argc != 2) {
-        fprintf(stderr, "Usage: %s <trexio_file>\n", argv[0]);
+    // Parse command-line options
+    const char* filename = NULL;
+    mp2_ooc_config ooc = { 0, NULL };
+    int eri_delta = 0;
+    int timings = 0;
+    int fock_check = 0;
+    int noncanonical = 0;
+    bind_policy bind = BIND_NONE;
+    const char* checkpoint = NULL;
+    double checkpoint_interval = 60.0;
+    int resume = 0;
+    for (int arg = 1; arg < argc; arg++) {
+        if (strcmp(argv[arg], "--mem-budget") == 0 && arg + 1 < argc) {
+            ooc.mem_budget = parse_memory_size(argv[++arg]);
+            if (ooc.mem_budget == 0) {
+                fprintf(stderr, "Invalid memory budget '%s'.\n", argv[arg]);
+                return EXIT_FAILURE;
+            }
+        } else if (strcmp(argv[arg], "--scratch-dir") == 0 && arg + 1 < argc) {
+            ooc.scratch_dir = argv[++arg];
+        } else if (strcmp(argv[arg], "--eri-delta") == 0) {
+            eri_delta = 1;
+        } else if (strcmp(argv[arg], "--timings") == 0) {
+            timings = 1;
+        } else if (strcmp(argv[arg], "--threads") == 0 && arg + 1 < argc) {
+            int n_threads = atoi(argv[++arg]);
+            if (n_threads < 1) {
+                fprintf(stderr, "Invalid thread count '%s'.\n", argv[arg]);
+                return EXIT_FAILURE;
+            }
+#ifdef _OPENMP
+            omp_set_num_threads(n_threads);
+#endif
+        } else if (strcmp(argv[arg], "--bind") == 0 && arg + 1 < argc) {
+            if (parse_bind_policy(argv[++arg], &bind) != 0) {
+                fprintf(stderr, "Invalid binding policy '%s'.\n", argv[arg]);
+                return EXIT_FAILURE;
+            }
+        } else if (strcmp(argv[arg], "--numa-report") == 0) {
+            numa_set_report(1);
+            printf("NUMA nodes online = %d\n", numa_node_count());
+        } else if (strcmp(argv[arg], "--fock-check") == 0) {
+            fock_check = 1;
+        } else if (strcmp(argv[arg], "--noncanonical") == 0) {
+            noncanonical = 1;
+        } else if (strcmp(argv[arg], "--checkpoint") == 0 && arg + 1 < argc) {
+            checkpoint = argv[++arg];
+        } else if (strcmp(argv[arg], "--checkpoint-interval") == 0 && arg + 1 < argc) {
+            char* end;
+            checkpoint_interval = strtod(argv[++arg], &end);
+            if (*end != '\0' || checkpoint_interval < 0.0) {
+                fprintf(stderr, "Invalid checkpoint interval '%s'.\n", argv[arg]);
+                return EXIT_FAILURE;
+            }
+        } else if (strcmp(argv[arg], "--resume") == 0) {
+            resume = 1;
+        } else if (argv[arg][0] != '-' && filename == NULL) {
+            filename = argv[arg];
+        } else {
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (filename == NULL) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (resume && checkpoint == NULL) {
+        fprintf(stderr, "--resume requires --checkpoint <file>.\n");
         return EXIT_FAILURE;
     }
+    if (noncanonical && (ooc.mem_budget > 0 || checkpoint != NULL)) {
+        fprintf(stderr, "--noncanonical cannot be combined with --mem-budget or --checkpoint.\n");
+        return EXIT_FAILURE;
+    }
+    if (ooc.scratch_dir == NULL) {
+        ooc.scratch_dir = getenv("TMPDIR") ? getenv("TMPDIR") : "/tmp";
+    }
+    pin_threads(bind);
+
+    // Wall time spent in reading, HF and MP2
+    double t_read = 0.0, t_hf = 0.0, t_mp2 = 0.0;
+    double t_start = wall_time();
 
     // 1. Open TREXIO file
-    const char* filename = argv[1];
     trexio_exit_code rc;
     trexio_t* trexio_file = trexio_open(filename, 'r', TREXIO_AUTO, &rc);
     if (rc != TREXIO_SUCCESS) {
@@ -45,29 +161,40 @@ int main(int argc, char* argv[]) {
     double* one_e_integrals = read_one_electron_integrals(trexio_file, mo_num);
 
     // 6. Read two-electron integrals
-    int64_t n_integrals;
-    int32_t* index;
+    eri_index eri;
     double* value;
-    read_two_electron_integrals(trexio_file, &n_integrals, &index, &value);
-    printf("Number of non-zero two-electron integrals = %ld\n", (long)n_integrals);
+    read_two_electron_integrals(trexio_file, mo_num, &eri, &value);
+    if (eri_delta) {
+        eri_index_encode_deltas(&eri, value);
+    }
+    printf("Number of non-zero two-electron integrals = %ld\n", (long)eri.n_integrals);
+    printf("Two-electron integral index storage = %zu bytes\n", eri_index_bytes(&eri));
+
+    t_read += wall_time() - t_start;
 
     // 7. Compute Hartree-Fock energy
+    t_start = wall_time();
     double hf_energy = compute_HF_energy(E_NN,
                                          one_e_integrals,
-                                         n_integrals,
-                                         index,
+                                         &eri,
                                          value,
                                          mo_num,
                                          n_occ);
+    if (isnan(hf_energy)) {
+        return EXIT_FAILURE;
+    }
+    t_hf += wall_time() - t_start;
     printf("Computed Hartree-Fock energy (E_HF) = %.8f atomic units\n", hf_energy);
 
+    t_start = wall_time();
+
     // 8. Read molecular orbital energies
     double* mo_energy = (double*)malloc(mo_num * sizeof(double));
     if (!mo_energy) {
         fprintf(stderr, "Memory allocation failed for molecular orbital energies.\n");
         // Free previously allocated memory before exiting
         free(one_e_integrals);
-        free(index);
+        free_eri_index(&eri);
         free(value);
         trexio_close(trexio_file);
         return EXIT_FAILURE;
@@ -76,29 +203,105 @@ int main(int argc, char* argv[]) {
     if (rc != TREXIO_SUCCESS) {
         trexio_close(trexio_file);
         free(one_e_integrals);
-        free(index);
+        free_eri_index(&eri);
         free(value);
         free(mo_energy);
         return EXIT_FAILURE;
     }
 
-    // 9. Compute MP2 correlation energy
-    double mp2_energy = compute_MP2_energy(mo_energy,
-                                           mo_num,
-                                           n_occ,
-                                           n_integrals,
-                                           index,
-                                           value);
+    t_read += wall_time() - t_start;
+
+    // The full Fock matrix, for the consistency check and for non-canonical MP2
+    double* fock = NULL;
+    if (fock_check || noncanonical) {
+        t_start = wall_time();
+        size_t nm2 = (size_t)mo_num * mo_num;
+        double* density = (double*)malloc(nm2 * sizeof(double));
+        fock = (double*)malloc(nm2 * sizeof(double));
+        if (!density || !fock) {
+            fprintf(stderr, "Memory allocation failed for the Fock matrix.\n");
+            return EXIT_FAILURE;
+        }
+        occupied_density(mo_num, n_occ, density);
+        if (build_fock_matrix(one_e_integrals, &eri, value, density, mo_num, fock) != 0) {
+            return EXIT_FAILURE;
+        }
+        free(density);
+        t_hf += wall_time() - t_start;
+    }
+
+    // Optional consistency check: F should be diagonal with the orbital energies on its diagonal
+    if (fock_check) {
+
+        double max_diag = 0.0, max_ov = 0.0;
+        for (int p = 0; p < mo_num; p++) {
+            double d = fabs(fock[(size_t)p * mo_num + p] - mo_energy[p]);
+            max_diag = d > max_diag ? d : max_diag;
+        }
+        for (int i = 0; i < n_occ; i++) {
+            for (int a = n_occ; a < mo_num; a++) {
+                double f = fabs(fock[(size_t)i * mo_num + a]);
+                max_ov = f > max_ov ? f : max_ov;
+            }
+        }
+        printf("Max |F_pp - e_p| = %.3e atomic units\n", max_diag);
+        printf("Max |F_ia| (occupied-virtual) = %.3e atomic units\n", max_ov);
+    }
+
+    // 9. Compute MP2 correlation energy, out of core when a memory budget is given.
+    //    Finished pairs are checkpointed so that a preempted run can be resumed.
+    t_start = wall_time();
+    mp2_checkpoint ck;
+    if (mp2_checkpoint_open(&ck, checkpoint, checkpoint_interval, resume,
+                            mo_energy, mo_num, n_occ, eri.n_integrals) != 0) {
+        return EXIT_FAILURE;
+    }
+    double mp2_energy;
+    if (noncanonical) {
+        int n_iter;
+        mp2_energy = compute_MP2_energy_noncanonical(fock, mo_num, n_occ, &eri, value, &n_iter);
+        if (isnan(mp2_energy)) {
+            return EXIT_FAILURE;
+        }
+        printf("Non-canonical MP2 amplitudes converged in %d sweeps\n", n_iter);
+    } else if (ooc.mem_budget > 0) {
+        mp2_energy = compute_MP2_energy_ooc(mo_energy,
+                                            mo_num,
+                                            n_occ,
+                                            &eri,
+                                            value,
+                                            &ooc,
+                                            &ck);
+    } else {
+        mp2_energy = compute_MP2_energy(mo_energy,
+                                        mo_num,
+                                        n_occ,
+                                        &eri,
+                                        value,
+                                        &ck);
+    }
+    mp2_checkpoint_close(&ck);
+    if (isnan(mp2_energy)) {
+        return EXIT_FAILURE;
+    }
+    t_mp2 += wall_time() - t_start;
     printf("Computed MP2 correlation energy (EMP2) = %.8f atomic units\n", mp2_energy);
 
     // 10. Print total MP2 energy (E_HF + EMP2)
     printf("Total MP2 energy (E_HF + EMP2) = %.8f atomic units\n", hf_energy + mp2_energy);
 
+    if (timings) {
+        printf("Phase time read = %.6f s\n", t_read);
+        printf("Phase time hf = %.6f s\n", t_hf);
+        printf("Phase time mp2 = %.6f s\n", t_mp2);
+    }
+
     // Cleanup: Free allocated memory and close TREXIO file
     free(one_e_integrals);
-    free(index);
+    free_eri_index(&eri);
     free(value);
     free(mo_energy);
+    free(fock);
 
     rc = trexio_close(trexio_file);
     if (rc != TREXIO_SUCCESS) {
@@ -0,0 +1,188 @@
+// File: src/mp2_checkpoint.c
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "mp2_checkpoint.h"
+
+static const char ckpt_magic[8] = { 'M', 'P', '2', 'C', 'K', 'P', 'T', '1' };
+
+static double ckpt_time(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + 1e-9 * (double)ts.tv_nsec;
+}
+
+/**
+ * @brief FNV-1a hash of the quantities that identify an MP2 run.
+ */
+static uint64_t input_signature(const double* mo_energy, int mo_num, int n_occ, int64_t n_integrals) {
+    uint64_t h = 1469598103934665603ULL;
+    const unsigned char* bytes[4] = { (const unsigned char*)&mo_num, (const unsigned char*)&n_occ,
+                                      (const unsigned char*)&n_integrals,
+                                      (const unsigned char*)mo_energy };
+    size_t sizes[4] = { sizeof(mo_num), sizeof(n_occ), sizeof(n_integrals),
+                        (size_t)mo_num * sizeof(double) };
+    for (int part = 0; part < 4; part++) {
+        for (size_t b = 0; b < sizes[part]; b++) {
+            h = (h ^ bytes[part][b]) * 1099511628211ULL;
+        }
+    }
+    return h;
+}
+
+/**
+ * @brief Writes the current state to <path>.tmp and atomically renames it over <path>.
+ */
+static void write_checkpoint(mp2_checkpoint* ck) {
+    size_t n_pairs = (size_t)ck->n_occ * ck->n_occ;
+    size_t len = strlen(ck->path);
+    char* tmp = (char*)malloc(len + 5);
+    if (!tmp) {
+        fprintf(stderr, "Memory allocation failed for checkpoint file name.\n");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(tmp, ck->path, len);
+    memcpy(tmp + len, ".tmp", 5);
+
+    FILE* file = fopen(tmp, "wb");
+    if (!file) {
+        fprintf(stderr, "Error creating MP2 checkpoint '%s': %s\n", tmp, strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    int32_t header[2] = { ck->mo_num, ck->n_occ };
+    int ok = fwrite(ckpt_magic, sizeof(ckpt_magic), 1, file) == 1 &&
+             fwrite(header, sizeof(header), 1, file) == 1 &&
+             fwrite(&ck->signature, sizeof(ck->signature), 1, file) == 1 &&
+             fwrite(ck->done, 1, n_pairs, file) == n_pairs &&
+             fwrite(ck->pair_energy, sizeof(double), n_pairs, file) == n_pairs &&
+             fflush(file) == 0 && fsync(fileno(file)) == 0;
+    if (fclose(file) != 0 || !ok || rename(tmp, ck->path) != 0) {
+        fprintf(stderr, "Error writing MP2 checkpoint '%s': %s\n", ck->path, strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+
+    free(tmp);
+    ck->last_write = ckpt_time();
+}
+
+/**
+ * @brief Loads <path> into the state; returns 0 if the file does not exist.
+ */
+static int read_checkpoint(mp2_checkpoint* ck) {
+    FILE* file = fopen(ck->path, "rb");
+    if (!file) {
+        return 0;
+    }
+
+    size_t n_pairs = (size_t)ck->n_occ * ck->n_occ;
+    char magic[8];
+    int32_t header[2];
+    uint64_t signature;
+    int ok = fread(magic, sizeof(magic), 1, file) == 1 &&
+             memcmp(magic, ckpt_magic, sizeof(magic)) == 0 &&
+             fread(header, sizeof(header), 1, file) == 1 &&
+             fread(&signature, sizeof(signature), 1, file) == 1;
+    if (!ok) {
+        fprintf(stderr, "'%s' is not an MP2 checkpoint.\n", ck->path);
+        exit(EXIT_FAILURE);
+    }
+    if (header[0] != ck->mo_num || header[1] != ck->n_occ || signature != ck->signature) {
+        fprintf(stderr, "MP2 checkpoint '%s' was written for a different input.\n", ck->path);
+        exit(EXIT_FAILURE);
+    }
+    if (fread(ck->done, 1, n_pairs, file) != n_pairs ||
+        fread(ck->pair_energy, sizeof(double), n_pairs, file) != n_pairs) {
+        fprintf(stderr, "MP2 checkpoint '%s' is truncated.\n", ck->path);
+        exit(EXIT_FAILURE);
+    }
+    fclose(file);
+
+    for (size_t p = 0; p < n_pairs; p++) {
+        ck->n_done += ck->done[p] ? 1 : 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief Sets up pair bookkeeping and, if requested, loads a previous checkpoint.
+ */
+int mp2_checkpoint_open(mp2_checkpoint* ck, const char* path, double interval, int resume,
+                         const double* mo_energy, int mo_num, int n_occ, int64_t n_integrals) {
+    size_t n_pairs = (size_t)n_occ * n_occ;
+    memset(ck, 0, sizeof(*ck));
+    ck->interval = interval;
+    ck->mo_num = mo_num;
+    ck->n_occ = n_occ;
+    ck->signature = input_signature(mo_energy, mo_num, n_occ, n_integrals);
+    ck->done = (unsigned char*)calloc(n_pairs + 1, 1);
+    ck->pair_energy = (double*)calloc(n_pairs + 1, sizeof(double));
+    if (!ck->done || !ck->pair_energy) {
+        fprintf(stderr, "Memory allocation failed for MP2 pair bookkeeping.\n");
+        free(ck->done);
+        free(ck->pair_energy);
+        memset(ck, 0, sizeof(*ck));
+        errno = ENOMEM;
+        return -1;
+    }
+
+    if (path != NULL) {
+        ck->path = strdup(path);
+        if (!ck->path) {
+            fprintf(stderr, "Memory allocation failed for checkpoint file name.\n");
+            exit(EXIT_FAILURE);
+        }
+        if (resume && read_checkpoint(ck)) {
+            printf("Resumed %ld of %ld MP2 pairs from checkpoint '%s'\n",
+                   (long)ck->n_done, (long)n_pairs, path);
+        }
+    }
+    ck->last_write = ckpt_time();
+    return 0;
+}
+
+/**
+ * @brief Records the energy of pair (i,j) and writes a checkpoint if the interval has passed.
+ */
+void mp2_checkpoint_record(mp2_checkpoint* ck, int i, int j, double pair_energy) {
+    int64_t p = (int64_t)i * ck->n_occ + j;
+
+    // One writer at a time, and a checkpoint never sees a half-recorded pair
+    #pragma omp critical(mp2_checkpoint)
+    {
+        ck->pair_energy[p] = pair_energy;
+        ck->done[p] = 1;
+        ck->n_done++;
+        if (ck->path != NULL && ckpt_time() - ck->last_write >= ck->interval) {
+            write_checkpoint(ck);
+        }
+    }
+}
+
+/**
+ * @brief Returns the MP2 energy accumulated over all pairs, summed in a fixed order.
+ */
+double mp2_checkpoint_total(const mp2_checkpoint* ck) {
+    double emp2 = 0.0;
+    int64_t n_pairs = (int64_t)ck->n_occ * ck->n_occ;
+    for (int64_t p = 0; p < n_pairs; p++) {
+        emp2 += ck->pair_energy[p];
+    }
+    return emp2;
+}
+
+/**
+ * @brief Writes a final checkpoint (if enabled) and releases the state.
+ */
+void mp2_checkpoint_close(mp2_checkpoint* ck) {
+    if (ck->path != NULL) {
+        write_checkpoint(ck);
+    }
+    free(ck->path);
+    free(ck->done);
+    free(ck->pair_energy);
+    memset(ck, 0, sizeof(*ck));
+}
@@ -0,0 +1,73 @@
+// File: src/mp2_checkpoint.h
+
+#ifndef MP2_CHECKPOINT_H
+#define MP2_CHECKPOINT_H
+
+#include <stdint.h>
+
+/**
+ * @brief Progress of an MP2 run: which occupied pairs (i,j) are done and their energies.
+ *
+ * The state is written periodically to a small binary file. Each write goes to
+ * "<path>.tmp", is flushed with fsync and is then renamed over <path>, so a
+ * preempted run leaves either the previous or the new checkpoint, never a torn
+ * one. A resumed run skips every pair marked done.
+ *
+ * File layout: "MP2CKPT1", int32 mo_num, int32 n_occ, uint64 input signature,
+ * n_occ^2 uint8 done flags, n_occ^2 double pair energies.
+ */
+typedef struct {
+    char* path;            // Checkpoint file, or NULL when checkpointing is disabled
+    double interval;       // Minimum seconds between two writes
+    double last_write;     // Wall time of the last write
+    int mo_num;
+    int n_occ;
+    uint64_t signature;    // Hash of the input, guards against resuming the wrong run
+    unsigned char* done;   // n_occ^2 flags
+    double* pair_energy;   // n_occ^2 pair contributions
+    int64_t n_done;        // Number of pairs flagged done
+} mp2_checkpoint;
+
+/**
+ * @brief Sets up pair bookkeeping and, if requested, loads a previous checkpoint.
+ *
+ * @param ck Checkpoint state to initialise.
+ * @param path Checkpoint file, or NULL to only keep the bookkeeping in memory.
+ * @param interval Minimum seconds between two writes (0 writes after every pair).
+ * @param resume Nonzero to load <path> if it exists.
+ * @param mo_energy Orbital energies (part of the input signature).
+ * @param mo_num Number of molecular orbitals.
+ * @param n_occ Number of occupied orbitals.
+ * @param n_integrals Number of two-electron integrals (part of the input signature).
+ * @return 0 on success, -1 (with a message, errno = ENOMEM) if the pair bookkeeping cannot be
+ *         allocated.
+ *         Checkpoint file errors end the program.
+ */
+int mp2_checkpoint_open(mp2_checkpoint* ck, const char* path, double interval, int resume,
+                         const double* mo_energy, int mo_num, int n_occ, int64_t n_integrals);
+
+/**
+ * @brief Returns nonzero if pair (i,j) is already done.
+ */
+static inline int mp2_checkpoint_done(const mp2_checkpoint* ck, int i, int j) {
+    return ck->done[(int64_t)i * ck->n_occ + j];
+}
+
+/**
+ * @brief Records the energy of pair (i,j) and writes a checkpoint if the interval has passed.
+ *
+ * Safe to call from OpenMP threads.
+ */
+void mp2_checkpoint_record(mp2_checkpoint* ck, int i, int j, double pair_energy);
+
+/**
+ * @brief Returns the MP2 energy accumulated over all pairs, summed in a fixed order.
+ */
+double mp2_checkpoint_total(const mp2_checkpoint* ck);
+
+/**
+ * @brief Writes a final checkpoint (if enabled) and releases the state.
+ */
+void mp2_checkpoint_close(mp2_checkpoint* ck);
+
+#endif // MP2_CHECKPOINT_H
@@ -1,12 +1,12 @@
 // File: src/mp2_energy.c
 
+#include <errno.h>
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include "mp2_energy.h"
-
-// Macro for 4D indexing into a flattened 4D array
-#define MO_TEI(i,j,k,l, arr, mo_num) \
-    (arr[ (((size_t)(i)*(mo_num) + (j))*(mo_num) + (k))*(mo_num) + (l) ])
+#include "numa_util.h"
+#include "tiled_oovv.h"
 
 /**
  * @brief Computes the MP2 correlation energy using the provided molecular orbital energies and two-electron integrals.
@@ -14,62 +14,52 @@
 double compute_MP2_energy(double* mo_energy,
                           int mo_num,
                           int n_occ,
-                          int64_t n_integrals,
-                          int32_t* index,
-                          double* value) {
-    // Allocate memory for full two-electron integrals (MO TEI) using 8-fold symmetry
-    size_t total_size = (size_t)mo_num * mo_num * mo_num * mo_num;
-    double* mo_tei = (double*)calloc(total_size, sizeof(double));
-    if (!mo_tei) {
-        fprintf(stderr, "Memory allocation failed for MO two-electron integrals in MP2.\n");
-        exit(EXIT_FAILURE);
+                          const eri_index* eri,
+                          double* value,
+                          mp2_checkpoint* ck) {
+    int n_virt = mo_num - n_occ;
+    if (n_occ <= 0 || n_virt <= 0) {
+        return 0.0;
     }
 
-    // Populate the MO TEI array using the sparse integrals and symmetry
-    for (int64_t n = 0; n < n_integrals; n++) {
-        int i = index[4 * n + 0];
-        int j = index[4 * n + 1];
-        int k = index[4 * n + 2];
-        int l = index[4 * n + 3];
-        double val = value[n];
-
-        // Applying 8-fold permutational symmetry
-        MO_TEI(i, j, k, l, mo_tei, mo_num) = val;
-        MO_TEI(i, l, k, j, mo_tei, mo_num) = val;
-        MO_TEI(k, l, i, j, mo_tei, mo_num) = val;
-        MO_TEI(k, j, i, l, mo_tei, mo_num) = val;
-        MO_TEI(j, i, l, k, mo_tei, mo_num) = val;
-        MO_TEI(l, i, j, k, mo_tei, mo_num) = val;
-        MO_TEI(l, k, j, i, mo_tei, mo_num) = val;
-        MO_TEI(j, k, l, i, mo_tei, mo_num) = val;
+    // Only the <ij|ab> block is needed; keep it in a cache-tiled layout
+    tiled_oovv oovv;
+    if (tiled_oovv_init(&oovv, n_occ, n_virt) != 0) {
+        return NAN;
     }
+    tiled_oovv_fill(&oovv, eri, value);
+    numa_report("MP2 (oo|vv) block", oovv.data,
+                (size_t)n_occ * n_occ * oovv.pair_stride * sizeof(double));
 
-    double emp2 = 0.0; // Initialize MP2 energy
-
-    // Loop over occupied orbitals
-    for (int i = 0; i < n_occ; i++) {
-        for (int j = 0; j < n_occ; j++) {
-            // Loop over virtual (unoccupied) orbitals
-            for (int a = n_occ; a < mo_num; a++) {
-                for (int b = n_occ; b < mo_num; b++) {
-                    // Energy denominator: e_i + e_j - e_a - e_b
-                    double denom = (mo_energy[i] + mo_energy[j]) - (mo_energy[a] + mo_energy[b]);
-
-                    // Two-electron integrals: <ij|ab> and <ij|ba>
-                    double ijab = MO_TEI(i, j, a, b, mo_tei, mo_num);
-                    double ijba = MO_TEI(i, j, b, a, mo_tei, mo_num);
+    // Pair energies are kept per (i,j) so that a checkpoint can record finished pairs
+    mp2_checkpoint local;
+    if (ck == NULL) {
+        if (mp2_checkpoint_open(&local, NULL, 0.0, 0, mo_energy, mo_num, n_occ, eri->n_integrals) != 0) {
+            free_tiled_oovv(&oovv);
+            errno = ENOMEM;
+            return NAN;
+        }
+        ck = &local;
+    }
 
-                    // Contribution to MP2 energy
-                    double numerator = ijab * (2.0 * ijab - ijba);
-                    emp2 += (numerator / denom);
-                }
-            }
+    // Loop over occupied pairs; each pair walks its (a,b) tiles unit-stride.
+    // The static schedule matches the first-touch initialisation in tiled_oovv_init.
+    int n_pairs = n_occ * n_occ;
+    #pragma omp parallel for schedule(static)
+    for (int ij = 0; ij < n_pairs; ij++) {
+        int i = ij / n_occ;
+        int j = ij % n_occ;
+        if (!mp2_checkpoint_done(ck, i, j)) {
+            mp2_checkpoint_record(ck, i, j, tiled_oovv_pair_energy(&oovv, mo_energy, i, j));
         }
     }
+    double emp2 = mp2_checkpoint_total(ck);
 
     // Free allocated memory
-    free(mo_tei);
+    free_tiled_oovv(&oovv);
+    if (ck == &local) {
+        mp2_checkpoint_close(&local);
+    }
 
     return emp2;
 }
-
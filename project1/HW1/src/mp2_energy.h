@@ -1,7 +1,32 @@
+
 #ifndef MP2_ENERGY_H
 #define MP2_ENERGY_H
 
-double compute_MP2_energy(/* arguments needed, e.g. Fock eigenvalues, integrals, etc. */);
+#include <stdint.h>
+#include "eri_index.h"
+#include "mp2_checkpoint.h"
 
-#endif // MP2_ENERGY_H
+/**
+ * @brief Computes the MP2 correlation energy from the sparse two-electron integrals.
+ *
+ * The formula used:
+ * E(MP2) = sum_{ij in occ} sum_{ab in virt} <ij|ab> (2 <ij|ab> - <ij|ba>) / (e_i + e_j - e_a - e_b)
+ *
+ * @param mo_energy Array of molecular orbital energies (length mo_num).
+ * @param mo_num Number of molecular orbitals.
+ * @param n_occ Number of occupied orbitals.
+ * @param eri Compact indices of the non-zero two-electron integrals.
+ * @param value Values array for two-electron integrals.
+ * @param ck Pair bookkeeping from mp2_checkpoint_open; pairs already done are skipped.
+ *           NULL runs every pair without checkpoints.
+ * @return MP2 correlation energy as a double, or NAN (with a message, errno = ENOMEM) if
+ *         the working storage cannot be allocated.
+ */
+double compute_MP2_energy(double* mo_energy,
+                          int mo_num,
+                          int n_occ,
+                          const eri_index* eri,
+                          double* value,
+                          mp2_checkpoint* ck);
 
+#endif // MP2_ENERGY_H
@@ -0,0 +1,172 @@
+// File: src/mp2_noncanonical.c
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "mp2_noncanonical.h"
+#include "tiled_oovv.h"
+
+/**
+ * @brief Computes the MP2 correlation energy with a Fock matrix that need not be diagonal.
+ */
+double compute_MP2_energy_noncanonical(const double* fock,
+                                       int mo_num,
+                                       int n_occ,
+                                       const eri_index* eri,
+                                       const double* value,
+                                       int* n_iter) {
+    int n_virt = mo_num - n_occ;
+    if (n_iter) {
+        *n_iter = 0;
+    }
+    if (n_occ <= 0 || n_virt <= 0) {
+        return 0.0;
+    }
+
+    // <ij|ab>, the amplitudes and the residual, each as n_occ^2 dense n_virt x n_virt blocks
+    int n_pairs = n_occ * n_occ;
+    size_t vv = (size_t)n_virt * n_virt;
+    size_t total = (size_t)n_pairs * vv;
+    double* k = (double*)malloc(total * sizeof(double));
+    double* t = (double*)malloc(total * sizeof(double));
+    double* r = (double*)malloc(total * sizeof(double));
+    tiled_oovv oovv;
+    if (!k || !t || !r || tiled_oovv_init(&oovv, n_occ, n_virt) != 0) {
+        if (!k || !t || !r) {
+            fprintf(stderr, "Memory allocation failed for non-canonical MP2 amplitudes.\n");
+        }
+        free(k);
+        free(t);
+        free(r);
+        return NAN;
+    }
+    tiled_oovv_fill(&oovv, eri, value);
+    #pragma omp parallel for schedule(static)
+    for (int ij = 0; ij < n_pairs; ij++) {
+        int i = ij / n_occ, j = ij % n_occ;
+        double* kij = k + (size_t)ij * vv;
+        for (int a = 0; a < n_virt; a++) {
+            for (int b = 0; b < n_virt; b++) {
+                kij[(size_t)a * n_virt + b] = oovv.data[tiled_oovv_offset(&oovv, i, j, a, b)];
+            }
+        }
+    }
+    free_tiled_oovv(&oovv);
+
+    // Fock matrix element F_pq, with virtual indices counted from the first virtual orbital
+    #define F_OO(p, q) fock[(size_t)(p) * mo_num + (q)]
+    #define F_VV(p, q) fock[(size_t)((p) + n_occ) * mo_num + (q) + n_occ]
+
+    // Canonical guess: T_ij^ab = <ij|ab> / (F_ii + F_jj - F_aa - F_bb)
+    #pragma omp parallel for schedule(static)
+    for (int ij = 0; ij < n_pairs; ij++) {
+        int i = ij / n_occ, j = ij % n_occ;
+        for (int a = 0; a < n_virt; a++) {
+            for (int b = 0; b < n_virt; b++) {
+                size_t n = (size_t)ij * vv + (size_t)a * n_virt + b;
+                t[n] = k[n] / (F_OO(i, i) + F_OO(j, j) - F_VV(a, a) - F_VV(b, b));
+            }
+        }
+    }
+
+    // Jacobi sweeps: every residual is built from the previous amplitudes, then all are updated.
+    // Each pair writes only its own block of r, so the pair loop needs no synchronisation.
+    int iter = 0;
+    double max_residual = INFINITY, previous;
+    do {
+        iter++;
+        previous = max_residual;
+        max_residual = 0.0;
+        #pragma omp parallel for schedule(static) reduction(max:max_residual)
+        for (int ij = 0; ij < n_pairs; ij++) {
+            int i = ij / n_occ, j = ij % n_occ;
+            const double* tij = t + (size_t)ij * vv;
+            double* rij = r + (size_t)ij * vv;
+            for (size_t n = 0; n < vv; n++) {
+                rij[n] = k[(size_t)ij * vv + n];
+            }
+
+            // Virtual-virtual coupling: F_vv T_ij + T_ij F_vv (F is symmetric)
+            for (int a = 0; a < n_virt; a++) {
+                for (int c = 0; c < n_virt; c++) {
+                    double fac = F_VV(a, c);
+                    const double* tc = tij + (size_t)c * n_virt;
+                    double* ra = rij + (size_t)a * n_virt;
+                    for (int b = 0; b < n_virt; b++) {
+                        ra[b] += fac * tc[b];
+                    }
+                }
+                const double* ta = tij + (size_t)a * n_virt;
+                double* ra = rij + (size_t)a * n_virt;
+                for (int b = 0; b < n_virt; b++) {
+                    double sum = 0.0;
+                    for (int c = 0; c < n_virt; c++) {
+                        sum += ta[c] * F_VV(b, c);
+                    }
+                    ra[b] += sum;
+                }
+            }
+
+            // Occupied-occupied coupling: - sum_k (F_ik T_kj + F_jk T_ik)
+            for (int kk = 0; kk < n_occ; kk++) {
+                double fik = F_OO(i, kk), fjk = F_OO(j, kk);
+                const double* tkj = t + ((size_t)kk * n_occ + j) * vv;
+                const double* tik = t + ((size_t)i * n_occ + kk) * vv;
+                for (size_t n = 0; n < vv; n++) {
+                    rij[n] -= fik * tkj[n] + fjk * tik[n];
+                }
+            }
+
+            for (size_t n = 0; n < vv; n++) {
+                double d = fabs(rij[n]);
+                max_residual = d > max_residual ? d : max_residual;
+            }
+        }
+
+        #pragma omp parallel for schedule(static)
+        for (int ij = 0; ij < n_pairs; ij++) {
+            int i = ij / n_occ, j = ij % n_occ;
+            for (int a = 0; a < n_virt; a++) {
+                for (int b = 0; b < n_virt; b++) {
+                    size_t n = (size_t)ij * vv + (size_t)a * n_virt + b;
+                    t[n] += r[n] / (F_OO(i, i) + F_OO(j, j) - F_VV(a, a) - F_VV(b, b));
+                }
+            }
+        }
+    } while (max_residual > MP2_NONCANONICAL_TOL && max_residual < previous && iter < MP2_NONCANONICAL_MAX_ITER);
+    #undef F_OO
+    #undef F_VV
+
+    // Jacobi sweeps diverge (the residual grows) when F is far from diagonal, e.g. for orbitals
+    // that are not self-consistent with the integrals; there is no meaningful energy then
+    int converged = max_residual <= MP2_NONCANONICAL_TOL;
+    if (!converged) {
+        fprintf(stderr, "Non-canonical MP2 amplitudes did not converge after %d sweeps "
+                "(max residual %.3e).\n", iter, max_residual);
+    }
+
+    // E = sum_{ijab} T_ij^ab (2 <ij|ab> - <ij|ba>)
+    double emp2 = NAN;
+    if (converged) {
+        emp2 = 0.0;
+        #pragma omp parallel for schedule(static) reduction(+:emp2)
+        for (int ij = 0; ij < n_pairs; ij++) {
+            const double* kij = k + (size_t)ij * vv;
+            const double* tij = t + (size_t)ij * vv;
+            for (int a = 0; a < n_virt; a++) {
+                for (int b = 0; b < n_virt; b++) {
+                    emp2 += tij[(size_t)a * n_virt + b] *
+                            (2.0 * kij[(size_t)a * n_virt + b] - kij[(size_t)b * n_virt + a]);
+                }
+            }
+        }
+    }
+
+    free(k);
+    free(t);
+    free(r);
+    if (n_iter) {
+        *n_iter = iter;
+    }
+    return emp2;
+}
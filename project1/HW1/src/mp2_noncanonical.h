@@ -0,0 +1,42 @@
+// File: src/mp2_noncanonical.h
+
+#ifndef MP2_NONCANONICAL_H
+#define MP2_NONCANONICAL_H
+
+#include "eri_index.h"
+
+// Largest residual |R_ij^ab| at which the amplitude equations count as solved
+#define MP2_NONCANONICAL_TOL 1e-10
+
+// Jacobi sweeps before the solver gives up
+#define MP2_NONCANONICAL_MAX_ITER 100
+
+/**
+ * @brief Computes the MP2 correlation energy with a Fock matrix that need not be diagonal.
+ *
+ * The closed-shell amplitudes solve, for every occupied pair (i,j) and virtual pair (a,b),
+ *
+ * R_ij^ab = <ij|ab> + sum_c (F_ac T_ij^cb + F_bc T_ij^ac) - sum_k (F_ik T_kj^ab + F_jk T_ik^ab) = 0
+ *
+ * by Jacobi iteration, T_ij^ab += R_ij^ab / (F_ii + F_jj - F_aa - F_bb), starting from the
+ * canonical guess. The energy is sum_{ijab} T_ij^ab (2 <ij|ab> - <ij|ba>). With a diagonal F
+ * this is the canonical formula of compute_MP2_energy after one sweep. The occupied-virtual
+ * block of F is not used, as in standard non-canonical MP2 on an HF reference.
+ *
+ * @param fock MO Fock matrix (mo_num^2), e.g. from build_fock_matrix.
+ * @param mo_num Number of molecular orbitals.
+ * @param n_occ Number of occupied orbitals.
+ * @param eri Compact indices of the non-zero two-electron integrals.
+ * @param value Values array for two-electron integrals.
+ * @param n_iter Set to the number of sweeps used; may be NULL.
+ * @return MP2 correlation energy, or NAN (with a message) if the sweeps did not converge,
+ *         which happens when F is far from diagonal, or if memory runs out.
+ */
+double compute_MP2_energy_noncanonical(const double* fock,
+                                       int mo_num,
+                                       int n_occ,
+                                       const eri_index* eri,
+                                       const double* value,
+                                       int* n_iter);
+
+#endif // MP2_NONCANONICAL_H
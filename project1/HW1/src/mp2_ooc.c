@@ -0,0 +1,315 @@
+// File: src/mp2_ooc.c
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "mp2_ooc.h"
+
+// One <ij|ab> element in the spill file; i is implied by the tile it lives in
+typedef struct {
+    double val;
+    int32_t j;
+    int32_t ab;   // (a - n_occ) * n_virt + (b - n_occ)
+} ooc_record;
+
+// Upper bound on the number of records staged in memory per tile before a write
+#define OOC_STAGE_MAX 4096
+
+// Bookkeeping per tile: record count, file offset, staged count and write cursor
+#define OOC_TABLE_BYTES (4 * sizeof(int64_t))
+
+/**
+ * @brief Returns the bytes the staging half of the budget needs for n_tiles tiles: the tile
+ *        tables plus room for at least one staged record per tile.
+ */
+static size_t ooc_stage_need(int64_t n_tiles) {
+    return (size_t)n_tiles * (sizeof(ooc_record) + OOC_TABLE_BYTES) + sizeof(int64_t);
+}
+
+/**
+ * @brief Parses a memory size such as "512K", "64M" or "2G" into bytes.
+ */
+size_t parse_memory_size(const char* text) {
+    char* end = NULL;
+    errno = 0;
+    double size = strtod(text, &end);
+    if (errno != 0 || end == text || size <= 0.0) {
+        return 0;
+    }
+
+    switch (*end) {
+        case '\0':                     break;
+        case 'k': case 'K': size *= 1024.0; end++; break;
+        case 'm': case 'M': size *= 1024.0 * 1024.0; end++; break;
+        case 'g': case 'G': size *= 1024.0 * 1024.0 * 1024.0; end++; break;
+        default: return 0;
+    }
+    if (*end == 'B' || *end == 'b') {
+        end++;
+    }
+    if (*end != '\0') {
+        return 0;
+    }
+
+    return (size_t)size;
+}
+
+/**
+ * @brief Writes all staged records of a tile to its slot in the spill file.
+ */
+static void flush_stage(int fd, ooc_record* stage, int64_t* staged, int64_t* cursor) {
+    size_t bytes = (size_t)(*staged) * sizeof(ooc_record);
+    off_t offset = (off_t)(*cursor) * (off_t)sizeof(ooc_record);
+    const char* src = (const char*)stage;
+
+    while (bytes > 0) {
+        ssize_t written = pwrite(fd, src, bytes, offset);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            fprintf(stderr, "Error writing MP2 spill file: %s\n", strerror(errno));
+            exit(EXIT_FAILURE);
+        }
+        src += written;
+        offset += written;
+        bytes -= (size_t)written;
+    }
+
+    *cursor += *staged;
+    *staged = 0;
+}
+
+/**
+ * @brief Computes the MP2 correlation energy without holding the (oo|vv) block in memory.
+ */
+double compute_MP2_energy_ooc(double* mo_energy,
+                              int mo_num,
+                              int n_occ,
+                              const eri_index* eri,
+                              double* value,
+                              const mp2_ooc_config* config,
+                              mp2_checkpoint* ck) {
+    int n_virt = mo_num - n_occ;
+    if (n_occ <= 0 || n_virt <= 0) {
+        return 0.0;
+    }
+    size_t nv2 = (size_t)n_virt * n_virt;
+
+    // Half of the budget goes to the dense tile, the other half to the tile tables and staging
+    // buffers. Fewer j per tile means more tiles, so both halves must fit.
+    size_t tile_budget = config->mem_budget / 2;
+    size_t stage_budget = config->mem_budget - tile_budget;
+    size_t row_bytes = nv2 * sizeof(double);
+    int j_block = (int)(tile_budget / row_bytes);
+    if (j_block > n_occ) {
+        j_block = n_occ;
+    }
+    int n_jblk = j_block > 0 ? (n_occ + j_block - 1) / j_block : 0;
+    int64_t n_tiles = (int64_t)n_occ * n_jblk;
+    if (j_block < 1 || stage_budget < ooc_stage_need(n_tiles)) {
+        // The smallest budget over all tile widths with both halves large enough; the staging
+        // half gets the odd byte
+        size_t need = SIZE_MAX;
+        for (int jb = 1; jb <= n_occ; jb++) {
+            size_t tiles_min = 2 * (size_t)jb * row_bytes;
+            size_t stage_min = 2 * ooc_stage_need((int64_t)n_occ * ((n_occ + jb - 1) / jb)) - 1;
+            size_t budget = tiles_min > stage_min ? tiles_min : stage_min;
+            if (budget < need) {
+                need = budget;
+            }
+        }
+        fprintf(stderr, "Memory budget of %zu bytes is too small for out-of-core MP2 "
+                        "(need at least %zu bytes).\n", config->mem_budget, need);
+        exit(EXIT_FAILURE);
+    }
+
+    int64_t* tile_count = (int64_t*)calloc((size_t)n_tiles, sizeof(int64_t));
+    int64_t* tile_offset = (int64_t*)malloc((size_t)(n_tiles + 1) * sizeof(int64_t));
+    if (!tile_count || !tile_offset) {
+        fprintf(stderr, "Memory allocation failed for out-of-core MP2 tile table.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // Pass 1: count the <ij|ab> records that fall into every (i, j-block) tile
+    int idx[4], perm[8][4];
+    eri_iter it;
+    eri_iter_init(&it, eri);
+    for (int64_t n = 0; n < eri->n_integrals; n++) {
+        eri_iter_next(&it, idx);
+        eri_permutations(idx, perm);
+        for (int p = 0; p < 8; p++) {
+            int i = perm[p][0], j = perm[p][1], a = perm[p][2], b = perm[p][3];
+            if (i < n_occ && j < n_occ && a >= n_occ && b >= n_occ) {
+                tile_count[(int64_t)i * n_jblk + j / j_block]++;
+            }
+        }
+    }
+    tile_offset[0] = 0;
+    for (int64_t t = 0; t < n_tiles; t++) {
+        tile_offset[t + 1] = tile_offset[t] + tile_count[t];
+    }
+    int64_t n_records = tile_offset[n_tiles];
+
+    // Create the spill file and unlink it right away so it never outlives the run
+    size_t dir_len = strlen(config->scratch_dir);
+    char* path = (char*)malloc(dir_len + 32);
+    if (!path) {
+        fprintf(stderr, "Memory allocation failed for spill file name.\n");
+        exit(EXIT_FAILURE);
+    }
+    snprintf(path, dir_len + 32, "%s/mp2_ooc_XXXXXX", config->scratch_dir);
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        fprintf(stderr, "Error creating MP2 spill file in '%s': %s\n",
+                config->scratch_dir, strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    unlink(path);
+    free(path);
+
+    if (n_records > 0 &&
+        ftruncate(fd, (off_t)(n_records * (int64_t)sizeof(ooc_record))) != 0) {
+        fprintf(stderr, "Error sizing MP2 spill file: %s\n", strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+
+    // Pass 2: scatter records into per-tile staging buffers and flush them to their slots.
+    // The budget check above guarantees room for at least one record per tile.
+    size_t stage_cap = (stage_budget - ooc_stage_need(n_tiles) + (size_t)n_tiles * sizeof(ooc_record)) /
+                       ((size_t)n_tiles * sizeof(ooc_record));
+    if (stage_cap > OOC_STAGE_MAX) {
+        stage_cap = OOC_STAGE_MAX;
+    }
+
+    ooc_record* stage = (ooc_record*)malloc((size_t)n_tiles * stage_cap * sizeof(ooc_record));
+    int64_t* staged = (int64_t*)calloc((size_t)n_tiles, sizeof(int64_t));
+    int64_t* cursor = (int64_t*)malloc((size_t)n_tiles * sizeof(int64_t));
+    if (!stage || !staged || !cursor) {
+        fprintf(stderr, "Memory allocation failed for out-of-core MP2 staging buffers.\n");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(cursor, tile_offset, (size_t)n_tiles * sizeof(int64_t));
+
+    eri_iter_init(&it, eri);
+    for (int64_t n = 0; n < eri->n_integrals; n++) {
+        eri_iter_next(&it, idx);
+        eri_permutations(idx, perm);
+        for (int p = 0; p < 8; p++) {
+            int i = perm[p][0], j = perm[p][1], a = perm[p][2], b = perm[p][3];
+            if (i < n_occ && j < n_occ && a >= n_occ && b >= n_occ) {
+                int64_t t = (int64_t)i * n_jblk + j / j_block;
+                ooc_record* rec = &stage[(size_t)t * stage_cap + (size_t)staged[t]];
+                rec->val = value[n];
+                rec->j = j;
+                rec->ab = (a - n_occ) * n_virt + (b - n_occ);
+                if ((size_t)(++staged[t]) == stage_cap) {
+                    flush_stage(fd, &stage[(size_t)t * stage_cap], &staged[t], &cursor[t]);
+                }
+            }
+        }
+    }
+    for (int64_t t = 0; t < n_tiles; t++) {
+        if (staged[t] > 0) {
+            flush_stage(fd, &stage[(size_t)t * stage_cap], &staged[t], &cursor[t]);
+        }
+    }
+    free(stage);
+    free(staged);
+    free(cursor);
+
+    // Pass 3: stream every tile back, expand it to a dense (j,a,b) block and accumulate
+    double* tile = (double*)malloc((size_t)j_block * row_bytes);
+    if (!tile) {
+        fprintf(stderr, "Memory allocation failed for out-of-core MP2 tile.\n");
+        exit(EXIT_FAILURE);
+    }
+    long page = sysconf(_SC_PAGESIZE);
+    mp2_checkpoint local;
+    if (ck == NULL) {
+        if (mp2_checkpoint_open(&local, NULL, 0.0, 0, mo_energy, mo_num, n_occ, eri->n_integrals) != 0) {
+            exit(EXIT_FAILURE);
+        }
+        ck = &local;
+    }
+
+    for (int64_t t = 0; t < n_tiles; t++) {
+        int i = (int)(t / n_jblk);
+        int j0 = (int)(t % n_jblk) * j_block;
+        int j1 = j0 + j_block < n_occ ? j0 + j_block : n_occ;
+
+        // Tiles finished before a restart are not read back
+        int pending = 0;
+        for (int j = j0; j < j1; j++) {
+            pending += !mp2_checkpoint_done(ck, i, j);
+        }
+        if (pending == 0) {
+            continue;
+        }
+
+        // Ask the kernel to start reading the next tile while this one is processed
+        if (t + 1 < n_tiles && tile_count[t + 1] > 0) {
+            posix_fadvise(fd, (off_t)(tile_offset[t + 1] * (int64_t)sizeof(ooc_record)),
+                          (off_t)(tile_count[t + 1] * (int64_t)sizeof(ooc_record)),
+                          POSIX_FADV_WILLNEED);
+        }
+
+        memset(tile, 0, (size_t)(j1 - j0) * row_bytes);
+        if (tile_count[t] > 0) {
+            off_t start = (off_t)(tile_offset[t] * (int64_t)sizeof(ooc_record));
+            off_t aligned = start - start % page;
+            size_t length = (size_t)(start - aligned) +
+                            (size_t)tile_count[t] * sizeof(ooc_record);
+            char* map = (char*)mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, aligned);
+            if (map == MAP_FAILED) {
+                fprintf(stderr, "Error mapping MP2 spill file: %s\n", strerror(errno));
+                exit(EXIT_FAILURE);
+            }
+            madvise(map, length, MADV_SEQUENTIAL);
+
+            const ooc_record* rec = (const ooc_record*)(map + (start - aligned));
+            for (int64_t r = 0; r < tile_count[t]; r++) {
+                tile[(size_t)(rec[r].j - j0) * nv2 + (size_t)rec[r].ab] = rec[r].val;
+            }
+            munmap(map, length);
+        }
+
+        for (int j = j0; j < j1; j++) {
+            if (mp2_checkpoint_done(ck, i, j)) {
+                continue;
+            }
+            const double* ij = &tile[(size_t)(j - j0) * nv2];
+            double e_ij = 0.0;
+            for (int a = 0; a < n_virt; a++) {
+                for (int b = 0; b < n_virt; b++) {
+                    // Energy denominator: e_i + e_j - e_a - e_b
+                    double denom = (mo_energy[i] + mo_energy[j]) -
+                                   (mo_energy[n_occ + a] + mo_energy[n_occ + b]);
+
+                    // Two-electron integrals: <ij|ab> and <ij|ba>
+                    double ijab = ij[(size_t)a * n_virt + b];
+                    double ijba = ij[(size_t)b * n_virt + a];
+
+                    e_ij += ijab * (2.0 * ijab - ijba) / denom;
+                }
+            }
+            mp2_checkpoint_record(ck, i, j, e_ij);
+        }
+    }
+    double emp2 = mp2_checkpoint_total(ck);
+
+    free(tile);
+    free(tile_count);
+    free(tile_offset);
+    close(fd);
+    if (ck == &local) {
+        mp2_checkpoint_close(&local);
+    }
+
+    return emp2;
+}
@@ -0,0 +1,53 @@
+// File: src/mp2_ooc.h
+
+#ifndef MP2_OOC_H
+#define MP2_OOC_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "eri_index.h"
+#include "mp2_checkpoint.h"
+
+/**
+ * @brief Settings for the out-of-core MP2 driver.
+ */
+typedef struct {
+    size_t mem_budget;        // Bytes available for integral tiles and staging buffers
+    const char* scratch_dir;  // Directory in which the spill file is created
+} mp2_ooc_config;
+
+/**
+ * @brief Parses a memory size such as "512K", "64M" or "2G" into bytes.
+ *
+ * @param text Size string; a bare number is taken as bytes.
+ * @return Size in bytes, or 0 if the string is not a valid size.
+ */
+size_t parse_memory_size(const char* text);
+
+/**
+ * @brief Computes the MP2 correlation energy without holding the (oo|vv) block in memory.
+ *
+ * The <ij|ab> integrals are first spilled to a scratch file, bucketed into tiles
+ * of one occupied index i and a block of occupied indices j. Each tile is then
+ * streamed back with read-ahead, expanded into a dense (j,a,b) buffer that fits
+ * in the memory budget, and its pair contributions are accumulated.
+ *
+ * @param mo_energy Array of molecular orbital energies (length mo_num).
+ * @param mo_num Number of molecular orbitals.
+ * @param n_occ Number of occupied orbitals.
+ * @param eri Compact indices of the non-zero two-electron integrals.
+ * @param value Values array for two-electron integrals.
+ * @param config Memory budget and scratch directory.
+ * @param ck Pair bookkeeping from mp2_checkpoint_open; tiles whose pairs are all
+ *           done are not read back. NULL runs every pair without checkpoints.
+ * @return MP2 correlation energy as a double.
+ */
+double compute_MP2_energy_ooc(double* mo_energy,
+                              int mo_num,
+                              int n_occ,
+                              const eri_index* eri,
+                              double* value,
+                              const mp2_ooc_config* config,
+                              mp2_checkpoint* ck);
+
+#endif // MP2_OOC_H
@@ -0,0 +1,218 @@
+// File: src/numa_util.c
+
+#define _GNU_SOURCE
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "numa_util.h"
+
+// Upper bound on the number of NUMA nodes considered
+#define NUMA_MAX_NODES 64
+
+// Number of pages sampled by numa_report
+#define NUMA_REPORT_SAMPLES 4096
+
+static int report_enabled = 0;
+
+/**
+ * @brief Parses "none", "compact" or "scatter".
+ */
+int parse_bind_policy(const char* text, bind_policy* policy) {
+    if (strcmp(text, "none") == 0) {
+        *policy = BIND_NONE;
+    } else if (strcmp(text, "compact") == 0) {
+        *policy = BIND_COMPACT;
+    } else if (strcmp(text, "scatter") == 0) {
+        *policy = BIND_SCATTER;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Reads a sysfs cpulist such as "0-3,8-11" into cpus[], returns the count.
+ */
+static int read_cpulist(const char* path, int* cpus, int max_cpus) {
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        return 0;
+    }
+
+    int count = 0;
+    int first, last;
+    char sep;
+    while (fscanf(file, "%d", &first) == 1) {
+        last = first;
+        if (fscanf(file, "%c", &sep) == 1 && sep == '-') {
+            if (fscanf(file, "%d", &last) != 1) {
+                break;
+            }
+            if (fscanf(file, "%c", &sep) != 1) {
+                sep = '\n';
+            }
+        }
+        for (int cpu = first; cpu <= last && count < max_cpus; cpu++) {
+            cpus[count++] = cpu;
+        }
+        if (sep != ',') {
+            break;
+        }
+    }
+
+    fclose(file);
+    return count;
+}
+
+/**
+ * @brief Returns the number of online NUMA nodes (1 on machines without NUMA).
+ */
+int numa_node_count(void) {
+    int nodes[NUMA_MAX_NODES];
+    int count = read_cpulist("/sys/devices/system/node/online", nodes, NUMA_MAX_NODES);
+    return count > 0 ? count : 1;
+}
+
+/**
+ * @brief Pins every thread of the OpenMP pool to one CPU according to the policy.
+ */
+void pin_threads(bind_policy policy) {
+    if (policy == BIND_NONE) {
+        return;
+    }
+
+    long n_cpus = sysconf(_SC_NPROCESSORS_CONF);
+    int* order = (int*)malloc((size_t)n_cpus * sizeof(int));
+    int* node_cpus = (int*)malloc((size_t)NUMA_MAX_NODES * n_cpus * sizeof(int));
+    int node_count[NUMA_MAX_NODES] = { 0 };
+    if (!order || !node_cpus) {
+        fprintf(stderr, "Memory allocation failed for the CPU map.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // CPUs of every node, from sysfs
+    int nodes[NUMA_MAX_NODES];
+    int n_nodes = read_cpulist("/sys/devices/system/node/online", nodes, NUMA_MAX_NODES);
+    for (int n = 0; n < n_nodes; n++) {
+        char path[128];
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", nodes[n]);
+        node_count[n] = read_cpulist(path, node_cpus + (size_t)n * n_cpus, (int)n_cpus);
+    }
+    if (n_nodes == 0) {
+        n_nodes = 1;
+        node_count[0] = (int)n_cpus;
+        for (int cpu = 0; cpu < n_cpus; cpu++) {
+            node_cpus[cpu] = cpu;
+        }
+    }
+
+    // Thread t runs on order[t % n_order]
+    int n_order = 0;
+    if (policy == BIND_COMPACT) {
+        for (int n = 0; n < n_nodes; n++) {
+            for (int c = 0; c < node_count[n]; c++) {
+                order[n_order++] = node_cpus[(size_t)n * n_cpus + c];
+            }
+        }
+    } else {
+        for (int c = 0; n_order < n_cpus; c++) {
+            int added = 0;
+            for (int n = 0; n < n_nodes; n++) {
+                if (c < node_count[n]) {
+                    order[n_order++] = node_cpus[(size_t)n * n_cpus + c];
+                    added = 1;
+                }
+            }
+            if (!added) {
+                break;
+            }
+        }
+    }
+
+    if (n_order > 0) {
+        #pragma omp parallel
+        {
+            int tid = 0;
+#ifdef _OPENMP
+            tid = omp_get_thread_num();
+#endif
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(order[tid % n_order], &set);
+            if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+                fprintf(stderr, "Warning: could not pin thread %d to CPU %d.\n",
+                        tid, order[tid % n_order]);
+            }
+        }
+    }
+
+    free(order);
+    free(node_cpus);
+}
+
+/**
+ * @brief Enables or disables the page placement report.
+ */
+void numa_set_report(int enabled) {
+    report_enabled = enabled;
+}
+
+/**
+ * @brief Prints how the pages of a buffer are spread over the NUMA nodes.
+ */
+void numa_report(const char* label, const void* buffer, size_t bytes) {
+    if (!report_enabled || bytes == 0) {
+        return;
+    }
+
+    long page = sysconf(_SC_PAGESIZE);
+    size_t n_pages = (bytes + (size_t)page - 1) / (size_t)page;
+    size_t n_samples = n_pages < NUMA_REPORT_SAMPLES ? n_pages : NUMA_REPORT_SAMPLES;
+
+    void** pages = (void**)malloc(n_samples * sizeof(void*));
+    int* status = (int*)malloc(n_samples * sizeof(int));
+    if (!pages || !status) {
+        fprintf(stderr, "Memory allocation failed for the NUMA report.\n");
+        exit(EXIT_FAILURE);
+    }
+    uintptr_t base = (uintptr_t)buffer & ~((uintptr_t)page - 1);
+    for (size_t s = 0; s < n_samples; s++) {
+        pages[s] = (void*)(base + (s * n_pages / n_samples) * (size_t)page);
+    }
+
+    // move_pages with a NULL node list only reports where each page currently lives
+    long rc = syscall(SYS_move_pages, 0, (unsigned long)n_samples, pages, NULL, status, 0);
+    if (rc != 0) {
+        printf("NUMA placement of %s: not available on this system\n", label);
+    } else {
+        size_t per_node[NUMA_MAX_NODES] = { 0 };
+        size_t unmapped = 0;
+        for (size_t s = 0; s < n_samples; s++) {
+            if (status[s] >= 0 && status[s] < NUMA_MAX_NODES) {
+                per_node[status[s]]++;
+            } else {
+                unmapped++;
+            }
+        }
+        printf("NUMA placement of %s (%zu of %zu pages sampled):", label, n_samples, n_pages);
+        for (int n = 0; n < NUMA_MAX_NODES; n++) {
+            if (per_node[n] > 0) {
+                printf(" node%d %.1f%%", n, 100.0 * per_node[n] / n_samples);
+            }
+        }
+        if (unmapped > 0) {
+            printf(" untouched %.1f%%", 100.0 * unmapped / n_samples);
+        }
+        printf("\n");
+    }
+
+    free(pages);
+    free(status);
+}
@@ -0,0 +1,59 @@
+// File: src/numa_util.h
+
+#ifndef NUMA_UTIL_H
+#define NUMA_UTIL_H
+
+#include <stddef.h>
+
+/**
+ * @brief Thread placement policies for the OpenMP kernels.
+ */
+typedef enum {
+    BIND_NONE,     // Leave placement to the OS (or to OMP_PROC_BIND/OMP_PLACES)
+    BIND_COMPACT,  // Fill the CPUs of one NUMA node before moving to the next
+    BIND_SCATTER   // Deal threads round-robin over the NUMA nodes
+} bind_policy;
+
+/**
+ * @brief Parses "none", "compact" or "scatter".
+ *
+ * @param text Policy name.
+ * @param policy Parsed policy.
+ * @return 0 on success, -1 if the name is unknown.
+ */
+int parse_bind_policy(const char* text, bind_policy* policy);
+
+/**
+ * @brief Returns the number of online NUMA nodes (1 on machines without NUMA).
+ */
+int numa_node_count(void);
+
+/**
+ * @brief Pins every thread of the OpenMP pool to one CPU according to the policy.
+ *
+ * The CPU-to-node map is read from /sys/devices/system/node. Pinning is done once,
+ * before the first parallel kernel, so that the first-touch initialisation of the
+ * integral arrays and the kernels that later read them run on the same CPUs.
+ *
+ * @param policy Placement policy; BIND_NONE does nothing.
+ */
+void pin_threads(bind_policy policy);
+
+/**
+ * @brief Enables or disables the page placement report.
+ */
+void numa_set_report(int enabled);
+
+/**
+ * @brief Prints how the pages of a buffer are spread over the NUMA nodes.
+ *
+ * Uses move_pages(2) in query mode on up to a few thousand evenly spaced pages.
+ * Does nothing unless enabled with numa_set_report.
+ *
+ * @param label Name of the buffer in the report.
+ * @param buffer Start of the buffer.
+ * @param bytes Size of the buffer.
+ */
+void numa_report(const char* label, const void* buffer, size_t bytes);
+
+#endif // NUMA_UTIL_H
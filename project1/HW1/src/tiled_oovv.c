@@ -0,0 +1,116 @@
+// File: src/tiled_oovv.c
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "tiled_oovv.h"
+
+/**
+ * @brief Allocates a zeroed tiled block.
+ */
+int tiled_oovv_init(tiled_oovv* t, int n_occ, int n_virt) {
+    t->n_occ = n_occ;
+    t->n_virt = n_virt;
+    t->n_tiles = (n_virt + TILE_DIM - 1) / TILE_DIM;
+    t->pair_stride = (size_t)t->n_tiles * t->n_tiles * TILE_DIM * TILE_DIM;
+
+    size_t bytes = (size_t)n_occ * n_occ * t->pair_stride * sizeof(double);
+    void* data = NULL;
+    if (posix_memalign(&data, 64, bytes + 64) != 0) {
+        fprintf(stderr, "Memory allocation failed for tiled (oo|vv) integrals.\n");
+        errno = ENOMEM;
+        return -1;
+    }
+    t->data = (double*)data;
+
+    // First touch: each pair slab is zeroed by the thread that will later sum it,
+    // with the same static schedule as the pair loop in compute_MP2_energy
+    int n_pairs = n_occ * n_occ;
+    #pragma omp parallel for schedule(static)
+    for (int ij = 0; ij < n_pairs; ij++) {
+        memset(t->data + (size_t)ij * t->pair_stride, 0, t->pair_stride * sizeof(double));
+    }
+    return 0;
+}
+
+/**
+ * @brief Scatters the <ij|ab> integrals of a sparse list into the tiled block.
+ */
+void tiled_oovv_fill(tiled_oovv* t, const eri_index* eri, const double* value) {
+    int n_occ = t->n_occ;
+    int mo_num = n_occ + t->n_virt;
+    int idx[4], perm[8][4];
+
+    eri_iter it;
+    eri_iter_init(&it, eri);
+    for (int64_t n = 0; n < eri->n_integrals; n++) {
+        eri_iter_next(&it, idx);
+        eri_permutations(idx, perm);
+        for (int p = 0; p < 8; p++) {
+            int i = perm[p][0], j = perm[p][1], a = perm[p][2], b = perm[p][3];
+            if (i < n_occ && j < n_occ && a >= n_occ && b >= n_occ &&
+                a < mo_num && b < mo_num) {
+                t->data[tiled_oovv_offset(t, i, j, a - n_occ, b - n_occ)] = value[n];
+            }
+        }
+    }
+}
+
+/**
+ * @brief Accumulates the MP2 pair energy of occupied pair (i,j) from the tiled block.
+ */
+double tiled_oovv_pair_energy(const tiled_oovv* t, const double* mo_energy, int i, int j) {
+    const double* e_virt = mo_energy + t->n_occ;
+    const double* pair = t->data + ((size_t)i * t->n_occ + j) * t->pair_stride;
+    double e_ij = mo_energy[i] + mo_energy[j];
+    double transposed[TILE_DIM * TILE_DIM];
+    double emp2 = 0.0;
+
+    // The denominator is symmetric in (a,b), so tiles (A,B) and (B,A) are handled together:
+    // x*(2x - y) + y*(2y - x) = 2*(x*x + y*y - x*y) with x = <ij|ab>, y = <ij|ba>
+    for (int at = 0; at < t->n_tiles; at++) {
+        int a0 = at * TILE_DIM;
+        int na = t->n_virt - a0 < TILE_DIM ? t->n_virt - a0 : TILE_DIM;
+
+        for (int bt = at; bt < t->n_tiles; bt++) {
+            int b0 = bt * TILE_DIM;
+            int nb = t->n_virt - b0 < TILE_DIM ? t->n_virt - b0 : TILE_DIM;
+
+            // Tile (A,B) holds <ij|ab>; transposing tile (B,A) gives <ij|ba> in the same order
+            const double* ab = pair + ((size_t)at * t->n_tiles + bt) * (TILE_DIM * TILE_DIM);
+            const double* ba = pair + ((size_t)bt * t->n_tiles + at) * (TILE_DIM * TILE_DIM);
+            for (int b = 0; b < TILE_DIM; b++) {
+                for (int a = 0; a < TILE_DIM; a++) {
+                    transposed[a * TILE_DIM + b] = ba[b * TILE_DIM + a];
+                }
+            }
+
+            double tile_sum = 0.0;
+            for (int a = 0; a < na; a++) {
+                const double* ab_row = ab + a * TILE_DIM;
+                const double* ba_row = transposed + a * TILE_DIM;
+                double e_ija = e_ij - e_virt[a0 + a];
+                for (int b = 0; b < nb; b++) {
+                    // Energy denominator: e_i + e_j - e_a - e_b
+                    double denom = e_ija - e_virt[b0 + b];
+                    double ijab = ab_row[b];
+                    double ijba = ba_row[b];
+                    tile_sum += (ijab * ijab + ijba * ijba - ijab * ijba) / denom;
+                }
+            }
+            // A diagonal tile already covers both (a,b) and (b,a); an off-diagonal one also stands in for (B,A)
+            emp2 += at == bt ? tile_sum : 2.0 * tile_sum;
+        }
+    }
+
+    return emp2;
+}
+
+/**
+ * @brief Releases the storage held by a tiled block.
+ */
+void free_tiled_oovv(tiled_oovv* t) {
+    free(t->data);
+    t->data = NULL;
+}
@@ -0,0 +1,79 @@
+// File: src/tiled_oovv.h
+
+#ifndef TILED_OOVV_H
+#define TILED_OOVV_H
+
+#include <stddef.h>
+#include "eri_index.h"
+
+// Edge of a square (a,b) tile; two 32x32 double tiles (16 KB) fit in L1
+#ifndef TILE_DIM
+#define TILE_DIM 32
+#endif
+
+/**
+ * @brief The <ij|ab> integrals (i,j occupied, a,b virtual) in a cache-tiled layout.
+ *
+ * For every occupied pair (i,j) the n_virt x n_virt matrix over (a,b) is split
+ * into TILE_DIM x TILE_DIM tiles stored contiguously, row-major inside each tile.
+ * Edges are zero-padded to whole tiles. A kernel reading <ij|ab> and <ij|ba>
+ * reads tile (A,B) directly and transposes tile (B,A) into a small local buffer,
+ * so both orderings are traversed unit-stride.
+ */
+typedef struct {
+    int n_occ;            // Number of occupied orbitals
+    int n_virt;           // Number of virtual orbitals
+    int n_tiles;          // Tiles along each virtual dimension
+    size_t pair_stride;   // Doubles per (i,j) pair: n_tiles^2 * TILE_DIM^2
+    double* data;         // n_occ^2 * pair_stride doubles, 64-byte aligned
+} tiled_oovv;
+
+/**
+ * @brief Allocates a zeroed tiled block.
+ *
+ * Pages are first touched in parallel, pair by pair, so that on NUMA machines
+ * each pair lands on the node of the thread that processes it.
+ *
+ * @param t Block to initialise.
+ * @param n_occ Number of occupied orbitals.
+ * @param n_virt Number of virtual orbitals.
+ * @return 0 on success, -1 (with a message, errno = ENOMEM) if the block cannot be allocated.
+ */
+int tiled_oovv_init(tiled_oovv* t, int n_occ, int n_virt);
+
+/**
+ * @brief Offset of <ij|ab> in t->data; a and b are counted from the first virtual orbital.
+ */
+static inline size_t tiled_oovv_offset(const tiled_oovv* t, int i, int j, int a, int b) {
+    size_t pair = (size_t)i * t->n_occ + j;
+    size_t tile = (size_t)(a / TILE_DIM) * t->n_tiles + (size_t)(b / TILE_DIM);
+    return pair * t->pair_stride + tile * (TILE_DIM * TILE_DIM) +
+           (size_t)(a % TILE_DIM) * TILE_DIM + (size_t)(b % TILE_DIM);
+}
+
+/**
+ * @brief Scatters the <ij|ab> integrals of a sparse list into the tiled block.
+ *
+ * @param t Block initialised with tiled_oovv_init.
+ * @param eri Compact indices of the non-zero two-electron integrals.
+ * @param value Values array for two-electron integrals.
+ */
+void tiled_oovv_fill(tiled_oovv* t, const eri_index* eri, const double* value);
+
+/**
+ * @brief Accumulates the MP2 pair energy of occupied pair (i,j) from the tiled block.
+ *
+ * @param t Filled block.
+ * @param mo_energy Array of molecular orbital energies (length n_occ + n_virt).
+ * @param i First occupied index.
+ * @param j Second occupied index.
+ * @return sum_{ab} <ij|ab> (2 <ij|ab> - <ij|ba>) / (e_i + e_j - e_a - e_b)
+ */
+double tiled_oovv_pair_energy(const tiled_oovv* t, const double* mo_energy, int i, int j);
+
+/**
+ * @brief Releases the storage held by a tiled block.
+ */
+void free_tiled_oovv(tiled_oovv* t);
+
+#endif // TILED_OOVV_H
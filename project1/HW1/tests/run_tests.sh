@@ -0,0 +1,192 @@
+#!/bin/bash
+# File: tests/run_tests.sh
+#
+# Numerical regression and performance-budget tests for compute_energy.
+#
+# Every input is run through every HF/MP2 path and the energies are compared
+# with tests/reference_energies.dat. The wall time of each phase (best of
+# PERF_REPEAT runs) must stay within PERF_BUDGET percent of
+# tests/timing_baseline.dat.
+#
+# Only phases whose baseline is at least PERF_MIN_TIME seconds are budgeted;
+# shorter ones are mostly timer noise, and a fixed allowance large enough for
+# that noise would let them grow many times over unnoticed. The syn80 input
+# exists for this: every one of its phases is budgeted on every path. Of the
+# real molecules, only the longer read phases usually clear the threshold.
+#
+# Usage: tests/run_tests.sh [--update-baseline]
+#
+# Environment:
+#   ENERGY_TOL     Absolute tolerance on energies in Hartree (default: 1e-7)
+#   PERF_BUDGET    Allowed slowdown per phase in percent (default: 50)
+#   PERF_MIN_TIME  Shortest baseline in seconds that is budgeted (default: 0.05)
+#   PERF_REPEAT    Runs per case, the fastest one counts (default: 3)
+
+cd "$(dirname "$0")/.." || exit 1
+
+EXEC=./compute_energy
+GEN=./tools/gen_trexio
+REFERENCE=tests/reference_energies.dat
+BASELINE=tests/timing_baseline.dat
+
+ENERGY_TOL=${ENERGY_TOL:-1e-7}
+PERF_BUDGET=${PERF_BUDGET:-50}
+PERF_MIN_TIME=${PERF_MIN_TIME:-0.05}
+PERF_REPEAT=${PERF_REPEAT:-3}
+
+UPDATE=0
+if [ "$1" = "--update-baseline" ]; then
+    UPDATE=1
+fi
+
+for prog in "$EXEC" "$GEN"; do
+    if [ ! -x "$prog" ]; then
+        echo "Missing $prog; run 'make all tools' first." >&2
+        exit 1
+    fi
+done
+
+WORK=$(mktemp -d "${TMPDIR:-/tmp}/compute_energy_tests.XXXXXX")
+trap 'rm -rf "$WORK"' EXIT
+
+# Synthetic inputs: syn60 is large enough for the MP2 tiles and spill path to matter; syn80 runs
+# long enough in every phase for the performance budget to be measurable, while its MP2 still
+# fits the 64K out-of-core budget
+"$GEN" --mo-num 60 --n-occ 12 --seed 7 "$WORK/syn60.h5" > /dev/null || exit 1
+"$GEN" --mo-num 80 --n-occ 20 --seed 11 "$WORK/syn80.h5" > /dev/null || exit 1
+
+# Input name and file
+CASES="h2o:data/h2o.h5 ch4:data/ch4.h5 hcn:data/hcn.h5 c2h2:data/c2h2.h5 syn60:$WORK/syn60.h5 syn80:$WORK/syn80.h5"
+
+# Path name and the options that select it; @NAME@ is replaced by the input name.
+# "serial" pins one thread so single-threaded regressions show up on any machine.
+# "resume" checkpoints after every pair; every timed run starts without a checkpoint, and one
+# more (untimed) run then resumes from the complete checkpoint and must give the same energies.
+# "noncanonical" is checked against its own reference column and skipped where that is "-".
+MODES=("packed:" "delta:--eri-delta" "ooc:--mem-budget 64K --scratch-dir $WORK"
+       "serial:--threads 1 --eri-delta"
+       "threaded:--threads 4 --eri-delta"
+       "resume:--checkpoint $WORK/@NAME@.ckpt --checkpoint-interval 0 --resume"
+       "noncanonical:--noncanonical")
+
+# Compares the energies printed in $2 with the reference of the current input; $1 labels the run
+check_energies() {
+    local hf mp2
+    hf=$(echo "$2" | awk '/E_HF\)/ { print $(NF - 2) }')
+    mp2=$(echo "$2" | awk '/E_HF \+ EMP2\)/ { print $(NF - 2) }')
+    if awk -v a="$hf" -v b="$ref_hf" -v c="$mp2" -v d="$ref_mp2" -v tol="$ENERGY_TOL" \
+           'BEGIN { da = a - b; dc = c - d; exit !(da <= tol && -da <= tol && dc <= tol && -dc <= tol) }'; then
+        echo "ok   $1: E_HF = $hf, E_MP2 = $mp2"
+    else
+        echo "FAIL $1: E_HF = $hf (ref $ref_hf), E_MP2 = $mp2 (ref $ref_mp2)"
+        failures=$((failures + 1))
+    fi
+}
+
+failures=0
+budgeted=0
+new_baseline="$WORK/baseline.dat"
+: > "$new_baseline"
+
+for case_spec in $CASES; do
+    name=${case_spec%%:*}
+    file=${case_spec#*:}
+
+    ref_hf=$(awk -v n="$name" '$1 == n { print $2 }' "$REFERENCE")
+    ref_canonical=$(awk -v n="$name" '$1 == n { print $3 }' "$REFERENCE")
+    ref_noncanonical=$(awk -v n="$name" '$1 == n { print $4 }' "$REFERENCE")
+    if [ -z "$ref_hf" ]; then
+        echo "FAIL $name: no reference energies in $REFERENCE"
+        failures=$((failures + 1))
+        continue
+    fi
+
+    for mode_spec in "${MODES[@]}"; do
+        mode=${mode_spec%%:*}
+        opts=${mode_spec#*:}
+        opts=${opts//@NAME@/$name}
+        ref_mp2=$ref_canonical
+        if [ "$mode" = noncanonical ]; then
+            [ "$ref_noncanonical" = "-" ] && continue
+            ref_mp2=$ref_noncanonical
+        fi
+        ckpt=""
+        if [[ $opts =~ --checkpoint\ ([^ ]+) ]]; then
+            ckpt=${BASH_REMATCH[1]}
+        fi
+
+        best_read="" best_hf="" best_mp2=""
+        for ((run = 0; run < PERF_REPEAT; run++)); do
+            # A left-over complete checkpoint would turn the timed run into a no-op
+            [ -n "$ckpt" ] && rm -f "$ckpt"
+            if ! out=$($EXEC --timings $opts "$file" 2>&1); then
+                echo "FAIL $name/$mode: compute_energy exited with an error"
+                echo "$out" | tail -3
+                failures=$((failures + 1))
+                continue 2
+            fi
+            read_t=$(echo "$out" | awk '/^Phase time read/ { print $5 }')
+            hf_t=$(echo "$out" | awk '/^Phase time hf/ { print $5 }')
+            mp2_t=$(echo "$out" | awk '/^Phase time mp2/ { print $5 }')
+            best_read=$(awk -v a="$best_read" -v b="$read_t" 'BEGIN { print (a == "" || b < a) ? b : a }')
+            best_hf=$(awk -v a="$best_hf" -v b="$hf_t" 'BEGIN { print (a == "" || b < a) ? b : a }')
+            best_mp2=$(awk -v a="$best_mp2" -v b="$mp2_t" 'BEGIN { print (a == "" || b < a) ? b : a }')
+        done
+
+        # Numerical regression against the stored energies
+        check_energies "$name/$mode" "$out"
+        if [ -n "$ckpt" ]; then
+            if out=$($EXEC $opts "$file" 2>&1); then
+                check_energies "$name/$mode (resumed)" "$out"
+            else
+                echo "FAIL $name/$mode: resuming from the complete checkpoint failed"
+                failures=$((failures + 1))
+            fi
+        fi
+
+        # Performance budget per phase
+        for phase in read hf mp2; do
+            case $phase in
+                read) t=$best_read ;;
+                hf)   t=$best_hf ;;
+                mp2)  t=$best_mp2 ;;
+            esac
+            echo "$name $mode $phase $t" >> "$new_baseline"
+            [ "$UPDATE" = 1 ] && continue
+
+            base=$(awk -v n="$name" -v m="$mode" -v p="$phase" \
+                       '$1 == n && $2 == m && $3 == p { print $4 }' "$BASELINE" 2>/dev/null)
+            if [ -z "$base" ]; then
+                echo "     $name/$mode/$phase: no timing baseline, ${t}s"
+                continue
+            fi
+            if awk -v b="$base" -v min="$PERF_MIN_TIME" 'BEGIN { exit !(b < min) }'; then
+                continue
+            fi
+            budgeted=$((budgeted + 1))
+            if ! awk -v t="$t" -v b="$base" -v pct="$PERF_BUDGET" 'BEGIN { exit !(t <= b * (1 + pct / 100)) }'; then
+                echo "FAIL $name/$mode/$phase: ${t}s exceeds baseline ${base}s by more than ${PERF_BUDGET}%"
+                failures=$((failures + 1))
+            fi
+        done
+    done
+done
+
+if [ "$UPDATE" = 1 ]; then
+    {
+        echo "# Best-of-$PERF_REPEAT wall time in seconds per input, path and phase."
+        echo "# Regenerate with: make test-baseline"
+        cat "$new_baseline"
+    } > "$BASELINE"
+    echo "Timing baseline written to $BASELINE"
+fi
+
+if [ "$UPDATE" = 0 ]; then
+    echo "$budgeted phase(s) had a baseline of at least ${PERF_MIN_TIME}s and were held to the ${PERF_BUDGET}% budget"
+fi
+
+if [ "$failures" -gt 0 ]; then
+    echo "$failures check(s) failed"
+    exit 1
+fi
+echo "All checks passed"
@@ -0,0 +1,269 @@
+// File: tools/gen_trexio.c
+//
+// Writes a TREXIO file with synthetic but physically plausible integrals for an
+// arbitrary number of molecular orbitals, so that the memory use and scaling of
+// compute_energy can be studied at sizes for which no real input is shipped.
+//
+// - Orbital energies are sorted: n_occ negative occupied levels, then positive virtuals.
+// - Two-electron integrals are generated once per 8-fold symmetry class. In chemist
+//   notation (ik|jl) = s_ik * s_jl * g with pair strength s_pq = exp(-decay * |p - q|),
+//   so Coulomb-type (ii|jj) integrals are large and positive while integrals over
+//   distant orbital pairs decay. Integrals below the cutoff are dropped, which sets
+//   the sparsity.
+//
+// Usage: gen_trexio [options] <output.h5>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <trexio.h>
+
+// Number of integrals buffered before each TREXIO write
+#define GEN_CHUNK (1 << 20)
+
+/**
+ * @brief Settings of the generated system.
+ */
+typedef struct {
+    int mo_num;        // Number of molecular orbitals
+    int n_occ;         // Number of doubly occupied orbitals
+    double decay;      // Exponential decay of the pair strength with |p - q|
+    double cutoff;     // Integrals with |value| below this are not written
+    double E_NN;       // Nuclear repulsion energy
+    unsigned long seed;
+} gen_config;
+
+/**
+ * @brief xorshift64* generator; returns a uniform double in [0, 1).
+ */
+static double next_uniform(unsigned long long* state) {
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return (double)((*state * 2685821657736338717ULL) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static int compare_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Aborts with a message when a TREXIO call fails.
+ */
+static void check(trexio_exit_code rc, const char* what) {
+    if (rc != TREXIO_SUCCESS) {
+        fprintf(stderr, "TREXIO Error writing %s: %s\n", what, trexio_string_of_error(rc));
+        exit(EXIT_FAILURE);
+    }
+}
+
+/**
+ * @brief Writes sorted orbital energies and a symmetric core Hamiltonian.
+ */
+static void write_one_electron(trexio_t* file, const gen_config* cfg, unsigned long long* rng) {
+    int n = cfg->mo_num;
+    double* mo_energy = (double*)malloc(n * sizeof(double));
+    double* core = (double*)malloc((size_t)n * n * sizeof(double));
+    if (!mo_energy || !core) {
+        fprintf(stderr, "Memory allocation failed for one-electron data.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // Occupied levels in [-20, -0.3], virtual levels in [0.05, 5], each block sorted
+    for (int p = 0; p < n; p++) {
+        double u = next_uniform(rng);
+        mo_energy[p] = p < cfg->n_occ ? -20.0 + 19.7 * u * u : 0.05 + 4.95 * u;
+    }
+    qsort(mo_energy, cfg->n_occ, sizeof(double), compare_double);
+    qsort(mo_energy + cfg->n_occ, n - cfg->n_occ, sizeof(double), compare_double);
+
+    // Core Hamiltonian: strongly negative diagonal, small off-diagonal couplings
+    for (int p = 0; p < n; p++) {
+        core[p * n + p] = 1.5 * mo_energy[p] - 1.0;
+        for (int q = 0; q < p; q++) {
+            double h = 0.1 * (next_uniform(rng) - 0.5) * exp(-cfg->decay * (p - q));
+            core[p * n + q] = h;
+            core[q * n + p] = h;
+        }
+    }
+
+    check(trexio_write_mo_energy(file, mo_energy), "MO energies");
+    check(trexio_write_mo_1e_int_core_hamiltonian(file, core), "core Hamiltonian");
+    free(mo_energy);
+    free(core);
+}
+
+/**
+ * @brief Generates and writes one integral per symmetry class, returns the count written.
+ */
+static int64_t write_two_electron(trexio_t* file, const gen_config* cfg, unsigned long long* rng) {
+    int n = cfg->mo_num;
+
+    // Largest |p - q| whose pair strength can still produce an integral above the cutoff
+    int d_max = n - 1;
+    if (cfg->decay > 0.0) {
+        double d = -log(cfg->cutoff) / cfg->decay;
+        if (d < d_max) {
+            d_max = (int)d;
+        }
+    }
+
+    int32_t* index = (int32_t*)malloc(4 * GEN_CHUNK * sizeof(int32_t));
+    double* value = (double*)malloc(GEN_CHUNK * sizeof(double));
+    if (!index || !value) {
+        fprintf(stderr, "Memory allocation failed for integral buffers.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    int64_t written = 0;
+    int64_t buffered = 0;
+
+    // Canonical classes in chemist notation: (ik|jl) with i >= k, j >= l, (i,k) >= (j,l)
+    for (int i = 0; i < n; i++) {
+        for (int k = (i > d_max ? i - d_max : 0); k <= i; k++) {
+            double s_ik = exp(-cfg->decay * (i - k));
+            for (int j = 0; j <= i; j++) {
+                int l_max = (j == i) ? k : j;
+                for (int l = (j > d_max ? j - d_max : 0); l <= l_max; l++) {
+                    double s_jl = exp(-cfg->decay * (j - l));
+                    double g;
+                    if (i == k && j == l) {
+                        // Coulomb-type (ii|jj): positive, larger for nearby orbitals
+                        g = 0.2 + 0.6 / (1.0 + 0.1 * abs(i - j)) + 0.1 * next_uniform(rng);
+                    } else {
+                        g = 0.3 * (next_uniform(rng) - 0.5);
+                    }
+                    double v = s_ik * s_jl * g;
+                    if (fabs(v) < cfg->cutoff) {
+                        continue;
+                    }
+
+                    // TREXIO stores physicist notation: (ik|jl) = <ij|kl>
+                    index[4 * buffered + 0] = i;
+                    index[4 * buffered + 1] = j;
+                    index[4 * buffered + 2] = k;
+                    index[4 * buffered + 3] = l;
+                    value[buffered] = v;
+                    if (++buffered == GEN_CHUNK) {
+                        check(trexio_write_mo_2e_int_eri(file, written, buffered, index, value),
+                              "two-electron integrals");
+                        written += buffered;
+                        buffered = 0;
+                    }
+                }
+            }
+        }
+    }
+    if (buffered > 0) {
+        check(trexio_write_mo_2e_int_eri(file, written, buffered, index, value),
+              "two-electron integrals");
+        written += buffered;
+    }
+
+    free(index);
+    free(value);
+    return written;
+}
+
+/**
+ * @brief Prints the command-line usage.
+ */
+static void print_usage(const char* prog) {
+    fprintf(stderr, "Usage: %s [options] <output.h5>\n", prog);
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  --mo-num <n>      Number of molecular orbitals (default: 100)\n");
+    fprintf(stderr, "  --n-occ <n>       Number of occupied orbitals (default: mo_num / 5)\n");
+    fprintf(stderr, "  --decay <x>       Decay of integrals with orbital distance (default: 0.15)\n");
+    fprintf(stderr, "  --cutoff <x>      Drop integrals smaller than x (default: 1e-6)\n");
+    fprintf(stderr, "  --e-nn <x>        Nuclear repulsion energy (default: 10.0)\n");
+    fprintf(stderr, "  --seed <n>        Random seed (default: 1)\n");
+    fprintf(stderr, "  --force           Overwrite the output file if it exists\n");
+}
+
+int main(int argc, char* argv[]) {
+    gen_config cfg = { 100, 0, 0.15, 1e-6, 10.0, 1 };
+    const char* filename = NULL;
+    int force = 0;
+
+    for (int arg = 1; arg < argc; arg++) {
+        const char* opt = argv[arg];
+        int has_value = arg + 1 < argc;
+        if (strcmp(opt, "--mo-num") == 0 && has_value) {
+            cfg.mo_num = atoi(argv[++arg]);
+        } else if (strcmp(opt, "--n-occ") == 0 && has_value) {
+            cfg.n_occ = atoi(argv[++arg]);
+        } else if (strcmp(opt, "--decay") == 0 && has_value) {
+            cfg.decay = atof(argv[++arg]);
+        } else if (strcmp(opt, "--cutoff") == 0 && has_value) {
+            cfg.cutoff = atof(argv[++arg]);
+        } else if (strcmp(opt, "--e-nn") == 0 && has_value) {
+            cfg.E_NN = atof(argv[++arg]);
+        } else if (strcmp(opt, "--seed") == 0 && has_value) {
+            cfg.seed = strtoul(argv[++arg], NULL, 10);
+        } else if (strcmp(opt, "--force") == 0) {
+            force = 1;
+        } else if (opt[0] != '-' && filename == NULL) {
+            filename = opt;
+        } else {
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (cfg.n_occ == 0) {
+        cfg.n_occ = cfg.mo_num / 5;
+    }
+    if (filename == NULL || cfg.mo_num < 2 || cfg.n_occ < 1 || cfg.n_occ >= cfg.mo_num ||
+        cfg.decay < 0.0 || cfg.cutoff <= 0.0) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // TREXIO refuses to overwrite, so an existing file is removed first, but only when asked to:
+    // a mistyped path must not delete a real input
+    struct stat st;
+    if (stat(filename, &st) == 0) {
+        if (!force) {
+            fprintf(stderr, "'%s' already exists; use --force to overwrite it.\n", filename);
+            return EXIT_FAILURE;
+        }
+        if (remove(filename) != 0) {
+            perror("Error removing the existing output file");
+            return EXIT_FAILURE;
+        }
+    }
+    trexio_exit_code rc;
+    trexio_t* file = trexio_open(filename, 'w', TREXIO_HDF5, &rc);
+    if (rc != TREXIO_SUCCESS) {
+        fprintf(stderr, "TREXIO Error opening file '%s': %s\n", filename, trexio_string_of_error(rc));
+        return EXIT_FAILURE;
+    }
+
+    unsigned long long rng = 0x9E3779B97F4A7C15ULL ^ (unsigned long long)cfg.seed;
+    if (rng == 0) {
+        rng = 1;
+    }
+
+    check(trexio_write_nucleus_repulsion(file, cfg.E_NN), "nuclear repulsion");
+    check(trexio_write_electron_num(file, 2 * cfg.n_occ), "electron number");
+    check(trexio_write_electron_up_num(file, cfg.n_occ), "up-spin electron number");
+    check(trexio_write_electron_dn_num(file, cfg.n_occ), "down-spin electron number");
+    check(trexio_write_mo_num(file, cfg.mo_num), "number of MOs");
+    write_one_electron(file, &cfg, &rng);
+    int64_t n_integrals = write_two_electron(file, &cfg, &rng);
+
+    rc = trexio_close(file);
+    if (rc != TREXIO_SUCCESS) {
+        fprintf(stderr, "TREXIO Error closing file '%s': %s\n", filename, trexio_string_of_error(rc));
+        return EXIT_FAILURE;
+    }
+
+    double unique = (double)cfg.mo_num * (cfg.mo_num + 1) / 2.0;
+    unique = unique * (unique + 1) / 2.0;
+    printf("Wrote %s: mo_num = %d, n_occ = %d, %ld two-electron integrals (%.2f%% of unique)\n",
+           filename, cfg.mo_num, cfg.n_occ, (long)n_integrals, 100.0 * n_integrals / unique);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,203 @@
+// File: src/atoms.c
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "atoms.h"
+
+// Function to parse a floating-point number from [*p, end); returns 0 if there is none.
+// Short decimal numbers are converted exactly with one multiply or divide by a power of ten,
+// which rounds like strtod; anything longer falls back to strtod.
+int parse_double(const char** p, const char* end, double* value) {
+    static const double pow10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+    const char* s = *p;
+    while (s < end && (*s == ' ' || *s == '\t' || *s == '\r')) s++;
+    const char* token = s;
+
+    int negative = 0;
+    if (s < end && (*s == '-' || *s == '+')) {
+        negative = *s == '-';
+        s++;
+    }
+    unsigned long long mantissa = 0;
+    int digits = 0, exponent = 0;
+    for (; s < end && *s >= '0' && *s <= '9'; s++, digits++) {
+        mantissa = mantissa * 10 + (unsigned long long)(*s - '0');
+    }
+    if (s < end && *s == '.') {
+        for (s++; s < end && *s >= '0' && *s <= '9'; s++, digits++) {
+            mantissa = mantissa * 10 + (unsigned long long)(*s - '0');
+            exponent--;
+        }
+    }
+    if (digits == 0) {
+        return 0;
+    }
+    if (s < end && (*s == 'e' || *s == 'E')) {
+        const char* e = s + 1;
+        int exp_negative = 0, exp_value = 0, exp_digits = 0;
+        if (e < end && (*e == '-' || *e == '+')) {
+            exp_negative = *e == '-';
+            e++;
+        }
+        for (; e < end && *e >= '0' && *e <= '9' && exp_value < 10000; e++, exp_digits++) {
+            exp_value = exp_value * 10 + (*e - '0');
+        }
+        if (exp_digits > 0) {
+            exponent += exp_negative ? -exp_value : exp_value;
+            s = e;
+        }
+    }
+
+    if (digits <= 15 && exponent >= -22 && exponent <= 22) {
+        double v = (double)mantissa;
+        v = exponent < 0 ? v / pow10[-exponent] : v * pow10[exponent];
+        *value = negative ? -v : v;
+    } else {
+        char buffer[64];
+        size_t length = (size_t)(s - token);
+        if (length >= sizeof(buffer)) {
+            return 0;
+        }
+        memcpy(buffer, token, length);
+        buffer[length] = '\0';
+        *value = strtod(buffer, NULL);
+    }
+    *p = s;
+    return 1;
+}
+
+// Function to parse one "Symbol x y z mass" line from [p, end); returns 0 if it is not an atom
+int parse_atom_line(const char* p, const char* end, Atom* atom) {
+    while (p < end && (*p == ' ' || *p == '\t')) p++;
+    const char* symbol = p;
+    while (p < end && *p != ' ' && *p != '\t' && *p != '\r') p++;
+    size_t length = (size_t)(p - symbol);
+    if (length == 0) {
+        return 0;
+    }
+    if (length > 2) {
+        length = 2;
+    }
+    memcpy(atom->atom, symbol, length);
+    atom->atom[length] = '\0';
+
+    return parse_double(&p, end, &atom->x) && parse_double(&p, end, &atom->y) &&
+           parse_double(&p, end, &atom->z) && parse_double(&p, end, &atom->mass);
+}
+
+// Function to load atoms from an input file: the first line is a header, every other line
+// "Symbol x y z mass". The file is memory-mapped and parsed in parallel chunks of whole lines.
+size_t load_atoms(const char* path, Atom** atoms_out) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror("Error opening input file");
+        exit(EXIT_FAILURE);
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        perror("Error reading input file");
+        exit(EXIT_FAILURE);
+    }
+    size_t size = (size_t)st.st_size;
+    const char* data = NULL;
+    if (size > 0) {
+        data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            perror("Error mapping input file");
+            exit(EXIT_FAILURE);
+        }
+        madvise((void*)data, size, MADV_SEQUENTIAL);
+    }
+    close(fd);
+
+    // Skip header line
+    const char* body = size > 0 ? memchr(data, '\n', size) : NULL;
+    body = body ? body + 1 : data + size;
+    const char* end = data + size;
+
+    // Split the body into chunks that start at line boundaries
+    int n_chunks = 1;
+#ifdef _OPENMP
+    n_chunks = 4 * omp_get_max_threads();
+#endif
+    if ((size_t)(end - body) < (size_t)n_chunks * 4096) {
+        n_chunks = 1;
+    }
+    const char** chunk = malloc((n_chunks + 1) * sizeof(char*));
+    size_t* chunk_lines = calloc(n_chunks + 1, sizeof(size_t));
+    if (chunk == NULL || chunk_lines == NULL) {
+        printf("Memory allocation failed for the input loader\n");
+        exit(EXIT_FAILURE);
+    }
+    chunk[0] = body;
+    for (int c = 1; c < n_chunks; c++) {
+        const char* split = body + (size_t)(end - body) * c / n_chunks;
+        if (split < chunk[c - 1]) split = chunk[c - 1];
+        const char* newline = memchr(split, '\n', (size_t)(end - split));
+        chunk[c] = newline ? newline + 1 : end;
+    }
+    chunk[n_chunks] = end;
+
+    // Pass 1: count lines per chunk, an upper bound on the atoms it holds
+    #pragma omp parallel for schedule(dynamic)
+    for (int c = 0; c < n_chunks; c++) {
+        size_t lines = 0;
+        for (const char* p = chunk[c]; p < chunk[c + 1]; lines++) {
+            const char* newline = memchr(p, '\n', (size_t)(chunk[c + 1] - p));
+            p = newline ? newline + 1 : chunk[c + 1];
+        }
+        chunk_lines[c + 1] = lines;
+    }
+    for (int c = 0; c < n_chunks; c++) {
+        chunk_lines[c + 1] += chunk_lines[c];
+    }
+
+    Atom* atoms = malloc((chunk_lines[n_chunks] > 0 ? chunk_lines[n_chunks] : 1) * sizeof(Atom));
+    size_t* chunk_atoms = malloc(n_chunks * sizeof(size_t));
+    if (atoms == NULL || chunk_atoms == NULL) {
+        printf("Memory allocation failed for %zu atoms\n", chunk_lines[n_chunks]);
+        exit(EXIT_FAILURE);
+    }
+
+    // Pass 2: parse every chunk into its own slot range; lines that are not atoms are skipped
+    #pragma omp parallel for schedule(dynamic)
+    for (int c = 0; c < n_chunks; c++) {
+        Atom* out = atoms + chunk_lines[c];
+        size_t count = 0;
+        for (const char* p = chunk[c]; p < chunk[c + 1];) {
+            const char* newline = memchr(p, '\n', (size_t)(chunk[c + 1] - p));
+            const char* line_end = newline ? newline : chunk[c + 1];
+            count += parse_atom_line(p, line_end, &out[count]);
+            p = newline ? newline + 1 : chunk[c + 1];
+        }
+        chunk_atoms[c] = count;
+    }
+
+    // Close the gaps left by skipped lines
+    size_t atom_count = 0;
+    for (int c = 0; c < n_chunks; c++) {
+        if (atom_count != chunk_lines[c]) {
+            memmove(atoms + atom_count, atoms + chunk_lines[c], chunk_atoms[c] * sizeof(Atom));
+        }
+        atom_count += chunk_atoms[c];
+    }
+
+    if (size > 0) {
+        munmap((void*)data, size);
+    }
+    free(chunk);
+    free(chunk_lines);
+    free(chunk_atoms);
+
+    *atoms_out = atoms;
+    return atom_count;
+}
@@ -0,0 +1,25 @@
+// File: src/atoms.h
+
+#ifndef ATOMS_H
+#define ATOMS_H
+
+#include <stddef.h>
+
+// Struct to store atom data
+typedef struct {
+    char atom[3];
+    double x, y, z;
+    double mass;
+} Atom;
+
+// Function to parse a floating-point number from [*p, end); returns 0 if there is none
+int parse_double(const char** p, const char* end, double* value);
+
+// Function to parse one "Symbol x y z mass" line from [p, end); returns 0 if it is not an atom
+int parse_atom_line(const char* p, const char* end, Atom* atom);
+
+// Function to load atoms from an input file (a header line, then "Symbol x y z mass" lines);
+// returns the number of atoms and stores the array in *atoms_out
+size_t load_atoms(const char* path, Atom** atoms_out);
+
+#endif // ATOMS_H
@@ -0,0 +1,198 @@
+// File: src/checkpoint.c
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "checkpoint.h"
+#include "neighbor_list.h"
+
+// Binary checkpoint: everything needed to continue a run bit for bit. All fields are little-endian.
+//   "LJCKPT04", uint64 Natoms, int64 step, int32 output interval, binary trajectory flag, r-RESPA steps,
+//   double timestep, cutoff, skin, box[3], btr precision, inner cutoff, switch width (both 0 without
+//   r-RESPA), LJ table intervals, reorder interval, double LJ potential, virial, uint64 input position of
+//   every stored atom, x, y, z, vx, vy, vz, ax, ay, az (Natoms doubles each),
+//   then (r-RESPA only) the outer accelerations ax_slow, ay_slow, az_slow,
+//   uint64 neighbor-list rebuilds, then (cutoff runs) the reference positions of the last rebuild,
+//   uint64 bytes of energies.csv and of the trajectory file written so far,
+//   then (btr only) uint64 frame count, the frame offsets and 3 * Natoms int64 last quantized coordinates.
+// A single-system run draws no random numbers, so there is no RNG state to store.
+static const char checkpoint_magic[8] = { 'L', 'J', 'C', 'K', 'P', 'T', '0', '4' };
+
+// Function to collect the settings a checkpoint must match: int32 layout and double parameters
+static void checkpoint_settings(const RunConfig* cfg, const Simulation* sim, int32_t layout[3], double params[11]) {
+    int respa = cfg->respa_steps > 1;
+    layout[0] = cfg->output_interval;
+    layout[1] = cfg->binary_output;
+    layout[2] = cfg->respa_steps;
+    double values[11] = { cfg->timestep, cfg->cutoff, cfg->skin, sim->box[0], sim->box[1], sim->box[2], cfg->precision,
+                          respa ? cfg->inner_cutoff : 0.0, respa ? cfg->switch_width : 0.0, cfg->lj_table, cfg->reorder };
+    memcpy(params, values, sizeof(values));
+}
+
+// Function to write a checkpoint at the start of step: the output writer is drained first so the
+// recorded file sizes cover exactly steps 0 .. step-1. The file is written to <path>.tmp, flushed to
+// disk and renamed over <path>, so an interrupted write leaves the previous checkpoint intact.
+void write_checkpoint(const RunConfig* cfg, const Simulation* sim, int step, double LJ_potential, OutputWriter* w) {
+    flush_output_writer(w);
+    FILE* trajectory = w->binary != NULL ? w->binary->file : w->trajectory;
+    uint64_t offsets[2] = { (uint64_t)ftell(w->energies), (uint64_t)ftell(trajectory) };
+    fsync(fileno(w->energies));
+    fsync(fileno(trajectory));
+
+    char tmp[sizeof(cfg->checkpoint_file) + 4];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", cfg->checkpoint_file);
+    FILE* file = fopen(tmp, "wb");
+    if (file == NULL) {
+        perror("Error creating checkpoint");
+        exit(EXIT_FAILURE);
+    }
+
+    size_t N = sim->Natoms;
+    uint64_t natoms = N;
+    int64_t step64 = step;
+    int32_t layout[3];
+    double params[11];
+    checkpoint_settings(cfg, sim, layout, params);
+    double energies[2] = { LJ_potential, sim->virial };
+    const double* arrays[12] = { sim->x, sim->y, sim->z, sim->vx, sim->vy, sim->vz, sim->ax, sim->ay, sim->az,
+                                 sim->ax_slow, sim->ay_slow, sim->az_slow };
+    int n_arrays = sim->respa_steps > 1 ? 12 : 9;
+    uint64_t rebuilds = sim->nlist != NULL ? sim->nlist->rebuilds : 0;
+    int ok = fwrite(checkpoint_magic, sizeof(checkpoint_magic), 1, file) == 1 &&
+             fwrite(&natoms, sizeof(natoms), 1, file) == 1 && fwrite(&step64, sizeof(step64), 1, file) == 1 &&
+             fwrite(layout, sizeof(layout), 1, file) == 1 && fwrite(params, sizeof(params), 1, file) == 1 &&
+             fwrite(energies, sizeof(energies), 1, file) == 1;
+    for (size_t i = 0; i < N && ok; i++) {
+        uint64_t id = sim->atom_id != NULL ? sim->atom_id[i] : i;
+        ok = fwrite(&id, sizeof(id), 1, file) == 1;
+    }
+    for (int a = 0; a < n_arrays && ok; a++) {
+        ok = fwrite(arrays[a], sizeof(double), N, file) == N;
+    }
+    ok = ok && fwrite(&rebuilds, sizeof(rebuilds), 1, file) == 1;
+    if (sim->nlist != NULL) {
+        ok = ok && fwrite(sim->nlist->ref_x, sizeof(double), N, file) == N &&
+             fwrite(sim->nlist->ref_y, sizeof(double), N, file) == N &&
+             fwrite(sim->nlist->ref_z, sizeof(double), N, file) == N;
+    }
+    ok = ok && fwrite(offsets, sizeof(offsets), 1, file) == 1;
+    if (w->binary != NULL) {
+        uint64_t n_frames = w->binary->n_frames;
+        ok = ok && fwrite(&n_frames, sizeof(n_frames), 1, file) == 1 &&
+             fwrite(w->binary->index, sizeof(uint64_t), n_frames, file) == n_frames &&
+             fwrite(w->binary->previous, sizeof(int64_t), 3 * N, file) == 3 * N;
+    }
+    ok = ok && fflush(file) == 0 && fsync(fileno(file)) == 0;
+    if (fclose(file) != 0 || !ok || rename(tmp, cfg->checkpoint_file) != 0) {
+        perror("Error writing checkpoint");
+        exit(EXIT_FAILURE);
+    }
+}
+
+// Function to read the input position of every atom of a checkpoint and store the atoms of a freshly
+// initialised simulation in that order. Returns 0 if they are missing or not a permutation.
+static int restore_atom_order(Simulation* sim, FILE* file) {
+    size_t N = sim->Natoms;
+    uint64_t* id = malloc((N > 0 ? N : 1) * sizeof(uint64_t));
+    size_t* slot = malloc((N > 0 ? N : 1) * sizeof(size_t)); // Where each input atom is stored now
+    size_t* order = malloc((N > 0 ? N : 1) * sizeof(size_t));
+    int ok = id != NULL && slot != NULL && order != NULL && fread(id, sizeof(uint64_t), N, file) == N;
+    for (size_t i = 0; i < N && ok; i++) {
+        slot[sim->atom_id != NULL ? sim->atom_id[i] : i] = i;
+    }
+    int moved = 0;
+    for (size_t k = 0; k < N && ok; k++) {
+        ok = id[k] < N && slot[id[k]] != SIZE_MAX; // Every input position exactly once
+        if (ok) {
+            order[k] = slot[id[k]];
+            slot[id[k]] = SIZE_MAX;
+            moved |= order[k] != k;
+        }
+    }
+    if (ok && moved) {
+        permute_atoms(sim, order);
+    }
+    free(id);
+    free(slot);
+    free(order);
+    return ok;
+}
+
+// Function to load a checkpoint into a freshly initialised simulation. Checks that it belongs to the
+// same run settings, restores the state (and the neighbor list exactly as it was last built), and
+// returns the step to continue from; the output file sizes go to offsets and, for a btr run,
+// the frame index and last frame to *binary_state. Returns -1 if the checkpoint cannot be used.
+int read_checkpoint(const RunConfig* cfg, Simulation* sim, double* LJ_potential, uint64_t offsets[2],
+                    BinaryTrajectory* binary_state) {
+    FILE* file = fopen(cfg->checkpoint_file, "rb");
+    if (file == NULL) {
+        perror("Error opening checkpoint");
+        return -1;
+    }
+
+    size_t N = sim->Natoms;
+    char magic[8];
+    uint64_t natoms, rebuilds;
+    int64_t step;
+    int32_t layout[3], expected_layout[3];
+    double params[11], expected[11], energies[2];
+    int ok = fread(magic, sizeof(magic), 1, file) == 1 && memcmp(magic, checkpoint_magic, sizeof(magic)) == 0 &&
+             fread(&natoms, sizeof(natoms), 1, file) == 1 && fread(&step, sizeof(step), 1, file) == 1 &&
+             fread(layout, sizeof(layout), 1, file) == 1 && fread(params, sizeof(params), 1, file) == 1 &&
+             fread(energies, sizeof(energies), 1, file) == 1;
+    if (!ok) {
+        printf("'%s' is not a checkpoint\n", cfg->checkpoint_file);
+        fclose(file);
+        return -1;
+    }
+    checkpoint_settings(cfg, sim, expected_layout, expected);
+    if (natoms != N || memcmp(layout, expected_layout, sizeof(layout)) != 0 ||
+        memcmp(params, expected, sizeof(params)) != 0) {
+        printf("Checkpoint '%s' was written with different run settings\n", cfg->checkpoint_file);
+        fclose(file);
+        return -1;
+    }
+
+    // Atoms reordered since the start are put back in the order they were stored in
+    ok = restore_atom_order(sim, file);
+    double* arrays[12] = { sim->x, sim->y, sim->z, sim->vx, sim->vy, sim->vz, sim->ax, sim->ay, sim->az,
+                           sim->ax_slow, sim->ay_slow, sim->az_slow };
+    int n_arrays = sim->respa_steps > 1 ? 12 : 9;
+    for (int a = 0; a < n_arrays && ok; a++) {
+        ok = fread(arrays[a], sizeof(double), N, file) == N;
+    }
+    ok = ok && fread(&rebuilds, sizeof(rebuilds), 1, file) == 1;
+    if (sim->nlist != NULL && ok) {
+        // Rebuild from the positions of the last rebuild, giving the same list in the same order;
+        // ax_new/ay_new/az_new are free until the next force evaluation
+        ok = fread(sim->ax_new, sizeof(double), N, file) == N && fread(sim->ay_new, sizeof(double), N, file) == N &&
+             fread(sim->az_new, sizeof(double), N, file) == N;
+        if (ok && rebuilds > 0) {
+            build_neighbor_list(sim->nlist, N, sim->ax_new, sim->ay_new, sim->az_new, sim->box);
+        }
+        sim->nlist->rebuilds = rebuilds;
+    }
+    ok = ok && fread(offsets, sizeof(uint64_t), 2, file) == 2;
+    if (cfg->binary_output && ok) {
+        uint64_t n_frames;
+        ok = fread(&n_frames, sizeof(n_frames), 1, file) == 1;
+        binary_state->n_frames = ok ? n_frames : 0;
+        binary_state->index_capacity = binary_state->n_frames + 64;
+        binary_state->index = malloc(binary_state->index_capacity * sizeof(uint64_t));
+        binary_state->previous = malloc(3 * N * sizeof(int64_t));
+        ok = ok && binary_state->index != NULL && binary_state->previous != NULL &&
+             fread(binary_state->index, sizeof(uint64_t), n_frames, file) == n_frames &&
+             fread(binary_state->previous, sizeof(int64_t), 3 * N, file) == 3 * N;
+    }
+    fclose(file);
+    if (!ok) {
+        printf("Checkpoint '%s' is truncated\n", cfg->checkpoint_file);
+        return -1;
+    }
+
+    *LJ_potential = energies[0];
+    sim->virial = energies[1];
+    return (int)step;
+}
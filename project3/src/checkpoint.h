@@ -0,0 +1,20 @@
+// File: src/checkpoint.h
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stdint.h>
+#include "config.h"
+#include "output_writer.h"
+#include "simulation.h"
+#include "trajectory.h"
+
+// Function to write a checkpoint at the start of step, atomically through <path>.tmp
+void write_checkpoint(const RunConfig* cfg, const Simulation* sim, int step, double LJ_potential, OutputWriter* w);
+
+// Function to load a checkpoint into a freshly initialised simulation; returns the step to continue from,
+// or -1 if the checkpoint cannot be used
+int read_checkpoint(const RunConfig* cfg, Simulation* sim, double* LJ_potential, uint64_t offsets[2],
+                    BinaryTrajectory* binary_state);
+
+#endif // CHECKPOINT_H
@@ -0,0 +1,183 @@
+// File: src/config.c
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "config.h"
+
+// Function to fill a run configuration with the defaults
+void default_run_config(RunConfig* cfg) {
+    memset(cfg, 0, sizeof(*cfg));
+    strcpy(cfg->input_file, "inp.txt");
+    cfg->total_steps = DEFAULT_STEPS;
+    cfg->timestep = DEFAULT_TIMESTEP;
+    cfg->output_interval = DEFAULT_OUTPUT_INTERVAL;
+    cfg->skin = DEFAULT_SKIN;
+    strcpy(cfg->simd, "auto");
+    cfg->precision = DEFAULT_PRECISION;
+    cfg->output_buffers = DEFAULT_OUTPUT_BUFFERS;
+    cfg->checkpoint_interval = 100;
+    cfg->respa_steps = 1;
+    cfg->inner_cutoff = DEFAULT_INNER_CUTOFF;
+    cfg->switch_width = DEFAULT_SWITCH_WIDTH;
+    strcpy(cfg->ensemble_dir, "ensemble");
+    cfg->seed = 1;
+}
+
+// Function to copy a string setting, refusing values that do not fit
+static int set_string(char* dest, size_t size, const char* value) {
+    if (strlen(value) >= size) return 0;
+    strcpy(dest, value);
+    return 1;
+}
+
+// Function to add the LJ parameters of one species ("Kr 0.317 0.3633") or, with pair, of one pair of
+// species ("Ar Kr 0.12 0.35"). A later entry for the same species (or pair, in either order) replaces
+// the earlier one. Returns 0 for an invalid value or when the list is full.
+static int add_species_params(RunConfig* cfg, const char* value, int pair) {
+    SpeciesParams p;
+    memset(&p, 0, sizeof(p));
+    int length = 0;
+    int n = pair ? sscanf(value, "%2s %2s %lf %lf %n", p.symbol[0], p.symbol[1], &p.epsilon, &p.sigma, &length)
+                 : sscanf(value, "%2s %lf %lf %n", p.symbol[0], &p.epsilon, &p.sigma, &length);
+    if (n != (pair ? 4 : 3) || value[length] != '\0' || p.epsilon < 0.0 || p.sigma <= 0.0 ||
+        (pair && strcmp(p.symbol[0], p.symbol[1]) == 0)) {
+        return 0;
+    }
+    SpeciesParams* list = pair ? cfg->species_pairs : cfg->species;
+    int* count = pair ? &cfg->n_species_pairs : &cfg->n_species;
+    int capacity = pair ? MAX_SPECIES * (MAX_SPECIES - 1) / 2 : MAX_SPECIES;
+    int k;
+    for (k = 0; k < *count; k++) {
+        const SpeciesParams* q = &list[k];
+        int same = strcmp(q->symbol[0], p.symbol[0]) == 0 && strcmp(q->symbol[1], p.symbol[1]) == 0;
+        int swapped = strcmp(q->symbol[0], p.symbol[1]) == 0 && strcmp(q->symbol[1], p.symbol[0]) == 0;
+        if (same || (pair && swapped)) break;
+    }
+    if (k == capacity) {
+        return 0;
+    }
+    list[k] = p;
+    *count += k == *count;
+    return 1;
+}
+
+// Function to set one run setting from its text value. The key is the config-file name
+// ("output_interval"); command-line options use the same name with dashes ("--output-interval").
+// Returns 1 on success, 0 for an invalid value and -1 for an unknown key.
+int set_run_option(RunConfig* cfg, const char* key, const char* value) {
+    char* end;
+    if (strcmp(key, "input") == 0) {
+        return set_string(cfg->input_file, sizeof(cfg->input_file), value);
+    } else if (strcmp(key, "steps") == 0) {
+        cfg->total_steps = (int)strtol(value, &end, 10);
+        return *end == '\0' && cfg->total_steps >= 0;
+    } else if (strcmp(key, "timestep") == 0) {
+        cfg->timestep = strtod(value, &end);
+        return *end == '\0' && cfg->timestep > 0.0;
+    } else if (strcmp(key, "output_interval") == 0) {
+        cfg->output_interval = (int)strtol(value, &end, 10);
+        return *end == '\0' && cfg->output_interval > 0;
+    } else if (strcmp(key, "cutoff") == 0) {
+        cfg->cutoff = strtod(value, &end);
+        return *end == '\0' && cfg->cutoff >= 0.0;
+    } else if (strcmp(key, "skin") == 0) {
+        cfg->skin = strtod(value, &end);
+        return *end == '\0' && cfg->skin >= 0.0;
+    } else if (strcmp(key, "box") == 0) {
+        return sscanf(value, "%lf %lf %lf", &cfg->box[0], &cfg->box[1], &cfg->box[2]) == 3;
+    } else if (strcmp(key, "threads") == 0) {
+        cfg->n_threads = (int)strtol(value, &end, 10);
+        return *end == '\0' && cfg->n_threads >= 1;
+    } else if (strcmp(key, "simd") == 0) {
+        return set_string(cfg->simd, sizeof(cfg->simd), value);
+    } else if (strcmp(key, "species") == 0 || strcmp(key, "species_pair") == 0) {
+        return add_species_params(cfg, value, strcmp(key, "species_pair") == 0);
+    } else if (strcmp(key, "lj_table") == 0) {
+        cfg->lj_table = (int)strtol(value, &end, 10);
+        return *end == '\0' && cfg->lj_table >= 0;
+    } else if (strcmp(key, "reorder") == 0) {
+        cfg->reorder = (int)strtol(value, &end, 10);
+        return *end == '\0' && cfg->reorder >= 0;
+    } else if (strcmp(key, "trajectory") == 0) {
+        cfg->binary_output = strcmp(value, "btr") == 0;
+        return cfg->binary_output || strcmp(value, "xyz") == 0;
+    } else if (strcmp(key, "precision") == 0) {
+        cfg->precision = strtod(value, &end);
+        return *end == '\0' && cfg->precision > 0.0;
+    } else if (strcmp(key, "output_buffers") == 0) {
+        cfg->output_buffers = (int)strtol(value, &end, 10);
+        return *end == '\0' && cfg->output_buffers >= 0;
+    } else if (strcmp(key, "checkpoint") == 0) {
+        return set_string(cfg->checkpoint_file, sizeof(cfg->checkpoint_file), value);
+    } else if (strcmp(key, "checkpoint_interval") == 0) {
+        cfg->checkpoint_interval = (int)strtol(value, &end, 10);
+        return *end == '\0' && cfg->checkpoint_interval > 0;
+    } else if (strcmp(key, "respa") == 0) {
+        cfg->respa_steps = (int)strtol(value, &end, 10);
+        return *end == '\0' && cfg->respa_steps >= 1;
+    } else if (strcmp(key, "inner_cutoff") == 0) {
+        cfg->inner_cutoff = strtod(value, &end);
+        return *end == '\0' && cfg->inner_cutoff > 0.0;
+    } else if (strcmp(key, "switch_width") == 0) {
+        cfg->switch_width = strtod(value, &end);
+        return *end == '\0' && cfg->switch_width > 0.0;
+    } else if (strcmp(key, "ensemble") == 0) {
+        cfg->ensemble = (int)strtol(value, &end, 10);
+        return *end == '\0' && cfg->ensemble >= 0;
+    } else if (strcmp(key, "ensemble_dir") == 0) {
+        return set_string(cfg->ensemble_dir, sizeof(cfg->ensemble_dir), value);
+    } else if (strcmp(key, "perturb") == 0) {
+        cfg->perturb = strtod(value, &end);
+        return *end == '\0' && cfg->perturb >= 0.0;
+    } else if (strcmp(key, "temperature") == 0) {
+        cfg->temperature = strtod(value, &end);
+        return *end == '\0' && cfg->temperature >= 0.0;
+    } else if (strcmp(key, "seed") == 0) {
+        cfg->seed = strtol(value, &end, 10);
+        return *end == '\0';
+    }
+    return -1;
+}
+
+// Function to read a run-configuration file of "key = value" lines; '#' starts a comment.
+// Returns 0 (after printing the offending line) if the file is missing or invalid.
+int read_run_config(const char* path, RunConfig* cfg) {
+    FILE* file = fopen(path, "r");
+    if (file == NULL) {
+        perror("Error opening run configuration");
+        return 0;
+    }
+
+    char line[2048];
+    int line_number = 0, ok = 1;
+    while (ok && fgets(line, sizeof(line), file) != NULL) {
+        line_number++;
+        char* hash = strchr(line, '#');
+        if (hash != NULL) *hash = '\0';
+
+        // Split at '=' (or the first blank) and trim both sides
+        char* key = line;
+        while (*key == ' ' || *key == '\t') key++;
+        char* value = key + strcspn(key, "= \t\r\n");
+        if (*key == '\0' || *key == '\n' || *key == '\r') continue;
+        char* key_end = value;
+        value += strspn(value, " \t");
+        if (*value == '=') value++;
+        value += strspn(value, " \t");
+        *key_end = '\0';
+        char* value_end = value + strlen(value);
+        while (value_end > value && (value_end[-1] == ' ' || value_end[-1] == '\t' ||
+                                     value_end[-1] == '\r' || value_end[-1] == '\n')) {
+            *--value_end = '\0';
+        }
+
+        int status = set_run_option(cfg, key, value);
+        if (status != 1) {
+            printf("%s:%d: %s '%s'\n", path, line_number, status < 0 ? "unknown setting" : "invalid value for", key);
+            ok = 0;
+        }
+    }
+    fclose(file);
+    return ok;
+}
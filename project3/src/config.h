@@ -0,0 +1,67 @@
+// File: src/config.h
+
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include "simulation.h"
+
+#define DEFAULT_STEPS 1000 // Total simulation steps
+#define DEFAULT_OUTPUT_INTERVAL 10 // Interval for writing output
+#define DEFAULT_TIMESTEP 0.2 // Time step for simulation
+#define DEFAULT_SKIN 0.1 // Verlet neighbor-list skin (in nm)
+#define DEFAULT_PRECISION 0.001 // Coordinate quantum of the binary trajectory (in nm)
+#define DEFAULT_OUTPUT_BUFFERS 4 // Output blocks queued for the writer thread before the integrator waits
+#define DEFAULT_INNER_CUTOFF 0.5 // r-RESPA: end of the short-range force (in nm)
+#define DEFAULT_SWITCH_WIDTH 0.1 // r-RESPA: width of the switching region before it (in nm)
+
+// LJ parameters given for one species ("species = Kr 0.317 0.3633") or for one pair of unlike species
+// ("species_pair = Ar Kr 0.12 0.35"); epsilon in kcal/mol, sigma in nm
+typedef struct {
+    char symbol[2][3];  // The species; the second is empty for a single one
+    double epsilon;
+    double sigma;
+} SpeciesParams;
+
+// Run settings. Defaults first, then a --config file, then command-line options, later ones winning.
+typedef struct {
+    char input_file[1024];
+    int total_steps;
+    double timestep;
+    int output_interval;
+    double cutoff;
+    double skin;
+    double box[3];
+    int n_threads;
+    char simd[16];
+    int lj_table;               // Intervals of the tabulated LJ pair, 0 for the analytic formula
+    int reorder;                // Neighbor-list rebuilds between two Morton reorderings of the atoms, 0 = never
+    int binary_output;
+    double precision;
+    int output_buffers;
+    char checkpoint_file[1024]; // Empty: no checkpoints
+    int checkpoint_interval;    // Steps between two checkpoints
+    int respa_steps;            // r-RESPA inner steps per time step, 1 for velocity Verlet
+    double inner_cutoff;
+    double switch_width;
+    int ensemble;               // Number of replicas in ensemble mode, 0 for a single system
+    char ensemble_dir[1024];    // Directory of the per-replica outputs
+    double perturb;             // Random displacement of every replica coordinate, up to this (in nm)
+    double temperature;         // Maxwell-Boltzmann starting velocities of the replicas (in K), 0 = at rest
+    long seed;                  // Seed of the replica random streams
+    SpeciesParams species[MAX_SPECIES];     // LJ parameters per species, EPSILON and SIGMA for the others
+    int n_species;
+    SpeciesParams species_pairs[MAX_SPECIES * (MAX_SPECIES - 1) / 2]; // Explicit unlike pairs, else mixed
+    int n_species_pairs;
+} RunConfig;
+
+// Function to fill a run configuration with the defaults
+void default_run_config(RunConfig* cfg);
+
+// Function to set one run setting from its text value; returns 1 on success, 0 for an invalid value
+// and -1 for an unknown key
+int set_run_option(RunConfig* cfg, const char* key, const char* value);
+
+// Function to read a run-configuration file of "key = value" lines; returns 0 if it is missing or invalid
+int read_run_config(const char* path, RunConfig* cfg);
+
+#endif // CONFIG_H
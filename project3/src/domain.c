@@ -0,0 +1,813 @@
+// File: src/domain.c
+
+#ifdef USE_MPI
+#include <mpi.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "domain.h"
+#include "forces.h"
+#include "integrator.h"
+#include "output_writer.h"
+#include "species.h"
+#include "trajectory.h"
+#include "util.h"
+
+// MPI domain decomposition of a periodic box. The box is cut into a grid of equal domains, one per rank.
+// A rank owns the atoms inside its domain and keeps copies (ghosts) of the atoms of the 26 surrounding
+// domains that lie within cutoff + skin of its faces. They are stored after its own atoms and shifted to
+// the periodic image next to the domain, so the pair loops need no minimum image. Ownership and the ghost
+// set only change when the neighbor list is rebuilt: atoms that left the domain then migrate to their new
+// owner. On every other step only the ghost positions travel, straight to each of the 26 neighbors, while
+// the rank computes the pairs among its own atoms. A pair with a ghost is computed by both ranks involved;
+// each keeps the force on its own atom and half the energy, so no forces have to be sent back.
+#define N_DIRECTIONS 26 // Neighbor domains: 6 faces, 12 edges and 8 corners
+
+// One atom on its way to another rank. Sent as raw bytes, so all ranks must run on the same architecture.
+typedef struct {
+    int64_t id;         // Index in the input file
+    double state[9];    // x, y, z, vx, vy, vz, ax, ay, az
+    double mass;
+    char symbol[3];
+    int type;           // LJ type, 0 for a single species
+} MigratingAtom;
+
+// The domain of this rank, its communication pattern and the pair list of its atoms
+typedef struct {
+    MPI_Comm comm;                  // Periodic Cartesian communicator of all ranks
+    int rank, n_ranks;
+    int dims[3], coords[3];         // Domain grid, and the place of this rank in it
+    double width[3];                // Domain size (in nm)
+    double halo;                    // Ghost shell width: cutoff + skin (in nm)
+    int neighbor[N_DIRECTIONS];     // Rank of the neighbor domain in every direction
+    int offset[N_DIRECTIONS][3];    // The direction: -1, 0 or 1 along each axis
+    double shift[N_DIRECTIONS][3];  // Added to positions sent that way, for the image next to the receiver
+    size_t n_local, n_ghost;        // Own atoms, then ghosts, in the Simulation arrays
+    size_t capacity;                // Allocated length of the per-atom arrays
+    int64_t* id;                    // Input index of every own atom
+    int* send_atoms;                // Own atoms sent as ghosts, direction by direction
+    size_t send_start[N_DIRECTIONS + 1];
+    size_t recv_start[N_DIRECTIONS + 1]; // Ghost slots filled from every direction, counted from n_local
+    size_t send_capacity;
+    double* send_buffer;            // 3 coordinates per sent atom
+    double* recv_buffer;            // 3 coordinates per ghost
+    double* gather_buffer;          // Input index and coordinates of every own atom, for the frames
+    MPI_Request requests[2 * N_DIRECTIONS];
+    size_t* row_start;              // Pairs of own atom i: [row_start[i], halo_start[i]) with own atoms,
+    size_t* halo_start;             // then [halo_start[i], row_start[i + 1]) with ghosts
+    int* pairs;
+    size_t pair_capacity;
+    double t_force, t_wait, t_rebuild, t_output; // Wall time spent in every phase (in s)
+} Domain;
+
+// Directions are numbered in lexicographic order of their offsets, so the opposite of d is 25 - d
+static inline int opposite_direction(int d) {
+    return N_DIRECTIONS - 1 - d;
+}
+
+// Function to stop every rank after an error on one of them
+static void abort_domains(const Domain* dom, const char* message) {
+    printf("Rank %d: %s\n", dom->rank, message);
+    MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+}
+
+// Function to return a larger copy of an aligned array, keeping its first n values
+static double* grow_aligned(double* a, size_t n, size_t capacity) {
+    double* grown = malloc_aligned(capacity);
+    if (grown == NULL) {
+        return NULL;
+    }
+    if (n > 0) {
+        memcpy(grown, a, n * sizeof(double));
+    }
+    free(a);
+    return grown;
+}
+
+// Function to make room for n own and ghost atoms. The own atoms are kept; ghosts, forces and the
+// neighbor list are refilled after every call.
+static void reserve_domain(Simulation* sim, Domain* dom, size_t n) {
+    if (n <= dom->capacity) {
+        return;
+    }
+    size_t capacity = n + n / 2;
+    double** arrays[] = { &sim->x, &sim->y, &sim->z, &sim->vx, &sim->vy, &sim->vz, &sim->ax, &sim->ay, &sim->az,
+                          &sim->ax_new, &sim->ay_new, &sim->az_new, &sim->mass };
+    int failed = 0;
+    for (size_t a = 0; a < sizeof(arrays) / sizeof(arrays[0]); a++) {
+        *arrays[a] = grow_aligned(*arrays[a], dom->n_local, capacity);
+        failed |= *arrays[a] == NULL;
+    }
+    sim->symbol = realloc(sim->symbol, capacity * sizeof(*sim->symbol));
+    if (sim->type != NULL) {
+        sim->type = realloc(sim->type, capacity * sizeof(int));
+        failed |= sim->type == NULL;
+    }
+    dom->id = realloc(dom->id, capacity * sizeof(int64_t));
+    free(sim->thread_forces);
+    sim->thread_forces = NULL;
+    if (sim->n_threads > 1) {
+        sim->thread_forces = malloc_aligned(3 * capacity * (size_t)(sim->n_threads - 1));
+        failed |= sim->thread_forces == NULL;
+    }
+    free(dom->recv_buffer);
+    free(dom->gather_buffer);
+    dom->recv_buffer = malloc_aligned(3 * capacity);
+    dom->gather_buffer = malloc_aligned(4 * capacity);
+    dom->row_start = realloc(dom->row_start, (capacity + 1) * sizeof(size_t));
+    dom->halo_start = realloc(dom->halo_start, capacity * sizeof(size_t));
+    if (failed || sim->symbol == NULL || dom->id == NULL || dom->recv_buffer == NULL || dom->gather_buffer == NULL ||
+        dom->row_start == NULL || dom->halo_start == NULL) {
+        abort_domains(dom, "Memory allocation failed for the domain atoms");
+    }
+
+    size_t rebuilds = sim->nlist->rebuilds;
+    free_neighbor_list(sim->nlist);
+    init_neighbor_list(sim->nlist, capacity, sim->nlist->cutoff, sim->nlist->skin);
+    sim->nlist->rebuilds = rebuilds;
+    dom->capacity = capacity;
+}
+
+// Function to find the direction of the domain that owns a wrapped position: -1 for this domain,
+// -2 if it is not a neighbor
+static int owner_direction(const Domain* dom, double x, double y, double z) {
+    double r[3] = { x, y, z };
+    int offset[3];
+    for (int dim = 0; dim < 3; dim++) {
+        int c = (int)(r[dim] / dom->width[dim]);
+        if (c >= dom->dims[dim]) c = dom->dims[dim] - 1;
+        int delta = ((c - dom->coords[dim]) % dom->dims[dim] + dom->dims[dim]) % dom->dims[dim];
+        if (delta == 0) {
+            offset[dim] = 0;
+        } else if (delta == 1) {
+            offset[dim] = 1;
+        } else if (delta == dom->dims[dim] - 1) {
+            offset[dim] = -1;
+        } else {
+            return -2;
+        }
+    }
+    int k = (offset[0] + 1) * 9 + (offset[1] + 1) * 3 + (offset[2] + 1);
+    return k == 13 ? -1 : (k < 13 ? k : k - 1);
+}
+
+// Function to send count[d] items of item_size bytes from send + start[d] to neighbor d, and receive the
+// items the opposite neighbor sent in direction d into recv + recv_start[d]. Non-blocking: the caller
+// waits for the 2 * N_DIRECTIONS requests.
+static void post_exchange(Domain* dom, const void* send, const size_t send_start[], void* recv,
+                          const size_t recv_start[], size_t item_size, MPI_Request* requests) {
+    for (int d = 0; d < N_DIRECTIONS; d++) {
+        size_t count = recv_start[d + 1] - recv_start[d];
+        requests[d] = MPI_REQUEST_NULL;
+        if (count > 0) {
+            MPI_Irecv((char*)recv + recv_start[d] * item_size, (int)(count * item_size), MPI_BYTE,
+                      dom->neighbor[opposite_direction(d)], d, dom->comm, &requests[d]);
+        }
+    }
+    for (int d = 0; d < N_DIRECTIONS; d++) {
+        size_t count = send_start[d + 1] - send_start[d];
+        requests[N_DIRECTIONS + d] = MPI_REQUEST_NULL;
+        if (count > 0) {
+            MPI_Isend((const char*)send + send_start[d] * item_size, (int)(count * item_size), MPI_BYTE,
+                      dom->neighbor[d], d, dom->comm, &requests[N_DIRECTIONS + d]);
+        }
+    }
+}
+
+// Function to tell every neighbor how many items it gets from this rank, and to turn the counts received
+// into offsets: recv_start[d] is where the items arriving in direction d start
+static void exchange_counts(Domain* dom, const size_t send_start[], size_t recv_start[]) {
+    uint64_t send_count[N_DIRECTIONS], recv_count[N_DIRECTIONS];
+    MPI_Request requests[2 * N_DIRECTIONS];
+    for (int d = 0; d < N_DIRECTIONS; d++) {
+        send_count[d] = send_start[d + 1] - send_start[d];
+        MPI_Irecv(&recv_count[d], 1, MPI_UINT64_T, dom->neighbor[opposite_direction(d)], d, dom->comm, &requests[d]);
+    }
+    for (int d = 0; d < N_DIRECTIONS; d++) {
+        MPI_Isend(&send_count[d], 1, MPI_UINT64_T, dom->neighbor[d], d, dom->comm, &requests[N_DIRECTIONS + d]);
+    }
+    MPI_Waitall(2 * N_DIRECTIONS, requests, MPI_STATUSES_IGNORE);
+    recv_start[0] = 0;
+    for (int d = 0; d < N_DIRECTIONS; d++) {
+        recv_start[d + 1] = recv_start[d] + recv_count[d];
+    }
+}
+
+// Function to wrap the own atoms into the box and hand those that left the domain to their new owner.
+// Between two rebuilds no atom moves farther than a domain, so the new owner is always a neighbor.
+static void migrate_atoms(Simulation* sim, Domain* dom) {
+    size_t n = dom->n_local;
+    double* coord[3] = { sim->x, sim->y, sim->z };
+    double** arrays[] = { &sim->x, &sim->y, &sim->z, &sim->vx, &sim->vy, &sim->vz, &sim->ax, &sim->ay, &sim->az, &sim->mass };
+    int* direction = malloc((n > 0 ? n : 1) * sizeof(int));
+    size_t send_start[N_DIRECTIONS + 1] = { 0 }, recv_start[N_DIRECTIONS + 1];
+    if (direction == NULL) {
+        abort_domains(dom, "Memory allocation failed for the atom migration");
+    }
+    for (size_t i = 0; i < n; i++) {
+        for (int dim = 0; dim < 3; dim++) {
+            coord[dim][i] = wrap_coordinate(coord[dim][i], sim->box[dim]);
+        }
+        direction[i] = owner_direction(dom, sim->x[i], sim->y[i], sim->z[i]);
+        if (direction[i] == -2) {
+            abort_domains(dom, "an atom moved farther than a domain between two neighbor-list rebuilds");
+        }
+        if (direction[i] >= 0) {
+            send_start[direction[i] + 1]++;
+        }
+    }
+    for (int d = 0; d < N_DIRECTIONS; d++) {
+        send_start[d + 1] += send_start[d];
+    }
+
+    // Pack the leaving atoms by direction and close the gaps they leave, keeping the order
+    MigratingAtom* leaving = malloc((send_start[N_DIRECTIONS] + 1) * sizeof(MigratingAtom));
+    size_t fill[N_DIRECTIONS];
+    memcpy(fill, send_start, sizeof(fill));
+    if (leaving == NULL) {
+        abort_domains(dom, "Memory allocation failed for the atom migration");
+    }
+    size_t kept = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (direction[i] >= 0) {
+            MigratingAtom* atom = &leaving[fill[direction[i]]++];
+            memset(atom, 0, sizeof(*atom));
+            atom->id = dom->id[i];
+            for (int a = 0; a < 9; a++) {
+                atom->state[a] = (*arrays[a])[i];
+            }
+            atom->mass = sim->mass[i];
+            memcpy(atom->symbol, sim->symbol[i], sizeof(atom->symbol));
+            atom->type = sim->type != NULL ? sim->type[i] : 0;
+            continue;
+        }
+        for (size_t a = 0; a < sizeof(arrays) / sizeof(arrays[0]); a++) {
+            (*arrays[a])[kept] = (*arrays[a])[i];
+        }
+        memcpy(sim->symbol[kept], sim->symbol[i], sizeof(sim->symbol[kept]));
+        if (sim->type != NULL) {
+            sim->type[kept] = sim->type[i];
+        }
+        dom->id[kept] = dom->id[i];
+        kept++;
+    }
+    free(direction);
+
+    // Receive the arriving atoms and append them
+    exchange_counts(dom, send_start, recv_start);
+    size_t arrived = recv_start[N_DIRECTIONS];
+    MigratingAtom* arriving = malloc((arrived + 1) * sizeof(MigratingAtom));
+    if (arriving == NULL) {
+        abort_domains(dom, "Memory allocation failed for the atom migration");
+    }
+    MPI_Request requests[2 * N_DIRECTIONS];
+    post_exchange(dom, leaving, send_start, arriving, recv_start, sizeof(MigratingAtom), requests);
+    MPI_Waitall(2 * N_DIRECTIONS, requests, MPI_STATUSES_IGNORE);
+    dom->n_local = kept;
+    reserve_domain(sim, dom, kept + arrived);
+    for (size_t k = 0; k < arrived; k++) {
+        size_t i = kept + k;
+        const MigratingAtom* atom = &arriving[k];
+        dom->id[i] = atom->id;
+        for (int a = 0; a < 9; a++) {
+            (*arrays[a])[i] = atom->state[a];
+        }
+        sim->mass[i] = atom->mass;
+        memcpy(sim->symbol[i], atom->symbol, sizeof(sim->symbol[i]));
+        if (sim->type != NULL) {
+            sim->type[i] = atom->type;
+        }
+    }
+    dom->n_local = kept + arrived;
+    free(leaving);
+    free(arriving);
+}
+
+// Function to choose the ghosts after a migration: every own atom within the halo of a face, edge or
+// corner is sent that way, and the counts the neighbors send back fix the ghost slots
+static void setup_halo(Simulation* sim, Domain* dom) {
+    size_t n = dom->n_local;
+    const double* coord[3] = { sim->x, sim->y, sim->z };
+    size_t total = 0;
+    for (int d = 0; d < N_DIRECTIONS; d++) {
+        dom->send_start[d] = total;
+        for (size_t i = 0; i < n; i++) {
+            int inside = 1;
+            for (int dim = 0; dim < 3; dim++) {
+                double lo = dom->coords[dim] * dom->width[dim];
+                if (dom->offset[d][dim] > 0) inside &= coord[dim][i] >= lo + dom->width[dim] - dom->halo;
+                if (dom->offset[d][dim] < 0) inside &= coord[dim][i] < lo + dom->halo;
+            }
+            if (!inside) continue;
+            if (total == dom->send_capacity) {
+                dom->send_capacity = 2 * dom->send_capacity + 1024;
+                dom->send_atoms = realloc(dom->send_atoms, dom->send_capacity * sizeof(int));
+                free(dom->send_buffer);
+                dom->send_buffer = malloc_aligned(3 * dom->send_capacity);
+                if (dom->send_atoms == NULL || dom->send_buffer == NULL) {
+                    abort_domains(dom, "Memory allocation failed for the halo");
+                }
+            }
+            dom->send_atoms[total++] = (int)i;
+        }
+    }
+    dom->send_start[N_DIRECTIONS] = total;
+
+    exchange_counts(dom, dom->send_start, dom->recv_start);
+    dom->n_ghost = dom->recv_start[N_DIRECTIONS];
+    reserve_domain(sim, dom, n + dom->n_ghost);
+    for (size_t g = n; g < n + dom->n_ghost; g++) {
+        sim->mass[g] = 1.0; // Ghost forces are scratch; any mass will do for the reduction
+    }
+    sim->Natoms = n + dom->n_ghost;
+
+    // A mixture also needs the types of the ghosts, which only change here
+    if (sim->type != NULL) {
+        int* send_type = malloc((total + 1) * sizeof(int));
+        if (send_type == NULL) {
+            abort_domains(dom, "Memory allocation failed for the halo");
+        }
+        for (size_t k = 0; k < total; k++) {
+            send_type[k] = sim->type[dom->send_atoms[k]];
+        }
+        MPI_Request requests[2 * N_DIRECTIONS];
+        post_exchange(dom, send_type, dom->send_start, sim->type + n, dom->recv_start, sizeof(int), requests);
+        MPI_Waitall(2 * N_DIRECTIONS, requests, MPI_STATUSES_IGNORE);
+        free(send_type);
+    }
+}
+
+// Function to send the current positions of the atoms that are ghosts elsewhere. finish_halo_exchange
+// waits for the positions of this rank's ghosts and stores them.
+static void start_halo_exchange(const Simulation* sim, Domain* dom) {
+    for (int d = 0; d < N_DIRECTIONS; d++) {
+        for (size_t k = dom->send_start[d]; k < dom->send_start[d + 1]; k++) {
+            int i = dom->send_atoms[k];
+            dom->send_buffer[3 * k] = sim->x[i] + dom->shift[d][0];
+            dom->send_buffer[3 * k + 1] = sim->y[i] + dom->shift[d][1];
+            dom->send_buffer[3 * k + 2] = sim->z[i] + dom->shift[d][2];
+        }
+    }
+    post_exchange(dom, dom->send_buffer, dom->send_start, dom->recv_buffer, dom->recv_start, 3 * sizeof(double),
+                  dom->requests);
+}
+
+static void finish_halo_exchange(Simulation* sim, Domain* dom) {
+    MPI_Waitall(2 * N_DIRECTIONS, dom->requests, MPI_STATUSES_IGNORE);
+    for (size_t k = 0; k < dom->n_ghost; k++) {
+        sim->x[dom->n_local + k] = dom->recv_buffer[3 * k];
+        sim->y[dom->n_local + k] = dom->recv_buffer[3 * k + 1];
+        sim->z[dom->n_local + k] = dom->recv_buffer[3 * k + 2];
+    }
+}
+
+// Function to turn the half list over own and ghost atoms into rows of the own atoms: own partners first
+// (each such pair once), then ghost partners. Pairs between two ghosts belong to other ranks and are dropped.
+static void split_domain_pairs(Domain* dom, const NeighborList* nl) {
+    size_t n = dom->n_local, n_all = n + dom->n_ghost;
+    size_t* own_count = calloc(2 * n + 1, sizeof(size_t));
+    if (own_count == NULL) {
+        abort_domains(dom, "Memory allocation failed for the pair list");
+    }
+    size_t* ghost_count = own_count + n;
+    for (size_t i = 0; i < n_all; i++) {
+        for (size_t k = nl->start[i]; k < nl->start[i + 1]; k++) {
+            size_t j = (size_t)nl->neighbors[k];
+            if (i < n && j < n) {
+                own_count[i]++;
+            } else if (i < n) {
+                ghost_count[i]++;
+            } else if (j < n) {
+                ghost_count[j]++;
+            }
+        }
+    }
+    dom->row_start[0] = 0;
+    for (size_t i = 0; i < n; i++) {
+        dom->halo_start[i] = dom->row_start[i] + own_count[i];
+        dom->row_start[i + 1] = dom->halo_start[i] + ghost_count[i];
+        own_count[i] = dom->row_start[i]; // From here on: where the next pair of the row goes
+        ghost_count[i] = dom->halo_start[i];
+    }
+    if (dom->row_start[n] > dom->pair_capacity) {
+        dom->pair_capacity = dom->row_start[n] + dom->row_start[n] / 4;
+        free(dom->pairs);
+        dom->pairs = malloc(dom->pair_capacity * sizeof(int));
+        if (dom->pairs == NULL) {
+            abort_domains(dom, "Memory allocation failed for the pair list");
+        }
+    }
+    for (size_t i = 0; i < n_all; i++) {
+        for (size_t k = nl->start[i]; k < nl->start[i + 1]; k++) {
+            size_t j = (size_t)nl->neighbors[k];
+            if (i < n && j < n) {
+                dom->pairs[own_count[i]++] = (int)j;
+            } else if (i < n) {
+                dom->pairs[ghost_count[i]++] = (int)j;
+            } else if (j < n) {
+                dom->pairs[ghost_count[j]++] = (int)i;
+            }
+        }
+    }
+    free(own_count);
+}
+
+// Function to check on every rank whether the neighbor lists must be rebuilt
+static int domain_list_expired(const Simulation* sim, Domain* dom) {
+    int expired = sim->nlist->rebuilds == 0 || neighbor_list_expired(sim->nlist, dom->n_local, sim->x, sim->y, sim->z);
+    MPI_Allreduce(MPI_IN_PLACE, &expired, 1, MPI_INT, MPI_LOR, dom->comm);
+    return expired;
+}
+
+// Function to migrate the atoms, choose the ghosts, fetch their positions and rebuild the pair list.
+// The cell search runs over own and ghost atoms as an open system, since the ghosts are images already.
+static void rebuild_domain(Simulation* sim, Domain* dom) {
+    static const double open_box[3] = { 0.0, 0.0, 0.0 };
+    double t0 = wall_time();
+    migrate_atoms(sim, dom);
+    setup_halo(sim, dom);
+    start_halo_exchange(sim, dom);
+    finish_halo_exchange(sim, dom);
+    build_neighbor_list(sim->nlist, sim->Natoms, sim->x, sim->y, sim->z, open_box);
+    split_domain_pairs(dom, sim->nlist);
+    dom->t_rebuild += wall_time() - t0;
+}
+
+// Function to compute the accelerations of the own atoms, their share of the LJ potential and of the
+// virial (ghosts only get scratch forces). With halo_pending the ghost positions are still on their way:
+// the pairs among own atoms are computed meanwhile, then the master thread waits for the ghosts.
+static double compute_domain_forces(Simulation* sim, Domain* dom, double* ax, double* ay, double* az,
+                                    int halo_pending, double* virial) {
+    double t0 = wall_time();
+    size_t n = dom->n_local;
+    PairParams pair;
+    memset(&pair, 0, sizeof(pair));
+    pair.cutoff2 = sim->nlist->cutoff * sim->nlist->cutoff;
+    pair.lj = sim->species.lj;
+    pair.type = sim->type;
+    pair.n_types = sim->species.n_types;
+    pair.split = FORCE_FULL;
+    pair.table = sim->lj_table;
+    const double* x = sim->x;
+    const double* y = sim->y;
+    const double* z = sim->z;
+    double own_potential = 0.0, own_virial = 0.0, halo_potential = 0.0, halo_virial = 0.0;
+
+    #pragma omp parallel reduction(+:own_potential, own_virial, halo_potential, halo_virial)
+    {
+        double *fx_t, *fy_t, *fz_t;
+        thread_force_buffer(sim, ax, ay, az, &fx_t, &fy_t, &fz_t);
+
+        #pragma omp for schedule(dynamic, 64) nowait
+        for (size_t i = 0; i < n; i++) {
+            own_potential += sim->lj_row(i, dom->pairs + dom->row_start[i], dom->halo_start[i] - dom->row_start[i],
+                                         x, y, z, &pair, fx_t, fy_t, fz_t, &own_virial);
+        }
+        if (halo_pending) {
+            #pragma omp master
+            {
+                double t_wait = wall_time();
+                finish_halo_exchange(sim, dom);
+                dom->t_wait += wall_time() - t_wait;
+            }
+            #pragma omp barrier
+        }
+        #pragma omp for schedule(dynamic, 64)
+        for (size_t i = 0; i < n; i++) {
+            halo_potential += sim->lj_row(i, dom->pairs + dom->halo_start[i], dom->row_start[i + 1] - dom->halo_start[i],
+                                          x, y, z, &pair, fx_t, fy_t, fz_t, &halo_virial);
+        }
+
+        reduce_thread_forces(sim, ax, ay, az);
+    }
+
+    dom->t_force += wall_time() - t0;
+    *virial = own_virial + 0.5 * halo_virial;
+    return own_potential + 0.5 * halo_potential;
+}
+
+// Function to compute the kinetic energy of the own atoms
+static double domain_kinetic_energy(const Simulation* sim, const Domain* dom) {
+    Simulation own = *sim;
+    own.Natoms = dom->n_local;
+    return compute_kinetic_energy(&own);
+}
+
+// Velocity Verlet for the own atoms; returns this rank's share of the LJ potential and of the virial
+static double domain_verlet_step(Simulation* sim, Domain* dom, double dt, double* virial) {
+    size_t n = dom->n_local;
+    advance_positions(n, dt, sim->x, sim->vx, sim->ax);
+    advance_positions(n, dt, sim->y, sim->vy, sim->ay);
+    advance_positions(n, dt, sim->z, sim->vz, sim->az);
+
+    // Either a rebuild (which fetches the ghosts itself) or the ghost positions behind the interior pairs
+    int rebuild = domain_list_expired(sim, dom);
+    if (rebuild) {
+        rebuild_domain(sim, dom);
+    } else {
+        start_halo_exchange(sim, dom);
+    }
+    double LJ_potential = compute_domain_forces(sim, dom, sim->ax_new, sim->ay_new, sim->az_new, !rebuild, virial);
+
+    n = dom->n_local;
+    advance_velocities(n, dt, sim->vx, sim->ax, sim->ax_new);
+    advance_velocities(n, dt, sim->vy, sim->ay, sim->ay_new);
+    advance_velocities(n, dt, sim->vz, sim->az, sim->az_new);
+    double* swap;
+    swap = sim->ax; sim->ax = sim->ax_new; sim->ax_new = swap;
+    swap = sim->ay; sim->ay = sim->ay_new; sim->ay_new = swap;
+    swap = sim->az; sim->az = sim->az_new; sim->az_new = swap;
+    return LJ_potential;
+}
+
+// Function to collect the positions of all atoms on rank 0, in input order, into frame
+static void gather_frame(const Simulation* sim, Domain* dom, Simulation* frame, double* all, int* counts, int* displs) {
+    double t0 = wall_time();
+    for (size_t i = 0; i < dom->n_local; i++) {
+        dom->gather_buffer[4 * i] = (double)dom->id[i];
+        dom->gather_buffer[4 * i + 1] = sim->x[i];
+        dom->gather_buffer[4 * i + 2] = sim->y[i];
+        dom->gather_buffer[4 * i + 3] = sim->z[i];
+    }
+    int count = (int)(4 * dom->n_local);
+    MPI_Gather(&count, 1, MPI_INT, counts, 1, MPI_INT, 0, dom->comm);
+    if (dom->rank == 0) {
+        displs[0] = 0;
+        for (int r = 1; r < dom->n_ranks; r++) {
+            displs[r] = displs[r - 1] + counts[r - 1];
+        }
+    }
+    MPI_Gatherv(dom->gather_buffer, count, MPI_DOUBLE, all, counts, displs, MPI_DOUBLE, 0, dom->comm);
+    if (dom->rank == 0) {
+        for (size_t k = 0; k < frame->Natoms; k++) {
+            size_t id = (size_t)all[4 * k];
+            frame->x[id] = all[4 * k + 1];
+            frame->y[id] = all[4 * k + 2];
+            frame->z[id] = all[4 * k + 3];
+        }
+    }
+    dom->t_output += wall_time() - t0;
+}
+
+// Function to set up the domain grid: one domain per rank, the longest box axes cut most often
+static int init_domain_grid(Domain* dom, const double box[3], double halo) {
+    MPI_Comm_size(MPI_COMM_WORLD, &dom->n_ranks);
+    int dims[3] = { 0, 0, 0 }, periods[3] = { 1, 1, 1 };
+    MPI_Dims_create(dom->n_ranks, 3, dims); // Non-increasing
+    int order[3] = { 0, 1, 2 };
+    for (int a = 0; a < 3; a++) {
+        for (int b = a + 1; b < 3; b++) {
+            if (box[order[b]] > box[order[a]]) {
+                int t = order[a]; order[a] = order[b]; order[b] = t;
+            }
+        }
+    }
+    for (int a = 0; a < 3; a++) {
+        dom->dims[order[a]] = dims[a];
+    }
+    MPI_Cart_create(MPI_COMM_WORLD, 3, dom->dims, periods, 0, &dom->comm);
+    MPI_Comm_rank(dom->comm, &dom->rank);
+    MPI_Cart_coords(dom->comm, dom->rank, 3, dom->coords);
+    dom->halo = halo;
+    int fits = 1;
+    for (int dim = 0; dim < 3; dim++) {
+        dom->width[dim] = box[dim] / dom->dims[dim];
+        fits &= dom->width[dim] >= halo;
+    }
+
+    // Neighbors, and the periodic shift of the atoms sent across the box boundary
+    int d = 0;
+    for (int k = 0; k < 27; k++) {
+        int offset[3] = { k / 9 - 1, k / 3 % 3 - 1, k % 3 - 1 };
+        if (k == 13) continue;
+        int neighbor_coords[3];
+        for (int dim = 0; dim < 3; dim++) {
+            dom->offset[d][dim] = offset[dim];
+            neighbor_coords[dim] = dom->coords[dim] + offset[dim]; // Wrapped by MPI_Cart_rank
+            dom->shift[d][dim] = 0.0;
+            if (offset[dim] > 0 && dom->coords[dim] == dom->dims[dim] - 1) dom->shift[d][dim] = -box[dim];
+            if (offset[dim] < 0 && dom->coords[dim] == 0) dom->shift[d][dim] = box[dim];
+        }
+        MPI_Cart_rank(dom->comm, neighbor_coords, &dom->neighbor[d]);
+        d++;
+    }
+    return fits;
+}
+
+// Function to print the decomposition report on rank 0: atoms per rank, and the time per step spent in the
+// force computation (and in it waiting for ghosts), in rebuilds and in gathering frames, on the slowest rank
+static void domain_report(const Domain* dom, int steps, double loop_wall_time, double loop_cpu_time) {
+    double own = (double)dom->n_local, ghosts = (double)dom->n_ghost;
+    double t[6] = { dom->t_force - dom->t_wait, dom->t_wait, dom->t_rebuild, dom->t_output, loop_cpu_time, own };
+    double t_max[6], t_sum[6], own_min, ghosts_sum;
+    MPI_Reduce(t, t_max, 6, MPI_DOUBLE, MPI_MAX, 0, dom->comm);
+    MPI_Reduce(t, t_sum, 6, MPI_DOUBLE, MPI_SUM, 0, dom->comm);
+    MPI_Reduce(&own, &own_min, 1, MPI_DOUBLE, MPI_MIN, 0, dom->comm);
+    MPI_Reduce(&ghosts, &ghosts_sum, 1, MPI_DOUBLE, MPI_SUM, 0, dom->comm);
+    if (dom->rank != 0 || steps <= 0) {
+        return;
+    }
+    double n = dom->n_ranks, per_step = 1e3 / steps;
+    printf("Domain decomposition: %d ranks as %d x %d x %d domains of %.3f x %.3f x %.3f nm, halo %.3f nm\n",
+           dom->n_ranks, dom->dims[0], dom->dims[1], dom->dims[2], dom->width[0], dom->width[1], dom->width[2], dom->halo);
+    printf("Atoms per rank: min %.0f, mean %.1f, max %.0f (imbalance %.1f%%); ghosts per rank: mean %.1f\n",
+           own_min, t_sum[5] / n, t_max[5], 100.0 * (t_max[5] / (t_sum[5] / n) - 1.0), ghosts_sum / n);
+    printf("Per step, slowest rank (ms): forces %.3f, waiting for ghosts %.3f, rebuilds %.3f, frame gathering %.3f; "
+           "total %.3f\n", t_max[0] * per_step, t_max[1] * per_step, t_max[2] * per_step, t_max[3] * per_step,
+           loop_wall_time * per_step);
+    printf("CPU time per rank: mean %.3f s, max %.3f s\n", t_sum[4] / n, t_max[4]);
+}
+
+// Function to run the dynamics of a periodic box split over all MPI ranks. Every rank reads the input and
+// keeps the atoms in its domain; rank 0 gathers the frames and the energies and writes the usual output
+// files. unsupported flags options that need a single process. Returns 0 on failure.
+int run_domains(const RunConfig* cfg, const Atom* atoms, size_t Natoms, const LJSpecies* species, const int* type,
+                int max_threads, int unsupported) {
+    Domain dom;
+    memset(&dom, 0, sizeof(dom));
+    const double* box = cfg->box;
+    int periodic = box[0] > 0.0 && box[1] > 0.0 && box[2] > 0.0;
+    int fits = init_domain_grid(&dom, periodic ? box : (double[3]){ 1.0, 1.0, 1.0 }, cfg->cutoff + cfg->skin);
+    int root = dom.rank == 0;
+    if (!periodic || unsupported || cfg->respa_steps > 1 || cfg->ensemble > 0) {
+        if (root) {
+            printf("With several MPI ranks only periodic boxes (--box) run, with velocity Verlet; "
+                   "--respa, --reorder, checkpoints, --ensemble and --scaling need a single process\n");
+        }
+        return 0;
+    }
+    if (!fits) {
+        if (root) {
+            printf("Domains of %.3f x %.3f x %.3f nm are thinner than cutoff + skin (%.3f nm); use fewer ranks\n",
+                   dom.width[0], dom.width[1], dom.width[2], dom.halo);
+        }
+        return 0;
+    }
+
+    // Keep the atoms of this domain
+    size_t n_own = 0;
+    Atom* own = malloc((Natoms + 1) * sizeof(Atom));
+    int64_t* own_id = malloc((Natoms + 1) * sizeof(int64_t));
+    int* own_type = type != NULL ? malloc((Natoms + 1) * sizeof(int)) : NULL;
+    if (own == NULL || own_id == NULL || (type != NULL && own_type == NULL)) {
+        abort_domains(&dom, "Memory allocation failed");
+    }
+    for (size_t i = 0; i < Natoms; i++) {
+        double r[3] = { atoms[i].x, atoms[i].y, atoms[i].z };
+        for (int dim = 0; dim < 3; dim++) {
+            r[dim] = wrap_coordinate(r[dim], box[dim]);
+        }
+        if (owner_direction(&dom, r[0], r[1], r[2]) == -1) {
+            own[n_own] = atoms[i];
+            own[n_own].x = r[0];
+            own[n_own].y = r[1];
+            own[n_own].z = r[2];
+            if (type != NULL) {
+                own_type[n_own] = type[i];
+            }
+            own_id[n_own++] = (int64_t)i;
+        }
+    }
+    Simulation sim;
+    // The tail corrections come from the species counts of the whole box
+    init_simulation(&sim, own, n_own, species, own_type, cfg->cutoff, cfg->skin, max_threads, box);
+    free(own);
+    free(own_type);
+    if (!select_lj_kernel(&sim, cfg->simd)) {
+        if (root) printf("LJ kernel '%s' is not available on this CPU\n", cfg->simd);
+        return 0;
+    }
+    dom.n_local = n_own;
+    dom.capacity = n_own;
+    reserve_domain(&sim, &dom, n_own + 1);
+    memcpy(dom.id, own_id, n_own * sizeof(int64_t));
+    free(own_id);
+    if (root) report_species(&sim.species);
+
+    // Rank 0 writes the frames, gathered in input order
+    Simulation frame;
+    memset(&frame, 0, sizeof(frame));
+    double* gathered = NULL;
+    int *counts = NULL, *displs = NULL;
+    if (root) {
+        frame.Natoms = Natoms;
+        frame.symbol = malloc(Natoms * sizeof(*frame.symbol));
+        frame.x = malloc_aligned(Natoms);
+        frame.y = malloc_aligned(Natoms);
+        frame.z = malloc_aligned(Natoms);
+        gathered = malloc_aligned(4 * Natoms);
+        counts = malloc(dom.n_ranks * sizeof(int));
+        displs = malloc(dom.n_ranks * sizeof(int));
+        if (frame.symbol == NULL || frame.x == NULL || frame.y == NULL || frame.z == NULL || gathered == NULL ||
+            counts == NULL || displs == NULL) {
+            abort_domains(&dom, "Memory allocation failed for the frames");
+        }
+        for (size_t i = 0; i < Natoms; i++) {
+            memcpy(frame.symbol[i], atoms[i].atom, sizeof(frame.symbol[i]));
+        }
+        memcpy(frame.box, box, sizeof(frame.box));
+        frame.pressure_tail = sim.pressure_tail;
+        printf("LJ kernel: %s\n", sim.lj_kernel_name);
+        printf("Periodic box %.4f x %.4f x %.4f nm, tail corrections: E = %.6f, P = %.6f\n",
+               box[0], box[1], box[2], sim.energy_tail, sim.pressure_tail);
+    }
+    if (cfg->lj_table > 0) {
+        init_lj_table(&sim, (size_t)cfg->lj_table, root);
+    }
+
+    // Initial forces and energies, summed on rank 0
+    double virial;
+    rebuild_domain(&sim, &dom);
+    double energies[3], totals[3] = { 0.0, 0.0, 0.0 };
+    energies[0] = compute_domain_forces(&sim, &dom, sim.ax, sim.ay, sim.az, 0, &virial);
+    energies[1] = domain_kinetic_energy(&sim, &dom);
+    energies[2] = virial;
+    MPI_Reduce(energies, totals, 3, MPI_DOUBLE, MPI_SUM, 0, dom.comm);
+    double LJ_potential = totals[0] + sim.energy_tail, kinetic_energy = totals[1];
+
+    FILE* output = NULL;
+    FILE* energy_output = NULL;
+    BinaryTrajectory binary;
+    OutputWriter writer;
+    if (root) {
+        printf("Initial Coordinates and Energies:\n");
+        printf("Lennard-Jones Potential: %.6f\n", LJ_potential);
+        printf("Kinetic Energy: %.6f\n", kinetic_energy);
+        printf("Total Energy: %.6f\n\n", LJ_potential + kinetic_energy);
+        if (cfg->binary_output) {
+            open_binary_trajectory(&binary, "trajectory.btr", &frame, cfg->precision, 0);
+        } else {
+            output = fopen("trajectory.xyz", "w");
+        }
+        energy_output = fopen("energies.csv", "w");
+        if ((!cfg->binary_output && output == NULL) || energy_output == NULL) {
+            perror("Error opening output files");
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+        fprintf(energy_output, "Step,LJ_Potential,Kinetic_Energy,Total_Energy,Pressure\n");
+        open_output_writer(&writer, &frame, output, cfg->binary_output ? &binary : NULL, energy_output,
+                           cfg->output_interval, cfg->output_buffers);
+    }
+
+    // Simulation loop; every rank takes part in the gathers and reductions
+    EnergyMonitor energy_monitor = { 0 };
+    double loop_start = wall_time(), cpu_start = (double)clock() / CLOCKS_PER_SEC;
+    for (int step = 0; step < cfg->total_steps; step++) {
+        if (step % cfg->output_interval == 0) {
+            gather_frame(&sim, &dom, &frame, gathered, counts, displs);
+        }
+        if (root) {
+            frame.virial = totals[2];
+            record_output(&writer, step, LJ_potential, kinetic_energy, compute_pressure(&frame, kinetic_energy));
+            monitor_energy(&energy_monitor, step * cfg->timestep, LJ_potential + kinetic_energy);
+        }
+        energies[0] = domain_verlet_step(&sim, &dom, cfg->timestep, &virial);
+        energies[1] = domain_kinetic_energy(&sim, &dom);
+        energies[2] = virial;
+        MPI_Reduce(energies, totals, 3, MPI_DOUBLE, MPI_SUM, 0, dom.comm);
+        LJ_potential = totals[0] + sim.energy_tail;
+        kinetic_energy = totals[1];
+    }
+    double loop_wall_time = wall_time() - loop_start;
+    double loop_cpu_time = (double)clock() / CLOCKS_PER_SEC - cpu_start;
+
+    int failed = 0;
+    if (root) {
+        close_output_writer(&writer);
+        if (cfg->output_buffers > 0 && writer.wait_time > 0.0) {
+            printf("Integrator waited %.3f s for the output writer\n", writer.wait_time);
+        }
+        if (cfg->binary_output) {
+            close_binary_trajectory(&binary);
+        } else {
+            failed |= fclose(output) != 0;
+        }
+        failed |= fclose(energy_output) != 0;
+        printf("Neighbor list rebuilds: %zu\n", sim.nlist->rebuilds);
+        report_energy_conservation(&energy_monitor, Natoms, cfg->total_steps * cfg->timestep, loop_wall_time);
+    }
+    domain_report(&dom, cfg->total_steps, loop_wall_time, loop_cpu_time);
+
+    free_simulation(&sim);
+    free(dom.id);
+    free(dom.send_atoms);
+    free(dom.send_buffer);
+    free(dom.recv_buffer);
+    free(dom.gather_buffer);
+    free(dom.row_start);
+    free(dom.halo_start);
+    free(dom.pairs);
+    free(frame.symbol);
+    free(frame.x);
+    free(frame.y);
+    free(frame.z);
+    free(gathered);
+    free(counts);
+    free(displs);
+    MPI_Comm_free(&dom.comm);
+    return !failed;
+}
+#endif
@@ -0,0 +1,17 @@
+// File: src/domain.h
+
+#ifndef DOMAIN_H
+#define DOMAIN_H
+
+#include "atoms.h"
+#include "config.h"
+#include "simulation.h"
+
+#ifdef USE_MPI
+// Function to run the dynamics of a periodic box split over all MPI ranks; unsupported flags options that
+// need a single process. Returns 0 on failure.
+int run_domains(const RunConfig* cfg, const Atom* atoms, size_t Natoms, const LJSpecies* species, const int* type,
+                int max_threads, int unsupported);
+#endif
+
+#endif // DOMAIN_H
@@ -0,0 +1,415 @@
+// File: src/ensemble.c
+
+#include <errno.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "ensemble.h"
+#include "output_writer.h"
+#include "simulation.h"
+#include "trajectory.h"
+#include "util.h"
+
+// LJ coefficients of the default species (EPSILON and SIGMA, argon), unshifted
+static const LJCoefficients default_lj = { SIGMA * SIGMA, 4 * EPSILON, 24 * EPSILON, 0.0 };
+
+// Function to compute the forces of one batch, lane by lane. Pairs are visited in the same order and
+// with the same arithmetic as compute_acc, so every replica reproduces a single run bit for bit.
+void ensemble_forces_scalar(size_t Natoms, const double* restrict inv_mass, double cutoff2, double shift,
+                            const double* restrict x, const double* restrict y, const double* restrict z,
+                            double* restrict ax, double* restrict ay, double* restrict az, double* restrict potential) {
+    const size_t L = ENSEMBLE_LANES;
+    memset(ax, 0, Natoms * L * sizeof(double));
+    memset(ay, 0, Natoms * L * sizeof(double));
+    memset(az, 0, Natoms * L * sizeof(double));
+
+    for (size_t l = 0; l < L; l++) {
+        double total_potential = 0.0;
+        for (size_t i = 0; i < Natoms; i++) {
+            double fx = 0.0, fy = 0.0, fz = 0.0;
+            for (size_t j = i + 1; j < Natoms; j++) {
+                double dx = x[i * L + l] - x[j * L + l];
+                double dy = y[i * L + l] - y[j * L + l];
+                double dz = z[i * L + l] - z[j * L + l];
+                double r2 = dx * dx + dy * dy + dz * dz;
+                if (r2 < cutoff2 && r2 > 0) {
+                    double energy;
+                    double force_mag = lj_pair(r2, &default_lj, &energy); // Force magnitude over r
+
+                    fx += force_mag * dx;
+                    fy += force_mag * dy;
+                    fz += force_mag * dz;
+                    ax[j * L + l] -= force_mag * dx;
+                    ay[j * L + l] -= force_mag * dy;
+                    az[j * L + l] -= force_mag * dz;
+                    total_potential += energy - shift;
+                }
+            }
+            ax[i * L + l] = (ax[i * L + l] + fx) * inv_mass[i];
+            ay[i * L + l] = (ay[i * L + l] + fy) * inv_mass[i];
+            az[i * L + l] = (az[i * L + l] + fz) * inv_mass[i];
+        }
+        potential[l] = total_potential;
+    }
+}
+
+#ifdef HAVE_X86_SIMD
+// Function to compute the forces of one batch with AVX2: lanes 0-3, then lanes 4-7. Every load and
+// store is a contiguous vector of four replicas, with no gathers or scatters.
+__attribute__((target("avx2,fma")))
+void ensemble_forces_avx2(size_t Natoms, const double* inv_mass, double cutoff2, double shift,
+                          const double* x, const double* y, const double* z,
+                          double* ax, double* ay, double* az, double* potential) {
+    const size_t L = ENSEMBLE_LANES;
+    const __m256d sigma2 = _mm256_set1_pd(SIGMA * SIGMA), cut2 = _mm256_set1_pd(cutoff2);
+    const __m256d eps4 = _mm256_set1_pd(4 * EPSILON), eps24 = _mm256_set1_pd(24 * EPSILON);
+    const __m256d two = _mm256_set1_pd(2.0), one = _mm256_set1_pd(1.0), shift_v = _mm256_set1_pd(shift);
+    const __m256d zero = _mm256_setzero_pd();
+    memset(ax, 0, Natoms * L * sizeof(double));
+    memset(ay, 0, Natoms * L * sizeof(double));
+    memset(az, 0, Natoms * L * sizeof(double));
+
+    for (size_t h = 0; h < L; h += 4) {
+        __m256d total_potential = zero;
+        for (size_t i = 0; i < Natoms; i++) {
+            const __m256d xi = _mm256_loadu_pd(x + i * L + h), yi = _mm256_loadu_pd(y + i * L + h);
+            const __m256d zi = _mm256_loadu_pd(z + i * L + h);
+            __m256d fx = zero, fy = zero, fz = zero;
+            for (size_t j = i + 1; j < Natoms; j++) {
+                __m256d dx = _mm256_sub_pd(xi, _mm256_loadu_pd(x + j * L + h));
+                __m256d dy = _mm256_sub_pd(yi, _mm256_loadu_pd(y + j * L + h));
+                __m256d dz = _mm256_sub_pd(zi, _mm256_loadu_pd(z + j * L + h));
+                __m256d r2 = _mm256_fmadd_pd(dx, dx, _mm256_fmadd_pd(dy, dy, _mm256_mul_pd(dz, dz)));
+                __m256d inside = _mm256_and_pd(_mm256_cmp_pd(r2, cut2, _CMP_LT_OQ), _mm256_cmp_pd(r2, zero, _CMP_GT_OQ));
+
+                __m256d inv_r2 = _mm256_and_pd(_mm256_div_pd(one, r2), inside);
+                __m256d sr2 = _mm256_mul_pd(sigma2, inv_r2);
+                __m256d sr6 = _mm256_mul_pd(_mm256_mul_pd(sr2, sr2), sr2);
+                __m256d sr12 = _mm256_mul_pd(sr6, sr6);
+                __m256d force_mag = _mm256_mul_pd(_mm256_mul_pd(eps24, _mm256_fmsub_pd(two, sr12, sr6)), inv_r2);
+                __m256d energy = _mm256_fmsub_pd(eps4, _mm256_sub_pd(sr12, sr6), shift_v);
+                total_potential = _mm256_add_pd(total_potential, _mm256_and_pd(energy, inside));
+
+                __m256d fdx = _mm256_mul_pd(force_mag, dx);
+                __m256d fdy = _mm256_mul_pd(force_mag, dy);
+                __m256d fdz = _mm256_mul_pd(force_mag, dz);
+                fx = _mm256_add_pd(fx, fdx);
+                fy = _mm256_add_pd(fy, fdy);
+                fz = _mm256_add_pd(fz, fdz);
+                _mm256_storeu_pd(ax + j * L + h, _mm256_sub_pd(_mm256_loadu_pd(ax + j * L + h), fdx));
+                _mm256_storeu_pd(ay + j * L + h, _mm256_sub_pd(_mm256_loadu_pd(ay + j * L + h), fdy));
+                _mm256_storeu_pd(az + j * L + h, _mm256_sub_pd(_mm256_loadu_pd(az + j * L + h), fdz));
+            }
+            const __m256d inv_m = _mm256_set1_pd(inv_mass[i]);
+            _mm256_storeu_pd(ax + i * L + h, _mm256_mul_pd(_mm256_add_pd(_mm256_loadu_pd(ax + i * L + h), fx), inv_m));
+            _mm256_storeu_pd(ay + i * L + h, _mm256_mul_pd(_mm256_add_pd(_mm256_loadu_pd(ay + i * L + h), fy), inv_m));
+            _mm256_storeu_pd(az + i * L + h, _mm256_mul_pd(_mm256_add_pd(_mm256_loadu_pd(az + i * L + h), fz), inv_m));
+        }
+        _mm256_storeu_pd(potential + h, total_potential);
+    }
+}
+
+// Function to compute the forces of one batch with AVX-512: all eight lanes in one register
+__attribute__((target("avx512f")))
+void ensemble_forces_avx512(size_t Natoms, const double* inv_mass, double cutoff2, double shift,
+                            const double* x, const double* y, const double* z,
+                            double* ax, double* ay, double* az, double* potential) {
+    const size_t L = ENSEMBLE_LANES;
+    const __m512d sigma2 = _mm512_set1_pd(SIGMA * SIGMA), cut2 = _mm512_set1_pd(cutoff2);
+    const __m512d eps4 = _mm512_set1_pd(4 * EPSILON), eps24 = _mm512_set1_pd(24 * EPSILON);
+    const __m512d two = _mm512_set1_pd(2.0), one = _mm512_set1_pd(1.0), shift_v = _mm512_set1_pd(shift);
+    const __m512d zero = _mm512_setzero_pd();
+    memset(ax, 0, Natoms * L * sizeof(double));
+    memset(ay, 0, Natoms * L * sizeof(double));
+    memset(az, 0, Natoms * L * sizeof(double));
+
+    __m512d total_potential = zero;
+    for (size_t i = 0; i < Natoms; i++) {
+        const __m512d xi = _mm512_loadu_pd(x + i * L), yi = _mm512_loadu_pd(y + i * L), zi = _mm512_loadu_pd(z + i * L);
+        __m512d fx = zero, fy = zero, fz = zero;
+        for (size_t j = i + 1; j < Natoms; j++) {
+            __m512d dx = _mm512_sub_pd(xi, _mm512_loadu_pd(x + j * L));
+            __m512d dy = _mm512_sub_pd(yi, _mm512_loadu_pd(y + j * L));
+            __m512d dz = _mm512_sub_pd(zi, _mm512_loadu_pd(z + j * L));
+            __m512d r2 = _mm512_fmadd_pd(dx, dx, _mm512_fmadd_pd(dy, dy, _mm512_mul_pd(dz, dz)));
+            __mmask8 inside = _mm512_cmp_pd_mask(r2, cut2, _CMP_LT_OQ) & _mm512_cmp_pd_mask(r2, zero, _CMP_GT_OQ);
+
+            __m512d inv_r2 = _mm512_maskz_div_pd(inside, one, r2);
+            __m512d sr2 = _mm512_mul_pd(sigma2, inv_r2);
+            __m512d sr6 = _mm512_mul_pd(_mm512_mul_pd(sr2, sr2), sr2);
+            __m512d sr12 = _mm512_mul_pd(sr6, sr6);
+            __m512d force_mag = _mm512_mul_pd(_mm512_mul_pd(eps24, _mm512_fmsub_pd(two, sr12, sr6)), inv_r2);
+            __m512d energy = _mm512_fmsub_pd(eps4, _mm512_sub_pd(sr12, sr6), shift_v);
+            total_potential = _mm512_mask_add_pd(total_potential, inside, total_potential, energy);
+
+            __m512d fdx = _mm512_mul_pd(force_mag, dx);
+            __m512d fdy = _mm512_mul_pd(force_mag, dy);
+            __m512d fdz = _mm512_mul_pd(force_mag, dz);
+            fx = _mm512_add_pd(fx, fdx);
+            fy = _mm512_add_pd(fy, fdy);
+            fz = _mm512_add_pd(fz, fdz);
+            _mm512_storeu_pd(ax + j * L, _mm512_sub_pd(_mm512_loadu_pd(ax + j * L), fdx));
+            _mm512_storeu_pd(ay + j * L, _mm512_sub_pd(_mm512_loadu_pd(ay + j * L), fdy));
+            _mm512_storeu_pd(az + j * L, _mm512_sub_pd(_mm512_loadu_pd(az + j * L), fdz));
+        }
+        const __m512d inv_m = _mm512_set1_pd(inv_mass[i]);
+        _mm512_storeu_pd(ax + i * L, _mm512_mul_pd(_mm512_add_pd(_mm512_loadu_pd(ax + i * L), fx), inv_m));
+        _mm512_storeu_pd(ay + i * L, _mm512_mul_pd(_mm512_add_pd(_mm512_loadu_pd(ay + i * L), fy), inv_m));
+        _mm512_storeu_pd(az + i * L, _mm512_mul_pd(_mm512_add_pd(_mm512_loadu_pd(az + i * L), fz), inv_m));
+    }
+    _mm512_storeu_pd(potential, total_potential);
+}
+#endif
+
+// Function to pick the ensemble kernel the same way select_lj_kernel does; NULL if not available
+EnsembleKernel select_ensemble_kernel(const char* requested, const char** name) {
+    int want_auto = strcmp(requested, "auto") == 0;
+#ifdef HAVE_X86_SIMD
+    __builtin_cpu_init();
+    if ((want_auto || strcmp(requested, "avx512") == 0) && __builtin_cpu_supports("avx512f")) {
+        *name = "avx512";
+        return ensemble_forces_avx512;
+    }
+    if ((want_auto || strcmp(requested, "avx2") == 0) && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        *name = "avx2";
+        return ensemble_forces_avx2;
+    }
+#endif
+    *name = "scalar";
+    return want_auto || strcmp(requested, "scalar") == 0 ? ensemble_forces_scalar : NULL;
+}
+
+// Function to return the next number of a splitmix64 stream, uniform in [0, 1)
+static double random_uniform(uint64_t* state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z ^= z >> 31;
+    return (double)(z >> 11) * 0x1.0p-53;
+}
+
+// Function to return a standard normal number (Box-Muller)
+static double random_normal(uint64_t* state) {
+    double u1 = random_uniform(state), u2 = random_uniform(state);
+    return sqrt(-2.0 * log(1.0 - u1)) * cos(2.0 * M_PI * u2);
+}
+
+// Function to set up lane l of a batch as replica `replica`: the input positions displaced uniformly by
+// up to perturb nm per coordinate, and Maxwell-Boltzmann velocities at temperature (K) without
+// centre-of-mass drift. Every replica has its own random stream, so it does not depend on the batching.
+void init_replica(EnsembleBatch* batch, int l, const Atom* atoms, size_t Natoms, const RunConfig* cfg, size_t replica) {
+    const size_t L = ENSEMBLE_LANES;
+    const double kB = 0.0019872041; // Boltzmann constant (in kcal/mol/K)
+    uint64_t state = (uint64_t)cfg->seed * 0x100000001B3ULL + replica;
+    double p[3] = { 0.0, 0.0, 0.0 }, total_mass = 0.0;
+    for (size_t i = 0; i < Natoms; i++) {
+        batch->x[i * L + l] = atoms[i].x + cfg->perturb * (2.0 * random_uniform(&state) - 1.0);
+        batch->y[i * L + l] = atoms[i].y + cfg->perturb * (2.0 * random_uniform(&state) - 1.0);
+        batch->z[i * L + l] = atoms[i].z + cfg->perturb * (2.0 * random_uniform(&state) - 1.0);
+        double sigma_v = sqrt(kB * cfg->temperature / atoms[i].mass);
+        double* v[3] = { &batch->vx[i * L + l], &batch->vy[i * L + l], &batch->vz[i * L + l] };
+        for (int d = 0; d < 3; d++) {
+            *v[d] = cfg->temperature > 0.0 ? sigma_v * random_normal(&state) : 0.0;
+            p[d] += atoms[i].mass * *v[d];
+        }
+        total_mass += atoms[i].mass;
+    }
+    for (size_t i = 0; i < Natoms; i++) {
+        batch->vx[i * L + l] -= p[0] / total_mass;
+        batch->vy[i * L + l] -= p[1] / total_mass;
+        batch->vz[i * L + l] -= p[2] / total_mass;
+    }
+}
+
+// Function to compute the kinetic energy of every lane of a batch
+static void ensemble_kinetic_energy(EnsembleBatch* batch, size_t Natoms, const double* mass) {
+    const size_t L = ENSEMBLE_LANES;
+    double KE[ENSEMBLE_LANES] = { 0.0 };
+    for (size_t i = 0; i < Natoms; i++) {
+        for (size_t l = 0; l < L; l++) {
+            size_t k = i * L + l;
+            KE[l] += 0.5 * mass[i] * (batch->vx[k] * batch->vx[k] + batch->vy[k] * batch->vy[k] + batch->vz[k] * batch->vz[k]);
+        }
+    }
+    memcpy(batch->KE, KE, sizeof(KE));
+}
+
+// Function to advance one batch by a velocity-Verlet step, the same update as verlet_update.
+// a_new is scratch space of 3 * Natoms * ENSEMBLE_LANES doubles.
+static void ensemble_verlet_step(EnsembleBatch* batch, size_t Natoms, const double* inv_mass, double dt,
+                                 EnsembleKernel kernel, double cutoff2, double shift, double* a_new) {
+    size_t n = Natoms * ENSEMBLE_LANES;
+    double* coord[3] = { batch->x, batch->y, batch->z };
+    double* v[3] = { batch->vx, batch->vy, batch->vz };
+    double* a[3] = { batch->ax, batch->ay, batch->az };
+    for (int d = 0; d < 3; d++) {
+        double* restrict c = coord[d];
+        const double* restrict vd = v[d];
+        const double* restrict ad = a[d];
+        for (size_t k = 0; k < n; k++) {
+            c[k] += vd[k] * dt + 0.5 * ad[k] * dt * dt;
+        }
+    }
+    kernel(Natoms, inv_mass, cutoff2, shift, batch->x, batch->y, batch->z, a_new, a_new + n, a_new + 2 * n, batch->LJ);
+    for (int d = 0; d < 3; d++) {
+        double* restrict vd = v[d];
+        double* restrict ad = a[d];
+        const double* restrict an = a_new + d * n;
+        for (size_t k = 0; k < n; k++) {
+            vd[k] += 0.5 * (ad[k] + an[k]) * dt;
+            ad[k] = an[k];
+        }
+    }
+}
+
+// Function to run the whole ensemble: cfg->ensemble replicas of the input system, each written to its own
+// energies_NNNN.csv and trajectory_NNNN.xyz (or .btr) in cfg->ensemble_dir. Reports the throughput in
+// replica-steps per second and the worst energy drift. Returns 0 on failure.
+int run_ensemble(const RunConfig* cfg, const Atom* atoms, size_t Natoms) {
+    const size_t L = ENSEMBLE_LANES;
+    size_t n_replicas = (size_t)cfg->ensemble;
+    size_t n_batches = (n_replicas + L - 1) / L;
+    const char* kernel_name;
+    EnsembleKernel kernel = select_ensemble_kernel(cfg->simd, &kernel_name);
+    if (kernel == NULL) {
+        printf("LJ kernel '%s' is not available on this CPU\n", cfg->simd);
+        return 0;
+    }
+    if (mkdir(cfg->ensemble_dir, 0777) != 0 && errno != EEXIST) {
+        perror("Error creating the ensemble output directory");
+        return 0;
+    }
+
+    // Shared per-atom data; the frame writers only read Natoms, symbol, box and the coordinates
+    double* mass = malloc_aligned(Natoms);
+    double* inv_mass = malloc_aligned(Natoms);
+    Simulation frame_template;
+    memset(&frame_template, 0, sizeof(frame_template));
+    frame_template.Natoms = Natoms;
+    frame_template.symbol = malloc(Natoms * sizeof(*frame_template.symbol));
+    if (mass == NULL || inv_mass == NULL || frame_template.symbol == NULL) {
+        printf("Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < Natoms; i++) {
+        mass[i] = atoms[i].mass;
+        inv_mass[i] = 1.0 / atoms[i].mass;
+        memcpy(frame_template.symbol[i], atoms[i].atom, sizeof(frame_template.symbol[i]));
+    }
+    double cutoff2 = cfg->cutoff > 0.0 ? cfg->cutoff * cfg->cutoff : INFINITY;
+    double shift = 0.0;
+    if (cfg->cutoff > 0.0) {
+        lj_pair(cutoff2, &default_lj, &shift);
+    }
+
+    printf("Ensemble: %zu replicas of %zu atoms in %zu batches of %zu lanes, %s kernel\n",
+           n_replicas, Natoms, n_batches, L, kernel_name);
+    double max_deviation = 0.0;
+    int failed = 0;
+    double t0 = wall_time();
+
+    #pragma omp parallel for schedule(dynamic, 1) reduction(max:max_deviation) reduction(|:failed)
+    for (size_t b = 0; b < n_batches; b++) {
+        // Batch state, interleaved, plus a de-interleaved frame per lane for the writers
+        EnsembleBatch batch;
+        batch.first_replica = b * L;
+        batch.n_replicas = (int)(n_replicas - batch.first_replica < L ? n_replicas - batch.first_replica : L);
+        double* block = malloc_aligned(12 * Natoms * L + 3 * Natoms * L);
+        double** arrays[9] = { &batch.x, &batch.y, &batch.z, &batch.vx, &batch.vy, &batch.vz, &batch.ax, &batch.ay, &batch.az };
+        if (block == NULL) {
+            printf("Memory allocation failed for batch %zu\n", b);
+            exit(EXIT_FAILURE);
+        }
+        for (int a = 0; a < 9; a++) {
+            *arrays[a] = block + (size_t)a * Natoms * L;
+        }
+        double* a_new = block + 9 * Natoms * L;
+        double* frame_coords = block + 12 * Natoms * L;
+        for (int l = 0; l < (int)L; l++) {
+            int source = l < batch.n_replicas ? l : batch.n_replicas - 1;
+            init_replica(&batch, l, atoms, Natoms, cfg, batch.first_replica + source);
+        }
+
+        // One synchronous output writer per replica, open only while its batch runs
+        OutputWriter writers[ENSEMBLE_LANES];
+        Simulation frames[ENSEMBLE_LANES];
+        FILE* trajectory[ENSEMBLE_LANES] = { NULL };
+        FILE* energies[ENSEMBLE_LANES] = { NULL };
+        BinaryTrajectory binary[ENSEMBLE_LANES];
+        for (int l = 0; l < batch.n_replicas; l++) {
+            char path[1100];
+            frames[l] = frame_template;
+            frames[l].x = frame_coords + l * Natoms;
+            frames[l].y = frames[l].x + L * Natoms;
+            frames[l].z = frames[l].y + L * Natoms;
+            snprintf(path, sizeof(path), "%s/trajectory_%04zu.%s", cfg->ensemble_dir, batch.first_replica + l,
+                     cfg->binary_output ? "btr" : "xyz");
+            if (cfg->binary_output) {
+                open_binary_trajectory(&binary[l], path, &frames[l], cfg->precision, 0);
+            } else {
+                trajectory[l] = fopen(path, "w");
+            }
+            snprintf(path, sizeof(path), "%s/energies_%04zu.csv", cfg->ensemble_dir, batch.first_replica + l);
+            energies[l] = fopen(path, "w");
+            if ((!cfg->binary_output && trajectory[l] == NULL) || energies[l] == NULL) {
+                perror("Error opening replica output files");
+                exit(EXIT_FAILURE);
+            }
+            fprintf(energies[l], "Step,LJ_Potential,Kinetic_Energy,Total_Energy\n");
+            open_output_writer(&writers[l], &frames[l], trajectory[l], cfg->binary_output ? &binary[l] : NULL,
+                               energies[l], cfg->output_interval, 0);
+        }
+
+        kernel(Natoms, inv_mass, cutoff2, shift, batch.x, batch.y, batch.z, batch.ax, batch.ay, batch.az, batch.LJ);
+        ensemble_kinetic_energy(&batch, Natoms, mass);
+        double E0[ENSEMBLE_LANES];
+        for (size_t l = 0; l < L; l++) {
+            E0[l] = batch.LJ[l] + batch.KE[l];
+        }
+        for (int step = 0; step < cfg->total_steps; step++) {
+            for (int l = 0; l < batch.n_replicas; l++) {
+                if (step % cfg->output_interval == 0) {
+                    for (size_t i = 0; i < Natoms; i++) {
+                        frames[l].x[i] = batch.x[i * L + l];
+                        frames[l].y[i] = batch.y[i * L + l];
+                        frames[l].z[i] = batch.z[i * L + l];
+                    }
+                }
+                record_output(&writers[l], step, batch.LJ[l], batch.KE[l], 0.0);
+                double deviation = fabs(batch.LJ[l] + batch.KE[l] - E0[l]) / (double)Natoms;
+                max_deviation = deviation > max_deviation ? deviation : max_deviation;
+            }
+            ensemble_verlet_step(&batch, Natoms, inv_mass, cfg->timestep, kernel, cutoff2, shift, a_new);
+            ensemble_kinetic_energy(&batch, Natoms, mass);
+        }
+
+        for (int l = 0; l < batch.n_replicas; l++) {
+            if (cfg->binary_output) {
+                close_binary_trajectory(&binary[l]);
+            } else {
+                failed |= fclose(trajectory[l]) != 0;
+            }
+            failed |= fclose(energies[l]) != 0;
+        }
+        free(block);
+    }
+
+    double elapsed = wall_time() - t0;
+    double replica_steps = (double)n_replicas * cfg->total_steps;
+    printf("Ran %.0f replica-steps in %.3f s: %.4g replica-steps per second, %.4g atom-steps per second\n",
+           replica_steps, elapsed, replica_steps / elapsed, replica_steps * (double)Natoms / elapsed);
+    printf("Largest |E - E0| of any replica: %.3e kcal/mol per atom\n", max_deviation);
+    printf("Outputs: %s/energies_NNNN.csv and %s/trajectory_NNNN.%s\n", cfg->ensemble_dir, cfg->ensemble_dir,
+           cfg->binary_output ? "btr" : "xyz");
+
+    free(mass);
+    free(inv_mass);
+    free(frame_template.symbol);
+    if (failed) {
+        perror("Error writing replica output files");
+    }
+    return !failed;
+}
@@ -0,0 +1,53 @@
+// File: src/ensemble.h
+
+#ifndef ENSEMBLE_H
+#define ENSEMBLE_H
+
+#include <stddef.h>
+#include "atoms.h"
+#include "config.h"
+#include "simulation.h"
+
+#define ENSEMBLE_LANES 8 // Replicas advanced together in ensemble mode, one per SIMD lane (8 doubles = AVX-512)
+
+// Ensemble mode: many independent replicas of the input system in one process. Replicas are
+// interleaved in batches of ENSEMBLE_LANES, one replica per SIMD lane: atom i of lane l lives at
+// [i * ENSEMBLE_LANES + l] of every per-atom array, so the vector kernels load a whole batch with
+// unit stride, and even a 3-atom system fills the vector registers. Every batch runs on one thread from
+// start to end, so its data stays in cache; threads share out the batches.
+typedef struct {
+    size_t first_replica;   // Replica number of lane 0
+    int n_replicas;         // Lanes holding a replica; the rest copy the last one and are not written out
+    double *x, *y, *z, *vx, *vy, *vz, *ax, *ay, *az; // Natoms * ENSEMBLE_LANES each
+    double LJ[ENSEMBLE_LANES], KE[ENSEMBLE_LANES];
+} EnsembleBatch;
+
+// Pair loop of one batch: accelerations and the LJ potential of every lane. Pairs beyond the cutoff
+// (cutoff2 = INFINITY for all pairs) are masked out and the potential is shifted by shift.
+typedef void (*EnsembleKernel)(size_t Natoms, const double* inv_mass, double cutoff2, double shift,
+                               const double* x, const double* y, const double* z,
+                               double* ax, double* ay, double* az, double* potential);
+
+// Functions to compute the forces of one batch (see EnsembleKernel)
+void ensemble_forces_scalar(size_t Natoms, const double* restrict inv_mass, double cutoff2, double shift,
+                            const double* restrict x, const double* restrict y, const double* restrict z,
+                            double* restrict ax, double* restrict ay, double* restrict az, double* restrict potential);
+#ifdef HAVE_X86_SIMD
+void ensemble_forces_avx2(size_t Natoms, const double* inv_mass, double cutoff2, double shift,
+                          const double* x, const double* y, const double* z,
+                          double* ax, double* ay, double* az, double* potential);
+void ensemble_forces_avx512(size_t Natoms, const double* inv_mass, double cutoff2, double shift,
+                            const double* x, const double* y, const double* z,
+                            double* ax, double* ay, double* az, double* potential);
+#endif
+
+// Function to pick the ensemble kernel the same way select_lj_kernel does; NULL if not available
+EnsembleKernel select_ensemble_kernel(const char* requested, const char** name);
+
+// Function to set up lane l of a batch as replica `replica`
+void init_replica(EnsembleBatch* batch, int l, const Atom* atoms, size_t Natoms, const RunConfig* cfg, size_t replica);
+
+// Function to run the whole ensemble, each replica written to its own files; returns 0 on failure
+int run_ensemble(const RunConfig* cfg, const Atom* atoms, size_t Natoms);
+
+#endif // ENSEMBLE_H
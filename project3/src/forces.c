@@ -0,0 +1,623 @@
+// File: src/forces.c
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "forces.h"
+#include "neighbor_list.h"
+
+// Function to return the id of the calling OpenMP thread (0 without OpenMP)
+static inline int thread_id(void) {
+#ifdef _OPENMP
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif
+}
+
+// Function to return the number of threads in the current parallel region (1 without OpenMP)
+static inline int thread_count(void) {
+#ifdef _OPENMP
+    return omp_get_num_threads();
+#else
+    return 1;
+#endif
+}
+
+// Function to get and zero the force accumulators of the calling thread inside a parallel region.
+// Thread 0 uses ax/ay/az directly, so a single thread needs no extra buffer or reduction.
+void thread_force_buffer(const Simulation* sim, double* ax, double* ay, double* az, double** fx, double** fy, double** fz) {
+    int tid = thread_id();
+    if (tid >= sim->n_threads) {
+        printf("Force buffers are sized for %d threads, thread %d is running\n", sim->n_threads, tid);
+        exit(EXIT_FAILURE);
+    }
+    if (tid == 0) {
+        *fx = ax;
+        *fy = ay;
+        *fz = az;
+    } else {
+        *fx = sim->thread_forces + 3 * sim->Natoms * (size_t)(tid - 1);
+        *fy = *fx + sim->Natoms;
+        *fz = *fy + sim->Natoms;
+    }
+    memset(*fx, 0, sim->Natoms * sizeof(double));
+    memset(*fy, 0, sim->Natoms * sizeof(double));
+    memset(*fz, 0, sim->Natoms * sizeof(double));
+}
+
+// Function to add the per-thread forces into ax/ay/az and divide by the masses.
+// Called by every thread of the parallel region after the pair loop; atoms are split over threads.
+void reduce_thread_forces(const Simulation* sim, double* restrict ax, double* restrict ay, double* restrict az) {
+    size_t Natoms = sim->Natoms;
+    int n_threads = thread_count();
+    const double* restrict mass = sim->mass;
+    const double* restrict buffers = sim->thread_forces;
+
+    #pragma omp for schedule(static)
+    for (size_t i = 0; i < Natoms; i++) {
+        double fx = ax[i], fy = ay[i], fz = az[i];
+        for (int t = 1; t < n_threads; t++) {
+            const double* f = buffers + 3 * Natoms * (size_t)(t - 1);
+            fx += f[i];
+            fy += f[Natoms + i];
+            fz += f[2 * Natoms + i];
+        }
+        double inv_mass = 1.0 / mass[i];
+        ax[i] = fx * inv_mass;
+        ay[i] = fy * inv_mass;
+        az[i] = fz * inv_mass;
+    }
+}
+
+// Function to compute kinetic energy
+double compute_kinetic_energy(const Simulation* sim) {
+    const double* restrict vx = sim->vx;
+    const double* restrict vy = sim->vy;
+    const double* restrict vz = sim->vz;
+    const double* restrict mass = sim->mass;
+    double total_kinetic = 0.0;
+
+    #pragma omp parallel for simd schedule(static) reduction(+:total_kinetic)
+    for (size_t i = 0; i < sim->Natoms; i++) {
+        double v2 = vx[i] * vx[i] + vy[i] * vy[i] + vz[i] * vz[i]; // v^2 = vx^2 + vy^2 + vz^2
+        total_kinetic += 0.5 * (mass[i]) * v2; // T = 1/2 * m * v^2
+    }
+
+    return total_kinetic;
+}
+
+// Function to compute accelerations and the LJ potential over all pairs.
+// Each pair i < j is visited once: r^2, the force (applied to both atoms) and the pair energy
+// come from a single pass, with no distance matrix. Rows i are shared out dynamically over
+// threads; every thread scatters into its own force buffer, reduced once at the end.
+double compute_acc(const Simulation* sim, double* restrict ax, double* restrict ay, double* restrict az) {
+    size_t Natoms = sim->Natoms;
+    const double* restrict x = sim->x;
+    const double* restrict y = sim->y;
+    const double* restrict z = sim->z;
+    const int* type = sim->type;
+    int n_types = sim->species.n_types;
+    double total_potential = 0.0;
+
+    #pragma omp parallel reduction(+:total_potential)
+    {
+        double *fx_t, *fy_t, *fz_t;
+        thread_force_buffer(sim, ax, ay, az, &fx_t, &fy_t, &fz_t);
+
+        #pragma omp for schedule(dynamic, 16)
+        for (size_t i = 0; i < Natoms; i++) {
+            double fx = 0.0, fy = 0.0, fz = 0.0;
+            const LJCoefficients* row_lj = sim->species.lj + (type != NULL ? type[i] * n_types : 0);
+            for (size_t j = i + 1; j < Natoms; j++) {
+                double dx = x[i] - x[j];
+                double dy = y[i] - y[j];
+                double dz = z[i] - z[j];
+                double r2 = dx * dx + dy * dy + dz * dz;
+                if (r2 > 0) { // Avoid division by zero
+                    double energy;
+                    double force_mag = lj_pair(r2, type != NULL ? &row_lj[type[j]] : row_lj, &energy); // Force over r
+
+                    fx += force_mag * dx;
+                    fy += force_mag * dy;
+                    fz += force_mag * dz;
+                    fx_t[j] -= force_mag * dx;
+                    fy_t[j] -= force_mag * dy;
+                    fz_t[j] -= force_mag * dz;
+                    total_potential += energy;
+                }
+            }
+            fx_t[i] += fx;
+            fy_t[i] += fy;
+            fz_t[i] += fz;
+        }
+
+        reduce_thread_forces(sim, ax, ay, az);
+    }
+
+    return total_potential;
+}
+
+// Function to evaluate the r-RESPA switching function from r^2: S = 1 - y^2 (3 - 2y), where y is the
+// fraction of the switching region below r, clamped to [0, 1]. S and dS/dr are continuous everywhere.
+static inline double switch_factor(double r2, const PairParams* pair) {
+    double y = (sqrt(r2) - pair->switch_start) * pair->inv_switch_width;
+    y = y < 0.0 ? 0.0 : (y > 1.0 ? 1.0 : y);
+    return 1.0 - y * y * (3.0 - 2.0 * y);
+}
+
+// Function to compute the LJ interactions of one neighbor-list row, one pair at a time.
+// periodic, switched, tabulated and mixed are constants at every call site in lj_row_scalar, which get one
+// specialised loop each. A switched row applies S F (inner) or (1 - S) F (outer) but sums the full energy and virial.
+// A mixed row looks up the coefficients of every partner's type in the row of atom i's type.
+static inline double lj_row_pairs(size_t i, const int* neighbors, size_t count,
+                                  const double* x, const double* y, const double* z, const PairParams* pair,
+                                  double* fx_t, double* fy_t, double* fz_t, double* virial, int periodic,
+                                  int switched, int tabulated, int mixed) {
+    double cutoff2 = pair->cutoff2;
+    const LJCoefficients* row_lj = pair->lj + (mixed ? pair->type[i] * pair->n_types : 0);
+    double fx = 0.0, fy = 0.0, fz = 0.0;
+    double row_potential = 0.0, row_virial = 0.0;
+    for (size_t k = 0; k < count; k++) {
+        int j = neighbors[k];
+        double dx = x[i] - x[j];
+        double dy = y[i] - y[j];
+        double dz = z[i] - z[j];
+        if (periodic) {
+            dx = minimum_image(dx, pair->box[0]);
+            dy = minimum_image(dy, pair->box[1]);
+            dz = minimum_image(dz, pair->box[2]);
+        }
+        double r2 = dx * dx + dy * dy + dz * dz;
+        if (r2 < cutoff2 && r2 > 0) {
+            const LJCoefficients* lj = mixed ? &row_lj[pair->type[j]] : row_lj;
+            double energy;
+            double force_mag = tabulated ? lj_pair_table(pair->table, r2, &energy) // Force magnitude over r
+                                         : lj_pair(r2, lj, &energy);
+            row_potential += energy - lj->shift;
+            row_virial += force_mag * r2;
+            if (switched) {
+                double s = switch_factor(r2, pair);
+                force_mag *= pair->split == FORCE_INNER ? s : 1.0 - s;
+            }
+
+            fx += force_mag * dx;
+            fy += force_mag * dy;
+            fz += force_mag * dz;
+            fx_t[j] -= force_mag * dx;
+            fy_t[j] -= force_mag * dy;
+            fz_t[j] -= force_mag * dz;
+        }
+    }
+    fx_t[i] += fx;
+    fy_t[i] += fy;
+    fz_t[i] += fz;
+    *virial += row_virial;
+    return row_potential;
+}
+
+double lj_row_scalar(size_t i, const int* neighbors, size_t count,
+                     const double* x, const double* y, const double* z, const PairParams* pair,
+                     double* fx_t, double* fy_t, double* fz_t, double* virial) {
+    int periodic = pair->box[0] > 0.0;
+    int switched = pair->split != FORCE_FULL;
+    int tabulated = pair->table != NULL; // Single species only, so never together with mixed
+    int mixed = pair->type != NULL;
+    switch (periodic | switched << 1 | tabulated << 2 | mixed << 3) {
+    case 0: return lj_row_pairs(i, neighbors, count, x, y, z, pair, fx_t, fy_t, fz_t, virial, 0, 0, 0, 0);
+    case 1: return lj_row_pairs(i, neighbors, count, x, y, z, pair, fx_t, fy_t, fz_t, virial, 1, 0, 0, 0);
+    case 2: return lj_row_pairs(i, neighbors, count, x, y, z, pair, fx_t, fy_t, fz_t, virial, 0, 1, 0, 0);
+    case 3: return lj_row_pairs(i, neighbors, count, x, y, z, pair, fx_t, fy_t, fz_t, virial, 1, 1, 0, 0);
+    case 4: return lj_row_pairs(i, neighbors, count, x, y, z, pair, fx_t, fy_t, fz_t, virial, 0, 0, 1, 0);
+    case 5: return lj_row_pairs(i, neighbors, count, x, y, z, pair, fx_t, fy_t, fz_t, virial, 1, 0, 1, 0);
+    case 6: return lj_row_pairs(i, neighbors, count, x, y, z, pair, fx_t, fy_t, fz_t, virial, 0, 1, 1, 0);
+    case 7: return lj_row_pairs(i, neighbors, count, x, y, z, pair, fx_t, fy_t, fz_t, virial, 1, 1, 1, 0);
+    case 8: return lj_row_pairs(i, neighbors, count, x, y, z, pair, fx_t, fy_t, fz_t, virial, 0, 0, 0, 1);
+    case 9: return lj_row_pairs(i, neighbors, count, x, y, z, pair, fx_t, fy_t, fz_t, virial, 1, 0, 0, 1);
+    case 10: return lj_row_pairs(i, neighbors, count, x, y, z, pair, fx_t, fy_t, fz_t, virial, 0, 1, 0, 1);
+    default: return lj_row_pairs(i, neighbors, count, x, y, z, pair, fx_t, fy_t, fz_t, virial, 1, 1, 0, 1);
+    }
+}
+
+#ifdef HAVE_X86_SIMD
+// Function to compute one neighbor-list row four pairs at a time with AVX2.
+// Partner coordinates are loaded lane by lane (faster than vgatherdpd on most AVX2 parts); the tail
+// is padded with i itself, whose r^2 = 0 masks it out like any pair outside the cutoff.
+// Partner forces are scattered back one lane at a time.
+__attribute__((target("avx2,fma")))
+static inline __m256d minimum_image_avx2(__m256d d, __m256d L, __m256d half_L) {
+    d = _mm256_sub_pd(d, _mm256_and_pd(_mm256_cmp_pd(d, half_L, _CMP_GT_OQ), L));
+    return _mm256_add_pd(d, _mm256_and_pd(_mm256_cmp_pd(d, _mm256_sub_pd(_mm256_setzero_pd(), half_L), _CMP_LT_OQ), L));
+}
+
+// Function to evaluate S (inner) or 1 - S (outer) of the r-RESPA switch for four pairs, see switch_factor
+__attribute__((target("avx2,fma")))
+static inline __m256d switch_factor_avx2(__m256d r2, const PairParams* pair) {
+    const __m256d one = _mm256_set1_pd(1.0);
+    __m256d y = _mm256_mul_pd(_mm256_sub_pd(_mm256_sqrt_pd(r2), _mm256_set1_pd(pair->switch_start)),
+                              _mm256_set1_pd(pair->inv_switch_width));
+    y = _mm256_min_pd(_mm256_max_pd(y, _mm256_setzero_pd()), one);
+    __m256d s = _mm256_fnmadd_pd(_mm256_mul_pd(y, y), _mm256_fnmadd_pd(_mm256_set1_pd(2.0), y, _mm256_set1_pd(3.0)), one);
+    return pair->split == FORCE_INNER ? s : _mm256_sub_pd(one, s);
+}
+
+// Function to evaluate the LJ pair for four r^2 like lj_pair, with the coefficients of every lane in lj
+// (sigma2, eps4, eps24, shift): returns the force over r and stores the energy minus shift in *energy
+__attribute__((target("avx2,fma")))
+static inline __m256d lj_pair_avx2(__m256d r2, const __m256d lj[4], __m256d* energy) {
+    __m256d inv_r2 = _mm256_div_pd(_mm256_set1_pd(1.0), r2);
+    __m256d sr2 = _mm256_mul_pd(lj[0], inv_r2);
+    __m256d sr6 = _mm256_mul_pd(_mm256_mul_pd(sr2, sr2), sr2);
+    __m256d sr12 = _mm256_mul_pd(sr6, sr6);
+    *energy = _mm256_fmsub_pd(lj[1], _mm256_sub_pd(sr12, sr6), lj[3]);
+    return _mm256_mul_pd(_mm256_mul_pd(lj[2], _mm256_fmsub_pd(_mm256_set1_pd(2.0), sr12, sr6)), inv_r2);
+}
+
+// Function to load the LJ coefficients of four partners from the row of atom i's type: one load per
+// partner (a whole LJCoefficients), transposed into sigma2, eps4, eps24 and shift vectors
+__attribute__((target("avx2,fma")))
+static inline void gather_lj_avx2(const LJCoefficients* row_lj, const int* type, const int idx[4], __m256d lj[4]) {
+    __m256d a = _mm256_loadu_pd(&row_lj[type[idx[0]]].sigma2), b = _mm256_loadu_pd(&row_lj[type[idx[1]]].sigma2);
+    __m256d c = _mm256_loadu_pd(&row_lj[type[idx[2]]].sigma2), d = _mm256_loadu_pd(&row_lj[type[idx[3]]].sigma2);
+    __m256d ab_even = _mm256_unpacklo_pd(a, b), ab_odd = _mm256_unpackhi_pd(a, b);
+    __m256d cd_even = _mm256_unpacklo_pd(c, d), cd_odd = _mm256_unpackhi_pd(c, d);
+    lj[0] = _mm256_permute2f128_pd(ab_even, cd_even, 0x20);
+    lj[1] = _mm256_permute2f128_pd(ab_odd, cd_odd, 0x20);
+    lj[2] = _mm256_permute2f128_pd(ab_even, cd_even, 0x31);
+    lj[3] = _mm256_permute2f128_pd(ab_odd, cd_odd, 0x31);
+}
+
+// Function to look up the LJ table for four r^2 like lj_pair_table (see lj_pair_avx2 for the results).
+// Only the lanes set in mask are read; those below the table are computed with lj_pair_avx2.
+__attribute__((target("avx2,fma")))
+static inline __m256d lj_table_avx2(const LJTable* table, __m256d r2, __m256d mask, const __m256d lj[4],
+                                    __m256d* energy) {
+    const __m256d r2_min = _mm256_set1_pd(table->r2_min), zero = _mm256_setzero_pd();
+    __m256d close = _mm256_and_pd(mask, _mm256_cmp_pd(r2, r2_min, _CMP_LT_OQ));
+    __m256d tabulated = _mm256_andnot_pd(close, mask);
+    __m256d t = _mm256_mul_pd(_mm256_sub_pd(r2, r2_min), _mm256_set1_pd(table->inv_h));
+    __m128i k = _mm256_cvttpd_epi32(t);
+    __m256d f = _mm256_sub_pd(t, _mm256_cvtepi32_pd(k));
+    __m128i base = _mm_slli_epi32(k, 3);
+    const double* c = table->coeff;
+    __m256d c0 = _mm256_mask_i32gather_pd(zero, c + 0, base, tabulated, 8);
+    __m256d c1 = _mm256_mask_i32gather_pd(zero, c + 1, base, tabulated, 8);
+    __m256d c2 = _mm256_mask_i32gather_pd(zero, c + 2, base, tabulated, 8);
+    __m256d c3 = _mm256_mask_i32gather_pd(zero, c + 3, base, tabulated, 8);
+    __m256d e = _mm256_fmadd_pd(_mm256_fmadd_pd(_mm256_fmadd_pd(c3, f, c2), f, c1), f, c0);
+    c0 = _mm256_mask_i32gather_pd(zero, c + 4, base, tabulated, 8);
+    c1 = _mm256_mask_i32gather_pd(zero, c + 5, base, tabulated, 8);
+    c2 = _mm256_mask_i32gather_pd(zero, c + 6, base, tabulated, 8);
+    c3 = _mm256_mask_i32gather_pd(zero, c + 7, base, tabulated, 8);
+    __m256d force_mag = _mm256_fmadd_pd(_mm256_fmadd_pd(_mm256_fmadd_pd(c3, f, c2), f, c1), f, c0);
+    *energy = _mm256_sub_pd(e, lj[3]);
+    if (_mm256_movemask_pd(close) != 0) {
+        __m256d close_energy;
+        __m256d close_force = lj_pair_avx2(r2, lj, &close_energy);
+        *energy = _mm256_blendv_pd(*energy, close_energy, close);
+        force_mag = _mm256_blendv_pd(force_mag, close_force, close);
+    }
+    return force_mag;
+}
+
+__attribute__((target("avx2,fma")))
+double lj_row_avx2(size_t i, const int* neighbors, size_t count,
+                   const double* x, const double* y, const double* z, const PairParams* pair,
+                   double* fx_t, double* fy_t, double* fz_t, double* virial) {
+    const __m256d xi = _mm256_set1_pd(x[i]), yi = _mm256_set1_pd(y[i]), zi = _mm256_set1_pd(z[i]);
+    const __m256d cut2 = _mm256_set1_pd(pair->cutoff2), zero = _mm256_setzero_pd();
+    const __m256d Lx = _mm256_set1_pd(pair->box[0]), Ly = _mm256_set1_pd(pair->box[1]), Lz = _mm256_set1_pd(pair->box[2]);
+    const __m256d hx = _mm256_set1_pd(0.5 * pair->box[0]), hy = _mm256_set1_pd(0.5 * pair->box[1]);
+    const __m256d hz = _mm256_set1_pd(0.5 * pair->box[2]);
+    const int periodic = pair->box[0] > 0.0, mixed = pair->type != NULL;
+    const LJCoefficients* row_lj = pair->lj + (mixed ? pair->type[i] * pair->n_types : 0);
+    __m256d lj[4] = { _mm256_set1_pd(row_lj->sigma2), _mm256_set1_pd(row_lj->eps4), _mm256_set1_pd(row_lj->eps24),
+                      _mm256_set1_pd(row_lj->shift) };
+    __m256d fx = zero, fy = zero, fz = zero, potential = zero, row_virial = zero;
+
+    for (size_t k = 0; k < count; k += 4) {
+        int idx[4] = { (int)i, (int)i, (int)i, (int)i };
+        size_t lanes = count - k < 4 ? count - k : 4;
+        memcpy(idx, neighbors + k, lanes * sizeof(int));
+
+        __m256d dx = _mm256_sub_pd(xi, _mm256_setr_pd(x[idx[0]], x[idx[1]], x[idx[2]], x[idx[3]]));
+        __m256d dy = _mm256_sub_pd(yi, _mm256_setr_pd(y[idx[0]], y[idx[1]], y[idx[2]], y[idx[3]]));
+        __m256d dz = _mm256_sub_pd(zi, _mm256_setr_pd(z[idx[0]], z[idx[1]], z[idx[2]], z[idx[3]]));
+        if (periodic) {
+            dx = minimum_image_avx2(dx, Lx, hx);
+            dy = minimum_image_avx2(dy, Ly, hy);
+            dz = minimum_image_avx2(dz, Lz, hz);
+        }
+        __m256d r2 = _mm256_fmadd_pd(dx, dx, _mm256_fmadd_pd(dy, dy, _mm256_mul_pd(dz, dz)));
+        __m256d in_range = _mm256_and_pd(_mm256_cmp_pd(r2, cut2, _CMP_LT_OQ), _mm256_cmp_pd(r2, zero, _CMP_GT_OQ));
+
+        if (mixed) {
+            gather_lj_avx2(row_lj, pair->type, idx, lj);
+        }
+        __m256d energy;
+        __m256d force_mag = pair->table != NULL ? lj_table_avx2(pair->table, r2, in_range, lj, &energy)
+                                                : lj_pair_avx2(r2, lj, &energy);
+        force_mag = _mm256_and_pd(force_mag, in_range);
+        potential = _mm256_add_pd(potential, _mm256_and_pd(energy, in_range));
+        row_virial = _mm256_fmadd_pd(force_mag, r2, row_virial);
+        if (pair->split != FORCE_FULL) {
+            force_mag = _mm256_mul_pd(force_mag, switch_factor_avx2(r2, pair));
+        }
+
+        __m256d fdx = _mm256_mul_pd(force_mag, dx);
+        __m256d fdy = _mm256_mul_pd(force_mag, dy);
+        __m256d fdz = _mm256_mul_pd(force_mag, dz);
+        fx = _mm256_add_pd(fx, fdx);
+        fy = _mm256_add_pd(fy, fdy);
+        fz = _mm256_add_pd(fz, fdz);
+
+        double px[4], py[4], pz[4];
+        _mm256_storeu_pd(px, fdx);
+        _mm256_storeu_pd(py, fdy);
+        _mm256_storeu_pd(pz, fdz);
+        for (size_t lane = 0; lane < lanes; lane++) {
+            fx_t[idx[lane]] -= px[lane];
+            fy_t[idx[lane]] -= py[lane];
+            fz_t[idx[lane]] -= pz[lane];
+        }
+    }
+
+    double sum[4];
+    _mm256_storeu_pd(sum, fx);
+    fx_t[i] += (sum[0] + sum[1]) + (sum[2] + sum[3]);
+    _mm256_storeu_pd(sum, fy);
+    fy_t[i] += (sum[0] + sum[1]) + (sum[2] + sum[3]);
+    _mm256_storeu_pd(sum, fz);
+    fz_t[i] += (sum[0] + sum[1]) + (sum[2] + sum[3]);
+    _mm256_storeu_pd(sum, row_virial);
+    *virial += (sum[0] + sum[1]) + (sum[2] + sum[3]);
+    _mm256_storeu_pd(sum, potential);
+    return (sum[0] + sum[1]) + (sum[2] + sum[3]);
+}
+
+// Function to compute one neighbor-list row eight pairs at a time with AVX-512.
+// The tail uses a lane mask; partner forces go back with a masked gather/subtract/scatter,
+// which is safe because a row never lists the same partner twice.
+__attribute__((target("avx512f")))
+static inline __attribute__((target("avx512f"))) __m512d minimum_image_avx512(__m512d d, double L) {
+    const __m512d L_v = _mm512_set1_pd(L), half_L = _mm512_set1_pd(0.5 * L);
+    d = _mm512_mask_sub_pd(d, _mm512_cmp_pd_mask(d, half_L, _CMP_GT_OQ), d, L_v);
+    return _mm512_mask_add_pd(d, _mm512_cmp_pd_mask(d, _mm512_set1_pd(-0.5 * L), _CMP_LT_OQ), d, L_v);
+}
+
+// Function to evaluate S (inner) or 1 - S (outer) of the r-RESPA switch for eight pairs, see switch_factor
+__attribute__((target("avx512f")))
+static inline __m512d switch_factor_avx512(__m512d r2, const PairParams* pair) {
+    const __m512d one = _mm512_set1_pd(1.0);
+    __m512d y = _mm512_mul_pd(_mm512_sub_pd(_mm512_sqrt_pd(r2), _mm512_set1_pd(pair->switch_start)),
+                              _mm512_set1_pd(pair->inv_switch_width));
+    y = _mm512_min_pd(_mm512_max_pd(y, _mm512_setzero_pd()), one);
+    __m512d s = _mm512_fnmadd_pd(_mm512_mul_pd(y, y), _mm512_fnmadd_pd(_mm512_set1_pd(2.0), y, _mm512_set1_pd(3.0)), one);
+    return pair->split == FORCE_INNER ? s : _mm512_sub_pd(one, s);
+}
+
+// Function to evaluate the LJ pair for the eight r^2 in mask like lj_pair, with the coefficients of every
+// lane in lj (sigma2, eps4, eps24, shift): returns the force over r (0 outside mask) and stores the
+// energy minus shift in *energy
+__attribute__((target("avx512f")))
+static inline __m512d lj_pair_avx512(__m512d r2, __mmask8 mask, const __m512d lj[4], __m512d* energy) {
+    __m512d inv_r2 = _mm512_maskz_div_pd(mask, _mm512_set1_pd(1.0), r2);
+    __m512d sr2 = _mm512_mul_pd(lj[0], inv_r2);
+    __m512d sr6 = _mm512_mul_pd(_mm512_mul_pd(sr2, sr2), sr2);
+    __m512d sr12 = _mm512_mul_pd(sr6, sr6);
+    *energy = _mm512_fmsub_pd(lj[1], _mm512_sub_pd(sr12, sr6), lj[3]);
+    return _mm512_mul_pd(_mm512_mul_pd(lj[2], _mm512_fmsub_pd(_mm512_set1_pd(2.0), sr12, sr6)), inv_r2);
+}
+
+// Function to gather the LJ coefficients of the eight partners j (lanes in mask) from the row of atom
+// i's type into sigma2, eps4, eps24 and shift vectors
+__attribute__((target("avx512f")))
+static inline void gather_lj_avx512(const LJCoefficients* row_lj, const int* type, __m256i j, __mmask8 mask,
+                                    __m512d lj[4]) {
+    __m256i tj = _mm512_castsi512_si256(
+        _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), (__mmask16)mask, _mm512_castsi256_si512(j), type, 4));
+    __m256i base = _mm256_slli_epi32(tj, 2); // Four doubles per LJCoefficients
+    const double* c = &row_lj->sigma2;
+    for (int m = 0; m < 4; m++) {
+        lj[m] = _mm512_mask_i32gather_pd(_mm512_setzero_pd(), mask, base, c + m, 8);
+    }
+}
+
+// Function to look up the LJ table for the eight r^2 in mask like lj_pair_table (see lj_pair_avx512 for
+// the results); lanes below the table are computed with lj_pair_avx512
+__attribute__((target("avx512f")))
+static inline __m512d lj_table_avx512(const LJTable* table, __m512d r2, __mmask8 mask, const __m512d lj[4],
+                                      __m512d* energy) {
+    const __m512d r2_min = _mm512_set1_pd(table->r2_min), zero = _mm512_setzero_pd();
+    __mmask8 close = _mm512_mask_cmp_pd_mask(mask, r2, r2_min, _CMP_LT_OQ);
+    __mmask8 tabulated = mask & ~close;
+    __m512d t = _mm512_mul_pd(_mm512_sub_pd(r2, r2_min), _mm512_set1_pd(table->inv_h));
+    __m256i k = _mm512_cvttpd_epi32(t);
+    __m512d f = _mm512_sub_pd(t, _mm512_cvtepi32_pd(k));
+    __m256i base = _mm256_slli_epi32(k, 3);
+    const double* c = table->coeff;
+    __m512d c0 = _mm512_mask_i32gather_pd(zero, tabulated, base, c + 0, 8);
+    __m512d c1 = _mm512_mask_i32gather_pd(zero, tabulated, base, c + 1, 8);
+    __m512d c2 = _mm512_mask_i32gather_pd(zero, tabulated, base, c + 2, 8);
+    __m512d c3 = _mm512_mask_i32gather_pd(zero, tabulated, base, c + 3, 8);
+    __m512d e = _mm512_fmadd_pd(_mm512_fmadd_pd(_mm512_fmadd_pd(c3, f, c2), f, c1), f, c0);
+    c0 = _mm512_mask_i32gather_pd(zero, tabulated, base, c + 4, 8);
+    c1 = _mm512_mask_i32gather_pd(zero, tabulated, base, c + 5, 8);
+    c2 = _mm512_mask_i32gather_pd(zero, tabulated, base, c + 6, 8);
+    c3 = _mm512_mask_i32gather_pd(zero, tabulated, base, c + 7, 8);
+    __m512d force_mag = _mm512_fmadd_pd(_mm512_fmadd_pd(_mm512_fmadd_pd(c3, f, c2), f, c1), f, c0);
+    *energy = _mm512_sub_pd(e, lj[3]);
+    if (close != 0) {
+        __m512d close_energy;
+        __m512d close_force = lj_pair_avx512(r2, close, lj, &close_energy);
+        *energy = _mm512_mask_mov_pd(*energy, close, close_energy);
+        force_mag = _mm512_mask_mov_pd(force_mag, close, close_force);
+    }
+    return force_mag;
+}
+
+__attribute__((target("avx512f")))
+double lj_row_avx512(size_t i, const int* neighbors, size_t count,
+                     const double* x, const double* y, const double* z, const PairParams* pair,
+                     double* fx_t, double* fy_t, double* fz_t, double* virial) {
+    const __m512d xi = _mm512_set1_pd(x[i]), yi = _mm512_set1_pd(y[i]), zi = _mm512_set1_pd(z[i]);
+    const __m512d cut2 = _mm512_set1_pd(pair->cutoff2), zero = _mm512_setzero_pd();
+    const int periodic = pair->box[0] > 0.0, mixed = pair->type != NULL;
+    const LJCoefficients* row_lj = pair->lj + (mixed ? pair->type[i] * pair->n_types : 0);
+    __m512d lj[4] = { _mm512_set1_pd(row_lj->sigma2), _mm512_set1_pd(row_lj->eps4), _mm512_set1_pd(row_lj->eps24),
+                      _mm512_set1_pd(row_lj->shift) };
+    __m512d fx = zero, fy = zero, fz = zero, potential = zero, row_virial = zero;
+
+    for (size_t k = 0; k < count; k += 8) {
+        size_t lanes = count - k < 8 ? count - k : 8;
+        __mmask8 valid = (__mmask8)((1u << lanes) - 1);
+        __m256i j;
+        if (lanes == 8) {
+            j = _mm256_loadu_si256((const __m256i*)(neighbors + k));
+        } else {
+            int idx[8] = { 0 };
+            memcpy(idx, neighbors + k, lanes * sizeof(int));
+            j = _mm256_loadu_si256((const __m256i*)idx);
+        }
+
+        __m512d dx = _mm512_sub_pd(xi, _mm512_mask_i32gather_pd(zero, valid, j, x, 8));
+        __m512d dy = _mm512_sub_pd(yi, _mm512_mask_i32gather_pd(zero, valid, j, y, 8));
+        __m512d dz = _mm512_sub_pd(zi, _mm512_mask_i32gather_pd(zero, valid, j, z, 8));
+        if (periodic) {
+            dx = minimum_image_avx512(dx, pair->box[0]);
+            dy = minimum_image_avx512(dy, pair->box[1]);
+            dz = minimum_image_avx512(dz, pair->box[2]);
+        }
+        __m512d r2 = _mm512_fmadd_pd(dx, dx, _mm512_fmadd_pd(dy, dy, _mm512_mul_pd(dz, dz)));
+        __mmask8 in_range = _mm512_mask_cmp_pd_mask(valid, r2, cut2, _CMP_LT_OQ) &
+                            _mm512_cmp_pd_mask(r2, zero, _CMP_GT_OQ);
+
+        if (mixed) {
+            gather_lj_avx512(row_lj, pair->type, j, valid, lj);
+        }
+        __m512d energy;
+        __m512d force_mag = pair->table != NULL ? lj_table_avx512(pair->table, r2, in_range, lj, &energy)
+                                                : lj_pair_avx512(r2, in_range, lj, &energy);
+        potential = _mm512_mask_add_pd(potential, in_range, potential, energy);
+        row_virial = _mm512_fmadd_pd(force_mag, r2, row_virial);
+        if (pair->split != FORCE_FULL) {
+            force_mag = _mm512_mul_pd(force_mag, switch_factor_avx512(r2, pair));
+        }
+
+        __m512d fdx = _mm512_mul_pd(force_mag, dx);
+        __m512d fdy = _mm512_mul_pd(force_mag, dy);
+        __m512d fdz = _mm512_mul_pd(force_mag, dz);
+        fx = _mm512_add_pd(fx, fdx);
+        fy = _mm512_add_pd(fy, fdy);
+        fz = _mm512_add_pd(fz, fdz);
+
+        _mm512_mask_i32scatter_pd(fx_t, in_range, j, _mm512_sub_pd(_mm512_mask_i32gather_pd(zero, in_range, j, fx_t, 8), fdx), 8);
+        _mm512_mask_i32scatter_pd(fy_t, in_range, j, _mm512_sub_pd(_mm512_mask_i32gather_pd(zero, in_range, j, fy_t, 8), fdy), 8);
+        _mm512_mask_i32scatter_pd(fz_t, in_range, j, _mm512_sub_pd(_mm512_mask_i32gather_pd(zero, in_range, j, fz_t, 8), fdz), 8);
+    }
+
+    fx_t[i] += _mm512_reduce_add_pd(fx);
+    fy_t[i] += _mm512_reduce_add_pd(fy);
+    fz_t[i] += _mm512_reduce_add_pd(fz);
+    *virial += _mm512_reduce_add_pd(row_virial);
+    return _mm512_reduce_add_pd(potential);
+}
+#endif
+
+// Function to pick the neighbor-list kernel: "auto" takes the widest instruction set the CPU
+// supports (CPUID), "scalar", "avx2" or "avx512" force one. Returns 0 if it is not available.
+int select_lj_kernel(Simulation* sim, const char* requested) {
+    int want_auto = strcmp(requested, "auto") == 0;
+    sim->lj_row = lj_row_scalar;
+    sim->lj_kernel_name = "scalar";
+#ifdef HAVE_X86_SIMD
+    __builtin_cpu_init();
+    if ((want_auto || strcmp(requested, "avx512") == 0) && __builtin_cpu_supports("avx512f")) {
+        sim->lj_row = lj_row_avx512;
+        sim->lj_kernel_name = "avx512";
+        return 1;
+    }
+    if ((want_auto || strcmp(requested, "avx2") == 0) && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        sim->lj_row = lj_row_avx2;
+        sim->lj_kernel_name = "avx2";
+        return 1;
+    }
+#endif
+    return want_auto || strcmp(requested, "scalar") == 0;
+}
+
+// Function to compute accelerations and the LJ potential within the cutoff from the neighbor list.
+// The potential is shifted to zero at the cutoff so the energy has no jump when pairs cross it.
+// In a periodic box pairs use the minimum image, and positions are wrapped at every rebuild.
+// split selects the full force or one r-RESPA part: FORCE_INNER runs over the short inner list only
+// (its energy and virial are not meaningful), FORCE_OUTER over the full list, returning the full energy.
+double compute_acc_cutoff(Simulation* sim, double* restrict ax, double* restrict ay, double* restrict az, int split) {
+    size_t Natoms = sim->Natoms;
+    NeighborList* nl = sim->nlist;
+    const double* x = sim->x;
+    const double* y = sim->y;
+    const double* z = sim->z;
+    if (nl->rebuilds == 0 || neighbor_list_expired(nl, Natoms, x, y, z)) {
+        rebuild_neighbor_list(sim);
+    }
+
+    PairParams pair;
+    pair.cutoff2 = nl->cutoff * nl->cutoff;
+    pair.lj = sim->species.lj;
+    pair.type = sim->type;
+    pair.n_types = sim->species.n_types;
+    memcpy(pair.box, sim->box, sizeof(pair.box));
+    pair.split = split;
+    pair.switch_start = nl->inner_cutoff - sim->switch_width;
+    pair.inv_switch_width = split != FORCE_FULL ? 1.0 / sim->switch_width : 0.0;
+    pair.table = sim->lj_table;
+    const size_t* start = nl->start;
+    const int* neighbors = nl->neighbors;
+    if (split == FORCE_INNER) {
+        pair.cutoff2 = nl->inner_cutoff * nl->inner_cutoff;
+        start = nl->inner_start;
+        neighbors = nl->inner_neighbors;
+    }
+    double total_potential = 0.0;
+    double total_virial = 0.0;
+
+    // Each pair is visited once and its force applied to both atoms, in per-thread buffers
+    #pragma omp parallel reduction(+:total_potential, total_virial)
+    {
+        double *fx_t, *fy_t, *fz_t;
+        thread_force_buffer(sim, ax, ay, az, &fx_t, &fy_t, &fz_t);
+
+        #pragma omp for schedule(dynamic, 64)
+        for (size_t i = 0; i < Natoms; i++) {
+            total_potential += sim->lj_row(i, neighbors + start[i], start[i + 1] - start[i],
+                                           x, y, z, &pair, fx_t, fy_t, fz_t, &total_virial);
+        }
+
+        reduce_thread_forces(sim, ax, ay, az);
+    }
+
+    if (split != FORCE_INNER) {
+        sim->virial = total_virial;
+    }
+    return total_potential;
+}
+
+// Function to compute accelerations and the LJ potential, with the neighbor list if there is one.
+// In a periodic box the potential includes the long-range tail correction.
+double compute_forces(Simulation* sim, double* ax, double* ay, double* az) {
+    if (sim->nlist != NULL) {
+        return compute_acc_cutoff(sim, ax, ay, az, FORCE_FULL) + sim->energy_tail;
+    }
+    return compute_acc(sim, ax, ay, az);
+}
+
+// Function to compute the pressure of a periodic box from the virial theorem,
+// P = (2 KE + sum r.F) / (3 V) + P_tail, in kcal/mol/nm^3
+double compute_pressure(const Simulation* sim, double kinetic_energy) {
+    double volume = sim->box[0] * sim->box[1] * sim->box[2];
+    return (2.0 * kinetic_energy + sim->virial) / (3.0 * volume) + sim->pressure_tail;
+}
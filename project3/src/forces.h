@@ -0,0 +1,46 @@
+// File: src/forces.h
+
+#ifndef FORCES_H
+#define FORCES_H
+
+#include "simulation.h"
+
+// Neighbor-list kernels, see LJRowKernel
+double lj_row_scalar(size_t i, const int* neighbors, size_t count,
+                     const double* x, const double* y, const double* z, const PairParams* pair,
+                     double* fx_t, double* fy_t, double* fz_t, double* virial);
+#ifdef HAVE_X86_SIMD
+double lj_row_avx2(size_t i, const int* neighbors, size_t count,
+                   const double* x, const double* y, const double* z, const PairParams* pair,
+                   double* fx_t, double* fy_t, double* fz_t, double* virial);
+double lj_row_avx512(size_t i, const int* neighbors, size_t count,
+                     const double* x, const double* y, const double* z, const PairParams* pair,
+                     double* fx_t, double* fy_t, double* fz_t, double* virial);
+#endif
+
+// Function to get and zero the force accumulators of the calling thread inside a parallel region
+void thread_force_buffer(const Simulation* sim, double* ax, double* ay, double* az, double** fx, double** fy, double** fz);
+
+// Function to add the per-thread forces into ax/ay/az and divide by the masses
+void reduce_thread_forces(const Simulation* sim, double* restrict ax, double* restrict ay, double* restrict az);
+
+// Function to compute kinetic energy
+double compute_kinetic_energy(const Simulation* sim);
+
+// Function to compute accelerations and the LJ potential over all pairs
+double compute_acc(const Simulation* sim, double* restrict ax, double* restrict ay, double* restrict az);
+
+// Function to pick the neighbor-list kernel ("auto", "scalar", "avx2" or "avx512"); returns 0 if it is not available
+int select_lj_kernel(Simulation* sim, const char* requested);
+
+// Function to compute accelerations and the LJ potential within the cutoff from the neighbor list;
+// split selects the full force or one r-RESPA part
+double compute_acc_cutoff(Simulation* sim, double* restrict ax, double* restrict ay, double* restrict az, int split);
+
+// Function to compute accelerations and the LJ potential, with the neighbor list if there is one
+double compute_forces(Simulation* sim, double* ax, double* ay, double* az);
+
+// Function to compute the pressure of a periodic box from the virial theorem
+double compute_pressure(const Simulation* sim, double kinetic_energy);
+
+#endif // FORCES_H
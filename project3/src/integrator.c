@@ -0,0 +1,217 @@
+// File: src/integrator.c
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "forces.h"
+#include "integrator.h"
+#include "util.h"
+
+// Function to advance one position component: x += v dt + a dt^2 / 2
+void advance_positions(size_t Natoms, double dt, double* restrict x, const double* restrict v, const double* restrict a) {
+    #pragma omp parallel for simd schedule(static)
+    for (size_t i = 0; i < Natoms; i++) {
+        x[i] += v[i] * dt + 0.5 * a[i] * dt * dt;
+    }
+}
+
+// Function to advance one velocity component: v += (a + a_new) dt / 2
+void advance_velocities(size_t Natoms, double dt, double* restrict v, const double* restrict a, const double* restrict a_new) {
+    #pragma omp parallel for simd schedule(static)
+    for (size_t i = 0; i < Natoms; i++) {
+        v[i] += 0.5 * (a[i] + a_new[i]) * dt;
+    }
+}
+
+// Verlet integration for updating positions and velocities; returns the new LJ potential.
+// Nothing is allocated here: the new accelerations go to the ax_new/ay_new/az_new buffers,
+// which are then swapped with ax/ay/az.
+double verlet_update(Simulation* sim, double dt) {
+    size_t Natoms = sim->Natoms;
+
+    // Update positions
+    advance_positions(Natoms, dt, sim->x, sim->vx, sim->ax);
+    advance_positions(Natoms, dt, sim->y, sim->vy, sim->ay);
+    advance_positions(Natoms, dt, sim->z, sim->vz, sim->az);
+
+    // Update accelerations
+    double LJ_potential = compute_forces(sim, sim->ax_new, sim->ay_new, sim->az_new);
+
+    // Update velocities
+    advance_velocities(Natoms, dt, sim->vx, sim->ax, sim->ax_new);
+    advance_velocities(Natoms, dt, sim->vy, sim->ay, sim->ay_new);
+    advance_velocities(Natoms, dt, sim->vz, sim->az, sim->az_new);
+
+    // The new accelerations become the current ones
+    double* swap;
+    swap = sim->ax; sim->ax = sim->ax_new; sim->ax_new = swap;
+    swap = sim->ay; sim->ay = sim->ay_new; sim->ay_new = swap;
+    swap = sim->az; sim->az = sim->az_new; sim->az_new = swap;
+
+    return LJ_potential;
+}
+
+// Function to switch the simulation to r-RESPA with respa_steps inner steps per time step.
+// The LJ force is split at inner_cutoff, smoothly over the last switch_width nm before it.
+void init_respa(Simulation* sim, int respa_steps, double inner_cutoff, double switch_width) {
+    size_t Natoms = sim->Natoms;
+    NeighborList* nl = sim->nlist;
+    sim->respa_steps = respa_steps;
+    sim->switch_width = switch_width;
+    nl->inner_cutoff = inner_cutoff;
+    nl->inner_capacity = 0;
+    nl->inner_start = malloc((Natoms + 1) * sizeof(size_t));
+    sim->ax_slow = malloc_aligned(Natoms);
+    sim->ay_slow = malloc_aligned(Natoms);
+    sim->az_slow = malloc_aligned(Natoms);
+    if (nl->inner_start == NULL || sim->ax_slow == NULL || sim->ay_slow == NULL || sim->az_slow == NULL) {
+        printf("Memory allocation failed for r-RESPA\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+// Function to compute both r-RESPA force parts at the current positions: the inner accelerations go
+// to ax/ay/az, the outer ones to ax_slow/ay_slow/az_slow. Returns the LJ potential.
+double compute_respa_forces(Simulation* sim) {
+    compute_acc_cutoff(sim, sim->ax, sim->ay, sim->az, FORCE_INNER);
+    return compute_acc_cutoff(sim, sim->ax_slow, sim->ay_slow, sim->az_slow, FORCE_OUTER) + sim->energy_tail;
+}
+
+// Function to add a dt-long kick to one velocity component: v += a dt
+void kick_velocities(size_t Natoms, double dt, double* restrict v, const double* restrict a) {
+    #pragma omp parallel for simd schedule(static)
+    for (size_t i = 0; i < Natoms; i++) {
+        v[i] += a[i] * dt;
+    }
+}
+
+// Function to move one position component at constant velocity: x += v dt
+void drift_positions(size_t Natoms, double dt, double* restrict x, const double* restrict v) {
+    #pragma omp parallel for simd schedule(static)
+    for (size_t i = 0; i < Natoms; i++) {
+        x[i] += v[i] * dt;
+    }
+}
+
+// r-RESPA step (Tuckerman, Berne & Martyna 1992); returns the new LJ potential. A half kick with the
+// outer forces brackets respa_steps velocity-Verlet steps of dt / respa_steps with the inner forces,
+// so the expensive full-list pass runs once per time step and only the short inner list every substep.
+double respa_update(Simulation* sim, double dt) {
+    size_t Natoms = sim->Natoms;
+    double dt_inner = dt / sim->respa_steps;
+    double* v[3] = { sim->vx, sim->vy, sim->vz };
+    double* coord[3] = { sim->x, sim->y, sim->z };
+    double* a_fast[3] = { sim->ax, sim->ay, sim->az };
+    double* a_slow[3] = { sim->ax_slow, sim->ay_slow, sim->az_slow };
+
+    for (int dim = 0; dim < 3; dim++) {
+        kick_velocities(Natoms, 0.5 * dt, v[dim], a_slow[dim]);
+    }
+    for (int sub = 0; sub < sim->respa_steps; sub++) {
+        for (int dim = 0; dim < 3; dim++) {
+            kick_velocities(Natoms, 0.5 * dt_inner, v[dim], a_fast[dim]);
+            drift_positions(Natoms, dt_inner, coord[dim], v[dim]);
+        }
+        if (sub < sim->respa_steps - 1) {
+            compute_acc_cutoff(sim, sim->ax, sim->ay, sim->az, FORCE_INNER);
+            for (int dim = 0; dim < 3; dim++) {
+                kick_velocities(Natoms, 0.5 * dt_inner, v[dim], a_fast[dim]);
+            }
+        }
+    }
+
+    // Both parts at the new positions, then the closing half kicks
+    double LJ_potential = compute_respa_forces(sim);
+    for (int dim = 0; dim < 3; dim++) {
+        kick_velocities(Natoms, 0.5 * dt_inner, v[dim], a_fast[dim]);
+        kick_velocities(Natoms, 0.5 * dt, v[dim], a_slow[dim]);
+    }
+    return LJ_potential;
+}
+
+// Function to advance the simulation by one time step with the configured integrator
+double integrate_step(Simulation* sim, double dt) {
+    return sim->respa_steps > 1 ? respa_update(sim, dt) : verlet_update(sim, dt);
+}
+
+// Function to add the total energy at a given simulation time to the statistics
+void monitor_energy(EnergyMonitor* m, double time, double total_energy) {
+    if (m->samples == 0) {
+        memset(m, 0, sizeof(*m));
+        m->t0 = time;
+        m->E0 = total_energy;
+    }
+    double t = time - m->t0, E = total_energy - m->E0;
+    m->samples++;
+    m->sum_t += t;
+    m->sum_E += E;
+    m->sum_tt += t * t;
+    m->sum_tE += t * E;
+    m->sum_EE += E * E;
+    if (fabs(E) > m->max_deviation) m->max_deviation = fabs(E);
+}
+
+// Function to print the energy drift (slope of a least-squares line through E(t)), the RMS fluctuation
+// around that line, both per atom, and how much simulated time the run covered per second of wall time
+void report_energy_conservation(const EnergyMonitor* m, size_t Natoms, double elapsed_time, double wall_seconds) {
+    if (m->samples < 2) return;
+    double n = (double)m->samples;
+    double var_t = m->sum_tt / n - (m->sum_t / n) * (m->sum_t / n);
+    double cov_tE = m->sum_tE / n - (m->sum_t / n) * (m->sum_E / n);
+    double var_E = m->sum_EE / n - (m->sum_E / n) * (m->sum_E / n);
+    double drift = var_t > 0.0 ? cov_tE / var_t : 0.0;
+    double residual = var_E - drift * cov_tE;
+    printf("Energy conservation over %zu steps (kcal/mol per atom): drift %.3e per time unit, RMS fluctuation %.3e, max |E - E0| %.3e\n",
+           m->samples, drift / (double)Natoms, sqrt(residual > 0.0 ? residual : 0.0) / (double)Natoms,
+           m->max_deviation / (double)Natoms);
+    printf("Simulated %.2f time units in %.3f s wall time (%.1f per second)\n",
+           elapsed_time, wall_seconds, wall_seconds > 0.0 ? elapsed_time / wall_seconds : 0.0);
+}
+
+// Function to print a strong-scaling table: force evaluation (and neighbor-list build) time
+// for 1, 2, 4, ... threads up to max_threads, on the current configuration
+void scaling_report(Simulation* sim, int max_threads) {
+    printf("Strong scaling, %zu atoms, %s\n", sim->Natoms,
+           sim->nlist != NULL ? "neighbor-list path" : "all-pairs path");
+    printf("%8s %14s %9s %11s %14s\n", "Threads", "Force (s)", "Speedup", "Efficiency", "List build (s)");
+
+    double t_one = 0.0;
+    for (int n_threads = 1; n_threads <= max_threads; n_threads = n_threads < max_threads && 2 * n_threads > max_threads ? max_threads : 2 * n_threads) {
+#ifdef _OPENMP
+        omp_set_num_threads(n_threads);
+#endif
+        double t_build = 0.0;
+        if (sim->nlist != NULL) {
+            double t0 = wall_time();
+            rebuild_neighbor_list(sim);
+            t_build = wall_time() - t0;
+        }
+
+        // Repeat until at least half a second has been measured
+        compute_forces(sim, sim->ax_new, sim->ay_new, sim->az_new);
+        int repeats = 0;
+        double t0 = wall_time(), elapsed;
+        do {
+            compute_forces(sim, sim->ax_new, sim->ay_new, sim->az_new);
+            repeats++;
+            elapsed = wall_time() - t0;
+        } while (elapsed < 0.5 && repeats < 1000);
+        double t_force = elapsed / repeats;
+        if (n_threads == 1) {
+            t_one = t_force;
+        }
+
+        printf("%8d %14.6f %9.2f %10.1f%% %14.6f\n", n_threads, t_force, t_one / t_force,
+               100.0 * t_one / t_force / n_threads, t_build);
+        if (n_threads == max_threads) {
+            break;
+        }
+    }
+#ifndef _OPENMP
+    printf("Built without OpenMP: every row ran on one thread (compile with -fopenmp)\n");
+#endif
+}
@@ -0,0 +1,52 @@
+// File: src/integrator.h
+
+#ifndef INTEGRATOR_H
+#define INTEGRATOR_H
+
+#include "simulation.h"
+
+// Running statistics of the total energy for the energy-conservation report
+typedef struct {
+    size_t samples;
+    double t0, E0;        // First sample; the sums hold values relative to it
+    double sum_t, sum_E, sum_tt, sum_tE, sum_EE;
+    double max_deviation; // Largest |E - E0|
+} EnergyMonitor;
+
+// Function to advance one position component: x += v dt + a dt^2 / 2
+void advance_positions(size_t Natoms, double dt, double* restrict x, const double* restrict v, const double* restrict a);
+
+// Function to advance one velocity component: v += (a + a_new) dt / 2
+void advance_velocities(size_t Natoms, double dt, double* restrict v, const double* restrict a, const double* restrict a_new);
+
+// Verlet integration for updating positions and velocities; returns the new LJ potential
+double verlet_update(Simulation* sim, double dt);
+
+// Function to switch the simulation to r-RESPA with respa_steps inner steps per time step
+void init_respa(Simulation* sim, int respa_steps, double inner_cutoff, double switch_width);
+
+// Function to compute both r-RESPA force parts at the current positions; returns the LJ potential
+double compute_respa_forces(Simulation* sim);
+
+// Function to add a dt-long kick to one velocity component: v += a dt
+void kick_velocities(size_t Natoms, double dt, double* restrict v, const double* restrict a);
+
+// Function to move one position component at constant velocity: x += v dt
+void drift_positions(size_t Natoms, double dt, double* restrict x, const double* restrict v);
+
+// r-RESPA step; returns the new LJ potential
+double respa_update(Simulation* sim, double dt);
+
+// Function to advance the simulation by one time step with the configured integrator
+double integrate_step(Simulation* sim, double dt);
+
+// Function to add the total energy at a given simulation time to the statistics
+void monitor_energy(EnergyMonitor* m, double time, double total_energy);
+
+// Function to print the energy drift and fluctuation per atom and the simulated time per wall-clock second
+void report_energy_conservation(const EnergyMonitor* m, size_t Natoms, double elapsed_time, double wall_seconds);
+
+// Function to print a strong-scaling table of the force evaluation and neighbor-list build
+void scaling_report(Simulation* sim, int max_threads);
+
+#endif // INTEGRATOR_H
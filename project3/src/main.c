@@ -0,0 +1,396 @@
+// File: src/main.c
+
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#ifdef USE_MPI
+#include <mpi.h>
+#endif
+#include "atoms.h"
+#include "checkpoint.h"
+#include "config.h"
+#include "domain.h"
+#include "ensemble.h"
+#include "forces.h"
+#include "integrator.h"
+#include "output_writer.h"
+#include "simulation.h"
+#include "species.h"
+#include "trajectory.h"
+#include "util.h"
+
+#ifdef USE_MPI
+// Function to shut MPI down however the program ends
+static void finalize_mpi(void) {
+    MPI_Finalize();
+}
+#endif
+
+// Set by SIGINT/SIGTERM: the run writes a checkpoint at the next step and stops
+static volatile sig_atomic_t stop_requested = 0;
+
+static void request_stop(int signal_number) {
+    (void)signal_number;
+    stop_requested = 1;
+}
+
+int main(int argc, char* argv[]) {
+    // File path
+    char trajectory_file[] = "trajectory.xyz";
+    char binary_trajectory_file[] = "trajectory.btr";
+    char energy_file[] = "energies.csv";
+
+    int n_ranks = 1; // MPI ranks (MPI build only)
+#ifdef USE_MPI
+    int mpi_thread_support;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &mpi_thread_support);
+    atexit(finalize_mpi);
+    MPI_Comm_size(MPI_COMM_WORLD, &n_ranks);
+#endif
+
+    // Run settings: defaults, then --config files and options in command-line order
+    RunConfig cfg;
+    default_run_config(&cfg);
+    int scaling = 0;
+    int restart = 0;
+    int usage = 0;
+    for (int arg = 1; arg < argc; arg++) {
+        if (strcmp(argv[arg], "--config") == 0 && arg + 1 < argc) {
+            if (!read_run_config(argv[++arg], &cfg)) {
+                return EXIT_FAILURE;
+            }
+        } else if (strcmp(argv[arg], "--restart") == 0) {
+            restart = 1;
+        } else if (strcmp(argv[arg], "--convert") == 0 && arg + 2 < argc) {
+            // Converter only: binary trajectory -> XYZ
+            int ok = convert_binary_trajectory(argv[arg + 1], argv[arg + 2]);
+            return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+        } else if (strcmp(argv[arg], "--scaling") == 0 && arg + 1 < argc) {
+            scaling = atoi(argv[++arg]);
+            if (scaling < 1) {
+                printf("Invalid thread count '%s'\n", argv[arg]);
+                return EXIT_FAILURE;
+            }
+        } else if (strncmp(argv[arg], "--", 2) == 0) {
+            // Any run setting: --output-interval 5 is the same as "output_interval = 5" in a config file
+            char key[64], value[256];
+            snprintf(key, sizeof(key), "%s", argv[arg] + 2);
+            for (char* c = key; *c != '\0'; c++) {
+                if (*c == '-') *c = '_';
+            }
+            int n_values = 1;
+            if (strcmp(key, "box") == 0 || strcmp(key, "species") == 0) n_values = 3;
+            if (strcmp(key, "species_pair") == 0) n_values = 4;
+            if (arg + n_values >= argc) {
+                usage = 1;
+                break;
+            }
+            value[0] = '\0';
+            for (int v = 1; v <= n_values; v++) {
+                size_t used = strlen(value);
+                snprintf(value + used, sizeof(value) - used, v > 1 ? " %s" : "%s", argv[arg + v]);
+            }
+            int status = set_run_option(&cfg, key, value);
+            if (status < 0) {
+                usage = 1;
+                break;
+            }
+            if (status == 0) {
+                printf("Invalid value for %s\n", argv[arg]);
+                return EXIT_FAILURE;
+            }
+            arg += n_values;
+        } else {
+            usage = 1;
+            break;
+        }
+    }
+    if (usage) {
+        printf("Usage: %s [--config <file>] [--restart] [--input <file>] [--steps <n>] [--timestep <dt>] [--output-interval <n>] [--cutoff <nm>] [--skin <nm>] [--box <Lx> <Ly> <Lz>] [--threads <n>] [--simd auto|scalar|avx2|avx512] [--lj-table <intervals>] [--reorder <rebuilds>] [--species <symbol> <eps> <sigma>] [--species-pair <symbol> <symbol> <eps> <sigma>] [--trajectory xyz|btr] [--precision <nm>] [--output-buffers <n>] [--checkpoint <file>] [--checkpoint-interval <n>] [--respa <n>] [--inner-cutoff <nm>] [--switch-width <nm>] [--ensemble <replicas>] [--ensemble-dir <dir>] [--perturb <nm>] [--temperature <K>] [--seed <n>] [--scaling <max_threads>]\n"
+               "       %s --convert <trajectory.btr> <trajectory.xyz>\n", argv[0], argv[0]);
+        return EXIT_FAILURE;
+    }
+    double* box = cfg.box;
+    int periodic = box[0] != 0.0 || box[1] != 0.0 || box[2] != 0.0;
+    if (periodic) {
+        double shortest = fmin(box[0], fmin(box[1], box[2]));
+        if (shortest <= 0.0 || cfg.cutoff <= 0.0 || cfg.cutoff > 0.5 * shortest) {
+            printf("A periodic box needs positive lengths and a --cutoff of at most half the shortest one\n");
+            return EXIT_FAILURE;
+        }
+    }
+    if (cfg.respa_steps > 1 && (cfg.cutoff <= 0.0 || cfg.inner_cutoff >= cfg.cutoff || cfg.switch_width > cfg.inner_cutoff)) {
+        printf("r-RESPA needs a --cutoff, an --inner-cutoff below it and a --switch-width of at most the inner cutoff\n");
+        return EXIT_FAILURE;
+    }
+    if (cfg.lj_table > 0 && cfg.cutoff <= 0.0) {
+        printf("--lj-table needs a --cutoff\n");
+        return EXIT_FAILURE;
+    }
+    if (cfg.reorder > 0 && cfg.cutoff <= 0.0) {
+        printf("--reorder needs a --cutoff\n");
+        return EXIT_FAILURE;
+    }
+    int checkpointing = cfg.checkpoint_file[0] != '\0';
+    if (restart && !checkpointing) {
+        printf("--restart needs a checkpoint file (--checkpoint or 'checkpoint' in the run configuration)\n");
+        return EXIT_FAILURE;
+    }
+
+    // Read atom data
+    Atom* atoms = NULL;
+    size_t atom_count = load_atoms(cfg.input_file, &atoms);
+    if (atom_count == 0) {
+        printf("No atoms found in %s\n", cfg.input_file);
+        return EXIT_FAILURE;
+    }
+    LJSpecies species;
+    int* type = NULL;
+    if (!init_species(&cfg, atoms, atom_count, cfg.cutoff, &species, &type)) {
+        return EXIT_FAILURE;
+    }
+    if (cfg.lj_table > 0 && species.n_types > 1) {
+        printf("--lj-table needs a single species\n");
+        return EXIT_FAILURE;
+    }
+
+    // Ensemble mode: many replicas of the input system instead of one simulation
+    if (cfg.ensemble > 0 && n_ranks == 1) {
+        if (periodic || cfg.respa_steps > 1 || cfg.lj_table > 0 || cfg.reorder > 0 || cfg.n_species > 0 ||
+            cfg.n_species_pairs > 0 || checkpointing || scaling > 0) {
+            printf("Ensemble mode does not support --box, --respa, --lj-table, --reorder, --species, checkpoints or "
+                   "--scaling\n");
+            return EXIT_FAILURE;
+        }
+#ifdef _OPENMP
+        if (cfg.n_threads > 0) {
+            omp_set_num_threads(cfg.n_threads);
+        }
+#endif
+        int ok = run_ensemble(&cfg, atoms, atom_count);
+        free(atoms);
+        return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    // Move the atoms into the simulation state
+    int max_threads = 1;
+#ifdef _OPENMP
+    if (cfg.n_threads > 0) {
+        omp_set_num_threads(cfg.n_threads);
+    }
+    max_threads = omp_get_max_threads();
+#endif
+    if (scaling > max_threads) {
+        max_threads = scaling;
+    }
+#ifdef USE_MPI
+    // MPI build: a periodic box is split into one domain per rank
+    if (periodic || n_ranks > 1) {
+        int ok = run_domains(&cfg, atoms, atom_count, &species, type, max_threads,
+                             restart || checkpointing || scaling > 0 || cfg.reorder > 0);
+        free(atoms);
+        free(type);
+        return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+#endif
+    // A mixture is stored sorted by type, so the partners of a type are contiguous; outputs use input order
+    size_t* atom_id = type != NULL ? sort_atoms_by_type(atoms, type, atom_count, species.n_types) : NULL;
+    Simulation sim;
+    init_simulation(&sim, atoms, atom_count, &species, type, cfg.cutoff, cfg.skin, max_threads, periodic ? box : NULL);
+    sim.atom_id = atom_id;
+    free(atoms);
+    free(type);
+    report_species(&sim.species);
+    if (!select_lj_kernel(&sim, cfg.simd)) {
+        printf("LJ kernel '%s' is not available on this CPU\n", cfg.simd);
+        return EXIT_FAILURE;
+    }
+    if (sim.nlist != NULL) {
+        printf("LJ kernel: %s\n", sim.lj_kernel_name);
+    }
+    if (cfg.lj_table > 0) {
+        init_lj_table(&sim, (size_t)cfg.lj_table, 1);
+    }
+    if (cfg.reorder > 0) {
+        sim.reorder_interval = cfg.reorder;
+        if (sim.atom_id == NULL) {
+            // The output writer scatters frames through atom_id, so it must exist before the first reordering
+            sim.atom_id = malloc(atom_count * sizeof(size_t));
+            if (sim.atom_id == NULL) {
+                printf("Memory allocation failed\n");
+                return EXIT_FAILURE;
+            }
+            for (size_t i = 0; i < atom_count; i++) {
+                sim.atom_id[i] = i;
+            }
+        }
+        printf("Atoms are stored in Morton order, renewed every %d neighbor-list rebuilds\n", cfg.reorder);
+    }
+    if (cfg.respa_steps > 1) {
+        init_respa(&sim, cfg.respa_steps, cfg.inner_cutoff, cfg.switch_width);
+        printf("r-RESPA: %d inner steps of %g per step, inner forces up to %g nm, switched over the last %g nm\n",
+               cfg.respa_steps, cfg.timestep / cfg.respa_steps, cfg.inner_cutoff, cfg.switch_width);
+    }
+    if (periodic) {
+        printf("Periodic box %.4f x %.4f x %.4f nm, tail corrections: E = %.6f, P = %.6f\n",
+               box[0], box[1], box[2], sim.energy_tail, sim.pressure_tail);
+    }
+
+    // Scaling report only: no dynamics, no output files
+    if (scaling > 0) {
+        scaling_report(&sim, scaling);
+        free_simulation(&sim);
+        return EXIT_SUCCESS;
+    }
+
+    double LJ_potential;
+    double kinetic_energy;
+    int first_step = 0;
+    BinaryTrajectory binary;
+    FILE* output = NULL;
+    FILE* energy_output = NULL;
+    const char* trajectory_path = cfg.binary_output ? binary_trajectory_file : trajectory_file;
+    if (restart) {
+        // Continue from the checkpoint: cut the output files back to what it covers and append
+        uint64_t offsets[2];
+        first_step = read_checkpoint(&cfg, &sim, &LJ_potential, offsets, &binary);
+        if (first_step < 0) {
+            return EXIT_FAILURE;
+        }
+        // A file shorter than the checkpoint expects was replaced or cleared since; truncate would
+        // pad it with zero bytes, so the restart is refused instead
+        const char* outputs[2] = { energy_file, trajectory_path };
+        for (int k = 0; k < 2; k++) {
+            struct stat st;
+            if (stat(outputs[k], &st) != 0 || (uint64_t)st.st_size < offsets[k]) {
+                printf("Cannot restart: '%s' is missing or shorter than checkpoint '%s' expects\n", outputs[k],
+                       cfg.checkpoint_file);
+                return EXIT_FAILURE;
+            }
+        }
+        if (truncate(energy_file, (off_t)offsets[0]) != 0 || truncate(trajectory_path, (off_t)offsets[1]) != 0) {
+            perror("Error truncating output files for the restart");
+            return EXIT_FAILURE;
+        }
+        kinetic_energy = compute_kinetic_energy(&sim);
+        printf("Restarted from checkpoint '%s' at step %d\n\n", cfg.checkpoint_file, first_step);
+
+        if (cfg.binary_output) {
+            open_binary_trajectory(&binary, binary_trajectory_file, &sim, cfg.precision, 1);
+        } else {
+            output = fopen(trajectory_file, "a");
+        }
+        energy_output = fopen(energy_file, "a");
+    } else {
+        // Compute initial accelerations and energies
+        LJ_potential = sim.respa_steps > 1 ? compute_respa_forces(&sim) : compute_forces(&sim, sim.ax, sim.ay, sim.az);
+        kinetic_energy = compute_kinetic_energy(&sim);
+        double total_energy = LJ_potential + kinetic_energy;
+
+        // Print initial coordinates and energies
+        printf("Initial Coordinates and Energies:\n");
+        printf("Coordinates:\n");
+        size_t shown[20], n_shown = atom_count < 20 ? atom_count : 20; // The first atoms of the input
+        for (size_t i = 0; i < atom_count; i++) {
+            size_t id = sim.atom_id != NULL ? sim.atom_id[i] : i;
+            if (id < n_shown) shown[id] = i;
+        }
+        for (size_t k = 0; k < n_shown; k++) {
+            size_t i = shown[k];
+            printf("%s: (%.6f, %.6f, %.6f)\n", sim.symbol[i], sim.x[i], sim.y[i], sim.z[i]);
+        }
+        if (atom_count > 20) {
+            printf("... (%zu more atoms)\n", atom_count - 20);
+        }
+        printf("Lennard-Jones Potential: %.6f\n", LJ_potential);
+        printf("Kinetic Energy: %.6f\n", kinetic_energy);
+        printf("Total Energy: %.6f\n\n", total_energy);
+
+        // Open output files
+        if (cfg.binary_output) {
+            open_binary_trajectory(&binary, binary_trajectory_file, &sim, cfg.precision, 0);
+        } else {
+            output = fopen(trajectory_file, "w");
+        }
+        energy_output = fopen(energy_file, "w");
+    }
+    if ((!cfg.binary_output && output == NULL) || energy_output == NULL) {
+        perror("Error opening output files");
+        return EXIT_FAILURE;
+    }
+
+    // Write CSV header for energies
+    if (!restart) {
+        fprintf(energy_output, periodic ? "Step,LJ_Potential,Kinetic_Energy,Total_Energy,Pressure\n"
+                                        : "Step,LJ_Potential,Kinetic_Energy,Total_Energy\n");
+    }
+
+    // Frames and energies go through the output writer (a background thread unless --output-buffers 0)
+    OutputWriter writer;
+    open_output_writer(&writer, &sim, output, cfg.binary_output ? &binary : NULL, energy_output,
+                       cfg.output_interval, cfg.output_buffers);
+
+    // With checkpoints, SIGINT/SIGTERM (e.g. preemption) checkpoint the current step and stop the run
+    if (checkpointing) {
+        signal(SIGINT, request_stop);
+        signal(SIGTERM, request_stop);
+    }
+
+    // Simulation loop
+    EnergyMonitor energy_monitor = { 0 };
+    double loop_start = wall_time();
+    int step;
+    for (step = first_step; step < cfg.total_steps; step++) {
+        if (checkpointing && step > first_step && (step % cfg.checkpoint_interval == 0 || stop_requested)) {
+            write_checkpoint(&cfg, &sim, step, LJ_potential, &writer);
+            if (stop_requested) {
+                printf("Stopped at step %d; continue with --restart\n", step);
+                break;
+            }
+        }
+
+        double pressure = periodic ? compute_pressure(&sim, kinetic_energy) : 0.0;
+        record_output(&writer, step, LJ_potential, kinetic_energy, pressure);
+        monitor_energy(&energy_monitor, step * cfg.timestep, LJ_potential + kinetic_energy);
+        LJ_potential = integrate_step(&sim, cfg.timestep);
+
+        // Recompute kinetic energy after update
+        kinetic_energy = compute_kinetic_energy(&sim);
+    }
+
+    // A final checkpoint lets a finished run be extended with a larger step count
+    if (checkpointing && !stop_requested && step > first_step) {
+        write_checkpoint(&cfg, &sim, step, LJ_potential, &writer);
+    }
+
+    double loop_wall_time = wall_time() - loop_start;
+
+    // Everything recorded is on disk once the writer is closed
+    close_output_writer(&writer);
+    if (cfg.output_buffers > 0 && writer.wait_time > 0.0) {
+        printf("Integrator waited %.3f s for the output writer\n", writer.wait_time);
+    }
+    if (cfg.binary_output) {
+        close_binary_trajectory(&binary);
+    } else {
+        fclose(output);
+    }
+    fclose(energy_output);
+
+    if (sim.nlist != NULL) {
+        printf("Neighbor list rebuilds: %zu\n", sim.nlist->rebuilds);
+    }
+    report_energy_conservation(&energy_monitor, sim.Natoms, (step - first_step) * cfg.timestep, loop_wall_time);
+
+    // Free memory
+    free_simulation(&sim);
+
+    return EXIT_SUCCESS;
+}
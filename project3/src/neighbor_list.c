@@ -0,0 +1,336 @@
+// File: src/neighbor_list.c
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef USE_MPI
+#include <mpi.h>
+#endif
+#include "neighbor_list.h"
+#include "simulation.h"
+#include "util.h"
+
+// Function to allocate a neighbor list for Natoms atoms
+void init_neighbor_list(NeighborList* nl, size_t Natoms, double cutoff, double skin) {
+    nl->cutoff = cutoff;
+    nl->skin = skin;
+    nl->capacity = 64 * Natoms;
+    nl->cell_capacity = 0;
+    nl->rebuilds = 0;
+    nl->inner_cutoff = 0.0;
+    nl->inner_start = NULL;
+    nl->inner_neighbors = NULL;
+    nl->inner_capacity = 0;
+    nl->start = malloc((Natoms + 1) * sizeof(size_t));
+    nl->neighbors = malloc(nl->capacity * sizeof(int));
+    nl->ref_x = malloc_aligned(Natoms);
+    nl->ref_y = malloc_aligned(Natoms);
+    nl->ref_z = malloc_aligned(Natoms);
+    nl->cell_start = NULL;
+    nl->cell_atoms = malloc(Natoms * sizeof(int));
+    nl->cell_x = malloc_aligned(Natoms);
+    nl->cell_y = malloc_aligned(Natoms);
+    nl->cell_z = malloc_aligned(Natoms);
+    nl->atom_cell = malloc(Natoms * sizeof(int));
+    nl->atom_slot = malloc(Natoms * sizeof(size_t));
+
+    if (nl->start == NULL || nl->neighbors == NULL || nl->ref_x == NULL || nl->ref_y == NULL ||
+        nl->ref_z == NULL || nl->cell_atoms == NULL || nl->cell_x == NULL || nl->cell_y == NULL ||
+        nl->cell_z == NULL || nl->atom_cell == NULL || nl->atom_slot == NULL) {
+        printf("Memory allocation failed for the neighbor list\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+// Function to free a neighbor list
+void free_neighbor_list(NeighborList* nl) {
+    free(nl->start);
+    free(nl->neighbors);
+    free(nl->ref_x);
+    free(nl->ref_y);
+    free(nl->ref_z);
+    free(nl->cell_start);
+    free(nl->cell_atoms);
+    free(nl->cell_x);
+    free(nl->cell_y);
+    free(nl->cell_z);
+    free(nl->atom_cell);
+    free(nl->atom_slot);
+    free(nl->inner_start);
+    free(nl->inner_neighbors);
+}
+
+// Function to scan cell_atoms[first, last) for partners of the atom at (xi, yi, zi) within sqrt(r_list2).
+// Counts them if out is NULL (branch-free, so it vectorizes), else writes them to out.
+// periodic is a constant at every call site, so the open-box loops carry no minimum-image work.
+static inline size_t scan_cell(const NeighborList* nl, size_t first, size_t last, double xi, double yi, double zi,
+                               const double box[3], int periodic, double r_list2, int* out) {
+    size_t count = 0;
+    if (out == NULL) {
+        for (size_t k = first; k < last; k++) {
+            double dx = xi - nl->cell_x[k];
+            double dy = yi - nl->cell_y[k];
+            double dz = zi - nl->cell_z[k];
+            if (periodic) {
+                dx = minimum_image(dx, box[0]);
+                dy = minimum_image(dy, box[1]);
+                dz = minimum_image(dz, box[2]);
+            }
+            count += dx * dx + dy * dy + dz * dz < r_list2;
+        }
+    } else {
+        for (size_t k = first; k < last; k++) {
+            double dx = xi - nl->cell_x[k];
+            double dy = yi - nl->cell_y[k];
+            double dz = zi - nl->cell_z[k];
+            if (periodic) {
+                dx = minimum_image(dx, box[0]);
+                dy = minimum_image(dy, box[1]);
+                dz = minimum_image(dz, box[2]);
+            }
+            if (dx * dx + dy * dy + dz * dz < r_list2) {
+                out[count++] = nl->cell_atoms[k];
+            }
+        }
+    }
+    return count;
+}
+
+// Function to find the partners of atom i within sqrt(r_list2): the atoms after it in its own cell
+// and every atom of the 13 "forward" neighbor cells, so each pair is found exactly once.
+// Periodic directions wrap around; one that is too short for 3 cells has a single cell.
+// Writes them to out (if not NULL) and returns how many there are.
+size_t collect_neighbors(const NeighborList* nl, const int n_cell[3], const double box[3], size_t i, const double* x, const double* y, const double* z, double r_list2, int* out) {
+    int ix = nl->atom_cell[i] / (n_cell[1] * n_cell[2]);
+    int iy = nl->atom_cell[i] / n_cell[2] % n_cell[1];
+    int iz = nl->atom_cell[i] % n_cell[2];
+    int periodic = box[0] > 0.0 || box[1] > 0.0 || box[2] > 0.0;
+    size_t count = 0;
+
+    for (int dx_cell = 0; dx_cell <= 1; dx_cell++) {
+        for (int dy_cell = dx_cell == 0 ? 0 : -1; dy_cell <= 1; dy_cell++) {
+            for (int dz_cell = dx_cell == 0 && dy_cell == 0 ? 0 : -1; dz_cell <= 1; dz_cell++) {
+                int offset[3] = { dx_cell, dy_cell, dz_cell };
+                int cell[3] = { ix + dx_cell, iy + dy_cell, iz + dz_cell };
+                int outside = 0;
+                for (int dim = 0; dim < 3; dim++) {
+                    if (box[dim] > 0.0 && n_cell[dim] >= 3) {
+                        cell[dim] = (cell[dim] + n_cell[dim]) % n_cell[dim];
+                    } else if (box[dim] > 0.0) {
+                        outside |= offset[dim] != 0;
+                    } else {
+                        outside |= cell[dim] < 0 || cell[dim] >= n_cell[dim];
+                    }
+                }
+                if (outside) continue;
+                // In its own cell atom i only pairs with the atoms stored after it
+                int cx = cell[0], cy = cell[1], cz = cell[2];
+                size_t c = ((size_t)cx * n_cell[1] + cy) * n_cell[2] + cz;
+                size_t first = dx_cell == 0 && dy_cell == 0 && dz_cell == 0 ? nl->atom_slot[i] + 1 : nl->cell_start[c];
+                size_t last = nl->cell_start[c + 1];
+                int* cell_out = out != NULL ? out + count : NULL;
+                if (periodic) {
+                    count += scan_cell(nl, first, last, x[i], y[i], z[i], box, 1, r_list2, cell_out);
+                } else {
+                    count += scan_cell(nl, first, last, x[i], y[i], z[i], box, 0, r_list2, cell_out);
+                }
+            }
+        }
+    }
+    return count;
+}
+
+// Function to copy the partners of atom i within sqrt(r_inner2) from its full-list row to out
+// (if not NULL) and return how many there are
+static size_t filter_row(const NeighborList* nl, size_t i, const double* x, const double* y, const double* z,
+                         const double box[3], double r_inner2, int* out) {
+    size_t count = 0;
+    for (size_t k = nl->start[i]; k < nl->start[i + 1]; k++) {
+        int j = nl->neighbors[k];
+        double dx = minimum_image(x[i] - x[j], box[0]);
+        double dy = minimum_image(y[i] - y[j], box[1]);
+        double dz = minimum_image(z[i] - z[j], box[2]);
+        if (dx * dx + dy * dy + dz * dz < r_inner2) {
+            if (out != NULL) out[count] = j;
+            count++;
+        }
+    }
+    return count;
+}
+
+// Function to build the r-RESPA inner list from the full one: the pairs within inner_cutoff + skin.
+// It has the same skin, so it stays valid exactly as long as the full list.
+void build_inner_list(NeighborList* nl, size_t Natoms, const double* x, const double* y, const double* z, const double box[3]) {
+    double r_inner = nl->inner_cutoff + nl->skin;
+    double r_inner2 = r_inner * r_inner;
+
+    #pragma omp parallel for schedule(dynamic, 256)
+    for (size_t i = 0; i < Natoms; i++) {
+        nl->inner_start[i + 1] = filter_row(nl, i, x, y, z, box, r_inner2, NULL);
+    }
+    nl->inner_start[0] = 0;
+    for (size_t i = 0; i < Natoms; i++) {
+        nl->inner_start[i + 1] += nl->inner_start[i];
+    }
+    if (nl->inner_start[Natoms] > nl->inner_capacity) {
+        nl->inner_capacity = nl->inner_start[Natoms] + nl->inner_start[Natoms] / 4;
+        free(nl->inner_neighbors);
+        nl->inner_neighbors = malloc(nl->inner_capacity * sizeof(int));
+        if (nl->inner_neighbors == NULL) {
+            printf("Memory allocation failed for the inner neighbor list\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    #pragma omp parallel for schedule(dynamic, 256)
+    for (size_t i = 0; i < Natoms; i++) {
+        filter_row(nl, i, x, y, z, box, r_inner2, nl->inner_neighbors + nl->inner_start[i]);
+    }
+}
+
+// Function to rebuild the neighbor list with a cell search, O(N).
+// Along periodic directions (box[dim] > 0) the positions must lie in [0, L).
+void build_neighbor_list(NeighborList* nl, size_t Natoms, const double* x, const double* y, const double* z, const double box[3]) {
+    double r_list = nl->cutoff + nl->skin;
+    double r_list2 = r_list * r_list;
+    const double* coord[3] = { x, y, z };
+
+    // Bounding box of the system; the box itself along periodic directions.
+    // A diverged run has inf/NaN positions, which cannot be binned, so it is stopped here.
+    double lo[3], hi[3];
+    for (int dim = 0; dim < 3; dim++) {
+        lo[dim] = hi[dim] = Natoms > 0 ? coord[dim][0] : 0.0;
+        for (size_t i = 0; i < Natoms; i++) {
+            if (!isfinite(coord[dim][i])) {
+                printf("Error: the simulation diverged (non-finite position of atom %zu); try a smaller timestep\n", i);
+#ifdef USE_MPI
+                // The other ranks are waiting in a collective, so the whole job is stopped
+                fflush(stdout);
+                MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+#endif
+                exit(EXIT_FAILURE);
+            }
+            if (coord[dim][i] < lo[dim]) lo[dim] = coord[dim][i];
+            if (coord[dim][i] > hi[dim]) hi[dim] = coord[dim][i];
+        }
+        if (box[dim] > 0.0) {
+            lo[dim] = 0.0;
+            hi[dim] = box[dim];
+        }
+    }
+
+    // Cells at least r_list wide, so every partner lies in one of the 27 surrounding cells.
+    // Sparse systems are capped at about 2 cells per atom by widening the cells.
+    int n_cell[3];
+    double cell_size[3];
+    double n_total = 1.0;
+    double max_cells = 2.0 * (double)Natoms + 1.0;
+    for (int dim = 0; dim < 3; dim++) {
+        // Capped before the conversion, so an atom flying far away cannot overflow the int
+        double n = (hi[dim] - lo[dim]) / r_list;
+        n_cell[dim] = n < max_cells ? (int)n : (int)max_cells;
+        if (n_cell[dim] < 1) n_cell[dim] = 1;
+        n_total *= n_cell[dim];
+    }
+    if (n_total > max_cells && box[0] <= 0.0 && box[1] <= 0.0 && box[2] <= 0.0) {
+        double shrink = cbrt(n_total / max_cells);
+        for (int dim = 0; dim < 3; dim++) {
+            n_cell[dim] = (int)(n_cell[dim] / shrink);
+            if (n_cell[dim] < 1) n_cell[dim] = 1;
+        }
+    }
+    for (int dim = 0; dim < 3; dim++) {
+        // A periodic direction is tiled exactly; fewer than 3 cells would make the stencil see a cell twice
+        if (box[dim] > 0.0 && n_cell[dim] < 3) n_cell[dim] = 1;
+        cell_size[dim] = (hi[dim] - lo[dim]) / n_cell[dim];
+        if (cell_size[dim] < r_list && box[dim] <= 0.0) cell_size[dim] = r_list;
+    }
+
+    size_t n_cells = (size_t)n_cell[0] * n_cell[1] * n_cell[2];
+    if (n_cells > nl->cell_capacity) {
+        free(nl->cell_start);
+        nl->cell_start = malloc((n_cells + 1) * sizeof(size_t));
+        if (nl->cell_start == NULL) {
+            printf("Memory allocation failed for the cell list\n");
+            exit(EXIT_FAILURE);
+        }
+        nl->cell_capacity = n_cells;
+    }
+    memset(nl->cell_start, 0, (n_cells + 1) * sizeof(size_t));
+
+    // Counting sort of the atoms into cells; a stable sort keeps each cell in increasing atom order
+    for (size_t i = 0; i < Natoms; i++) {
+        int c[3];
+        for (int dim = 0; dim < 3; dim++) {
+            // Clamped on both sides, so every atom lands in a valid cell
+            double t = (coord[dim][i] - lo[dim]) / cell_size[dim];
+            c[dim] = t <= 0.0 ? 0 : t >= n_cell[dim] ? n_cell[dim] - 1 : (int)t;
+        }
+        nl->atom_cell[i] = (c[0] * n_cell[1] + c[1]) * n_cell[2] + c[2];
+        nl->cell_start[nl->atom_cell[i] + 1]++;
+    }
+    for (size_t c = 0; c < n_cells; c++) {
+        nl->cell_start[c + 1] += nl->cell_start[c];
+    }
+    for (size_t i = 0; i < Natoms; i++) {
+        size_t k = nl->cell_start[nl->atom_cell[i]]++;
+        nl->atom_slot[i] = k;
+        nl->cell_atoms[k] = (int)i;
+        nl->cell_x[k] = x[i];
+        nl->cell_y[k] = y[i];
+        nl->cell_z[k] = z[i];
+    }
+    for (size_t c = n_cells; c > 0; c--) {
+        nl->cell_start[c] = nl->cell_start[c - 1];
+    }
+    nl->cell_start[0] = 0;
+
+    // Count the partners of every atom, then fill the list; both passes run in parallel
+    #pragma omp parallel for schedule(dynamic, 256)
+    for (size_t i = 0; i < Natoms; i++) {
+        nl->start[i + 1] = collect_neighbors(nl, n_cell, box, i, x, y, z, r_list2, NULL);
+    }
+    nl->start[0] = 0;
+    for (size_t i = 0; i < Natoms; i++) {
+        nl->start[i + 1] += nl->start[i];
+    }
+    if (nl->start[Natoms] > nl->capacity) {
+        nl->capacity = nl->start[Natoms] + nl->start[Natoms] / 4;
+        free(nl->neighbors);
+        nl->neighbors = malloc(nl->capacity * sizeof(int));
+        if (nl->neighbors == NULL) {
+            printf("Memory allocation failed for the neighbor list\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    #pragma omp parallel for schedule(dynamic, 256)
+    for (size_t i = 0; i < Natoms; i++) {
+        collect_neighbors(nl, n_cell, box, i, x, y, z, r_list2, nl->neighbors + nl->start[i]);
+    }
+
+    memcpy(nl->ref_x, x, Natoms * sizeof(double));
+    memcpy(nl->ref_y, y, Natoms * sizeof(double));
+    memcpy(nl->ref_z, z, Natoms * sizeof(double));
+    nl->rebuilds++;
+
+    if (nl->inner_cutoff > 0.0) {
+        build_inner_list(nl, Natoms, x, y, z, box);
+    }
+}
+
+// Function to check whether an atom moved more than half the skin since the last rebuild
+int neighbor_list_expired(const NeighborList* nl, size_t Natoms, const double* restrict x, const double* restrict y, const double* restrict z) {
+    double limit2 = 0.25 * nl->skin * nl->skin;
+    double max_d2 = 0.0;
+    #pragma omp parallel for schedule(static) reduction(max:max_d2)
+    for (size_t i = 0; i < Natoms; i++) {
+        double dx = x[i] - nl->ref_x[i];
+        double dy = y[i] - nl->ref_y[i];
+        double dz = z[i] - nl->ref_z[i];
+        double d2 = dx * dx + dy * dy + dz * dz;
+        // A NaN position forces a rebuild, where the diverged run is reported
+        if (isnan(d2)) d2 = INFINITY;
+        max_d2 = d2 > max_d2 ? d2 : max_d2;
+    }
+    return max_d2 > limit2;
+}
@@ -0,0 +1,53 @@
+// File: src/neighbor_list.h
+
+#ifndef NEIGHBOR_LIST_H
+#define NEIGHBOR_LIST_H
+
+#include <stddef.h>
+
+// Verlet neighbor list built from a cell list, used when a cutoff is set
+typedef struct {
+    double cutoff;      // Interaction cutoff (in nm)
+    double skin;        // Extra shell kept in the list so it survives several steps (in nm)
+    size_t* start;      // Natoms + 1 offsets into neighbors
+    int* neighbors;     // Partners of every atom within cutoff + skin, each pair stored once
+    size_t capacity;    // Allocated length of neighbors
+    double* ref_x;      // Positions at the last rebuild
+    double* ref_y;
+    double* ref_z;
+    size_t* cell_start; // n_cells + 1 offsets into cell_atoms
+    int* cell_atoms;    // Atoms sorted by cell, increasing index inside a cell
+    double* cell_x;     // Positions in cell_atoms order, so a cell is scanned contiguously
+    double* cell_y;
+    double* cell_z;
+    int* atom_cell;     // Cell of every atom
+    size_t* atom_slot;  // Position of every atom in cell_atoms
+    size_t cell_capacity;
+    size_t rebuilds;    // Number of rebuilds so far
+    double inner_cutoff;     // r-RESPA only (else 0): the inner list keeps the pairs within inner_cutoff + skin
+    size_t* inner_start;
+    int* inner_neighbors;
+    size_t inner_capacity;
+} NeighborList;
+
+// Function to allocate a neighbor list for Natoms atoms
+void init_neighbor_list(NeighborList* nl, size_t Natoms, double cutoff, double skin);
+
+// Function to free a neighbor list
+void free_neighbor_list(NeighborList* nl);
+
+// Function to find the partners of atom i within sqrt(r_list2) in its own and the 13 forward cells;
+// writes them to out (if not NULL) and returns how many there are
+size_t collect_neighbors(const NeighborList* nl, const int n_cell[3], const double box[3], size_t i, const double* x, const double* y, const double* z, double r_list2, int* out);
+
+// Function to build the r-RESPA inner list from the full one
+void build_inner_list(NeighborList* nl, size_t Natoms, const double* x, const double* y, const double* z, const double box[3]);
+
+// Function to rebuild the neighbor list with a cell search, O(N); periodic directions (box[dim] > 0)
+// need positions in [0, L)
+void build_neighbor_list(NeighborList* nl, size_t Natoms, const double* x, const double* y, const double* z, const double box[3]);
+
+// Function to check whether an atom moved more than half the skin since the last rebuild
+int neighbor_list_expired(const NeighborList* nl, size_t Natoms, const double* restrict x, const double* restrict y, const double* restrict z);
+
+#endif // NEIGHBOR_LIST_H
@@ -0,0 +1,234 @@
+// File: src/output_writer.c
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "output_writer.h"
+#include "util.h"
+
+// Function to write one trajectory frame in the selected format
+static void write_frame(OutputWriter* w, const Simulation* frame, double LJ_potential, double kinetic_energy) {
+    if (w->binary != NULL) {
+        write_binary_frame(w->binary, frame, LJ_potential, kinetic_energy);
+    } else {
+        write_xyz(w->trajectory, frame, LJ_potential, kinetic_energy);
+    }
+}
+
+// Function to write a queued block: its frame, then its energy lines
+static void write_block(OutputWriter* w, const OutputBlock* block) {
+    // The writers only read Natoms, symbol and coordinates, so a copy pointing at the block will do
+    Simulation frame = w->frame;
+    frame.x = block->x;
+    frame.y = block->y;
+    frame.z = block->z;
+    if (block->has_frame) {
+        write_frame(w, &frame, block->LJ[0], block->KE[0]);
+    }
+    for (int k = 0; k < block->n_steps; k++) {
+        write_energies(w->energies, block->step + k, block->LJ[k], block->KE[k], w->with_pressure ? &block->P[k] : NULL);
+    }
+}
+
+// Writer thread: drain queued blocks in order until the integrator is done and the queue is empty
+static void* output_thread(void* arg) {
+    OutputWriter* w = arg;
+    pthread_mutex_lock(&w->lock);
+    for (;;) {
+        while (w->count == 0 && !w->done) {
+            pthread_cond_wait(&w->queued, &w->lock);
+        }
+        if (w->count == 0) {
+            break;
+        }
+        OutputBlock* block = &w->blocks[w->head];
+        pthread_mutex_unlock(&w->lock);
+
+        write_block(w, block); // The integrator does not touch queued blocks
+
+        pthread_mutex_lock(&w->lock);
+        w->head = (w->head + 1) % w->n_blocks;
+        w->count--;
+        pthread_cond_signal(&w->freed);
+    }
+    pthread_mutex_unlock(&w->lock);
+    return NULL;
+}
+
+// Function to copy the coordinates of sim to x, y, z in input order
+static void copy_frame_coordinates(const Simulation* sim, double* x, double* y, double* z) {
+    if (sim->atom_id == NULL) {
+        size_t bytes = sim->Natoms * sizeof(double);
+        memcpy(x, sim->x, bytes);
+        memcpy(y, sim->y, bytes);
+        memcpy(z, sim->z, bytes);
+        return;
+    }
+    for (size_t i = 0; i < sim->Natoms; i++) {
+        size_t id = sim->atom_id[i];
+        x[id] = sim->x[i];
+        y[id] = sim->y[i];
+        z[id] = sim->z[i];
+    }
+}
+
+// Function to set up the output writer; starts the writer thread when n_blocks > 0
+void open_output_writer(OutputWriter* w, const Simulation* sim, FILE* trajectory, BinaryTrajectory* binary,
+                        FILE* energies, int interval, int n_blocks) {
+    w->sim = sim;
+    w->frame = *sim;
+    if (sim->atom_id != NULL) {
+        w->frame.symbol = malloc(sim->Natoms * sizeof(*sim->symbol));
+        w->frame.x = malloc_aligned(sim->Natoms);
+        w->frame.y = malloc_aligned(sim->Natoms);
+        w->frame.z = malloc_aligned(sim->Natoms);
+        if (w->frame.symbol == NULL || w->frame.x == NULL || w->frame.y == NULL || w->frame.z == NULL) {
+            printf("Memory allocation failed for the output frame\n");
+            exit(EXIT_FAILURE);
+        }
+        for (size_t i = 0; i < sim->Natoms; i++) {
+            memcpy(w->frame.symbol[sim->atom_id[i]], sim->symbol[i], sizeof(*sim->symbol));
+        }
+    }
+    w->trajectory = trajectory;
+    w->binary = binary;
+    w->energies = energies;
+    w->with_pressure = sim->box[0] > 0.0;
+    w->interval = interval;
+    w->n_blocks = n_blocks;
+    w->blocks = NULL;
+    w->head = 0;
+    w->count = 0;
+    w->filling = NULL;
+    w->done = 0;
+    w->wait_time = 0.0;
+    if (n_blocks == 0) {
+        return;
+    }
+
+    w->blocks = malloc(n_blocks * sizeof(OutputBlock));
+    if (w->blocks == NULL) {
+        printf("Memory allocation failed for the output buffers\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int b = 0; b < n_blocks; b++) {
+        w->blocks[b].x = malloc_aligned(sim->Natoms);
+        w->blocks[b].y = malloc_aligned(sim->Natoms);
+        w->blocks[b].z = malloc_aligned(sim->Natoms);
+        w->blocks[b].LJ = malloc_aligned(3 * (size_t)interval);
+        if (w->blocks[b].x == NULL || w->blocks[b].y == NULL || w->blocks[b].z == NULL || w->blocks[b].LJ == NULL) {
+            printf("Memory allocation failed for %d output buffers\n", n_blocks);
+            exit(EXIT_FAILURE);
+        }
+        w->blocks[b].KE = w->blocks[b].LJ + interval;
+        w->blocks[b].P = w->blocks[b].KE + interval;
+    }
+    pthread_mutex_init(&w->lock, NULL);
+    pthread_cond_init(&w->queued, NULL);
+    pthread_cond_init(&w->freed, NULL);
+    if (pthread_create(&w->thread, NULL, output_thread, w) != 0) {
+        printf("Could not start the output writer thread\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+// Function to hand the block being recorded to the writer thread
+static void queue_block(OutputWriter* w) {
+    if (w->filling == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&w->lock);
+    w->count++;
+    w->filling = NULL;
+    pthread_cond_signal(&w->queued);
+    pthread_mutex_unlock(&w->lock);
+}
+
+// Function to record the output of one step: the frame every output_interval steps and the energies
+// (and the pressure, which is only written for a periodic box)
+void record_output(OutputWriter* w, int step, double LJ_potential, double kinetic_energy, double pressure) {
+    int frame_step = step % w->interval == 0;
+    if (w->n_blocks == 0) {
+        if (frame_step && w->sim->atom_id != NULL) {
+            copy_frame_coordinates(w->sim, w->frame.x, w->frame.y, w->frame.z);
+            write_frame(w, &w->frame, LJ_potential, kinetic_energy);
+        } else if (frame_step) {
+            write_frame(w, w->sim, LJ_potential, kinetic_energy);
+        }
+        write_energies(w->energies, step, LJ_potential, kinetic_energy, w->with_pressure ? &pressure : NULL);
+        return;
+    }
+
+    // A new block starts at every frame, and at the first step after a flush
+    if (frame_step || w->filling == NULL) {
+        queue_block(w);
+
+        // Wait for a free buffer only when the writer has fallen n_blocks blocks behind
+        pthread_mutex_lock(&w->lock);
+        if (w->count == w->n_blocks) {
+            double t0 = wall_time();
+            while (w->count == w->n_blocks) {
+                pthread_cond_wait(&w->freed, &w->lock);
+            }
+            w->wait_time += wall_time() - t0;
+        }
+        OutputBlock* block = &w->blocks[(w->head + w->count) % w->n_blocks];
+        pthread_mutex_unlock(&w->lock);
+
+        if (frame_step) {
+            copy_frame_coordinates(w->sim, block->x, block->y, block->z);
+        }
+        block->has_frame = frame_step;
+        block->step = step;
+        block->n_steps = 0;
+        w->filling = block;
+    }
+    w->filling->LJ[w->filling->n_steps] = LJ_potential;
+    w->filling->KE[w->filling->n_steps] = kinetic_energy;
+    w->filling->P[w->filling->n_steps] = pressure;
+    w->filling->n_steps++;
+}
+
+// Function to wait until everything recorded so far is written, and flush the output files
+void flush_output_writer(OutputWriter* w) {
+    if (w->n_blocks > 0) {
+        queue_block(w);
+        pthread_mutex_lock(&w->lock);
+        while (w->count > 0) {
+            pthread_cond_wait(&w->freed, &w->lock);
+        }
+        pthread_mutex_unlock(&w->lock);
+    }
+    fflush(w->binary != NULL ? w->binary->file : w->trajectory);
+    fflush(w->energies);
+}
+
+// Function to queue the last block, wait until the writer thread has written everything and stop it
+void close_output_writer(OutputWriter* w) {
+    if (w->n_blocks > 0) {
+        queue_block(w);
+        pthread_mutex_lock(&w->lock);
+        w->done = 1;
+        pthread_cond_signal(&w->queued);
+        pthread_mutex_unlock(&w->lock);
+        pthread_join(w->thread, NULL);
+
+        pthread_mutex_destroy(&w->lock);
+        pthread_cond_destroy(&w->queued);
+        pthread_cond_destroy(&w->freed);
+        for (int b = 0; b < w->n_blocks; b++) {
+            free(w->blocks[b].x);
+            free(w->blocks[b].y);
+            free(w->blocks[b].z);
+            free(w->blocks[b].LJ);
+        }
+        free(w->blocks);
+    }
+    if (w->sim->atom_id != NULL) {
+        free(w->frame.symbol);
+        free(w->frame.x);
+        free(w->frame.y);
+        free(w->frame.z);
+    }
+}
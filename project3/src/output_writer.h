@@ -0,0 +1,56 @@
+// File: src/output_writer.h
+
+#ifndef OUTPUT_WRITER_H
+#define OUTPUT_WRITER_H
+
+#include <pthread.h>
+#include <stdio.h>
+#include "simulation.h"
+#include "trajectory.h"
+
+// Output of up to output_interval consecutive steps: the frame of the first step and the energies of all
+typedef struct {
+    int step;              // First step of the block
+    int n_steps;           // Energy lines recorded so far
+    int has_frame;         // The first step is an output step (not so for a block opened by a restart)
+    double *x, *y, *z;     // Coordinates at the first step
+    double *LJ, *KE, *P;   // Energies and pressure of every step, output_interval each
+} OutputBlock;
+
+// Output writer. With n_blocks > 0 the integrator copies every block into a ring of preallocated
+// buffers and a background thread formats and writes them, so the dynamics only waits when all
+// n_blocks buffers are still queued (back-pressure). With n_blocks == 0 output is written in place.
+typedef struct {
+    const Simulation* sim;
+    Simulation frame;          // What the frame writers see: sim, but with symbols (and, without the
+                               // writer thread, coordinates) in input order when sim->atom_id is set
+    FILE* trajectory;          // XYZ output, or NULL
+    BinaryTrajectory* binary;  // Binary output, or NULL
+    FILE* energies;
+    int with_pressure;         // Write the pressure column (periodic box)
+    int interval;              // Steps between two trajectory frames
+    int n_blocks;
+    OutputBlock* blocks;
+    int head, count;           // Oldest queued block and number of queued blocks
+    OutputBlock* filling;      // Block the integrator is recording into, not yet queued
+    int done;
+    double wait_time;          // Seconds the integrator spent waiting for a free buffer
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t queued, freed;
+} OutputWriter;
+
+// Function to set up the output writer; starts the writer thread when n_blocks > 0
+void open_output_writer(OutputWriter* w, const Simulation* sim, FILE* trajectory, BinaryTrajectory* binary,
+                        FILE* energies, int interval, int n_blocks);
+
+// Function to record the output of one step: the frame every output_interval steps and the energies
+void record_output(OutputWriter* w, int step, double LJ_potential, double kinetic_energy, double pressure);
+
+// Function to wait until everything recorded so far is written, and flush the output files
+void flush_output_writer(OutputWriter* w);
+
+// Function to queue the last block, wait until the writer thread has written everything and stop it
+void close_output_writer(OutputWriter* w);
+
+#endif // OUTPUT_WRITER_H
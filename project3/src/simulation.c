@@ -0,0 +1,353 @@
+// File: src/simulation.c
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "forces.h"
+#include "simulation.h"
+#include "util.h"
+
+// Function to compute the long-range LJ corrections of all atoms of species in a periodic box beyond the
+// cutoff, integrated with g(r) = 1 (Allen & Tildesley) and summed over the pairs of types a, b,
+//   E_tail = 8/3 pi sum N_a rho_b eps_ab sigma_ab^3 [ (sigma_ab/rc)^9 / 3 - (sigma_ab/rc)^3 ]
+//   P_tail = 16/3 pi sum rho_a rho_b eps_ab sigma_ab^3 [ 2 (sigma_ab/rc)^9 / 3 - (sigma_ab/rc)^3 ]
+void lj_tail_corrections(const LJSpecies* species, const double box[3], double cutoff, double* energy_tail,
+                         double* pressure_tail) {
+    int n = species->n_types;
+    *energy_tail = 0.0;
+    *pressure_tail = 0.0;
+    for (int a = 0; a < n; a++) {
+        for (int b = 0; b < n; b++) {
+            double rho_a = (double)species->count[a] / (box[0] * box[1] * box[2]);
+            double rho_b = (double)species->count[b] / (box[0] * box[1] * box[2]);
+            double sigma = species->sigma[a * n + b], epsilon = species->epsilon[a * n + b];
+            double sr3 = pow(sigma / cutoff, 3);
+            double sr9 = sr3 * sr3 * sr3;
+            double sigma3 = sigma * sigma * sigma;
+            *energy_tail += 8.0 / 3.0 * M_PI * (double)species->count[a] * rho_b * epsilon * sigma3 * (sr9 / 3.0 - sr3);
+            *pressure_tail += 16.0 / 3.0 * M_PI * rho_a * rho_b * epsilon * sigma3 * (2.0 * sr9 / 3.0 - sr3);
+        }
+    }
+}
+
+// Function to set up the simulation state from the loaded atoms; velocities start at zero.
+// species holds the LJ parameters and type the type of every atom (NULL for a single species).
+// Force buffers are sized for up to n_threads OpenMP threads. box holds the periodic box lengths,
+// or NULL for an isolated cluster.
+void init_simulation(Simulation* sim, const Atom* atoms, size_t Natoms, const LJSpecies* species, const int* type,
+                     double cutoff, double skin, int n_threads, const double* box) {
+    sim->Natoms = Natoms;
+    sim->symbol = malloc(Natoms * sizeof(*sim->symbol));
+    sim->species = *species;
+    sim->type = NULL;
+    sim->atom_id = NULL;
+    if (type != NULL) {
+        sim->type = malloc((Natoms > 0 ? Natoms : 1) * sizeof(int));
+        if (sim->type == NULL) {
+            printf("Memory allocation failed\n");
+            exit(EXIT_FAILURE);
+        }
+        memcpy(sim->type, type, Natoms * sizeof(int));
+    }
+    double** arrays[] = { &sim->x, &sim->y, &sim->z, &sim->vx, &sim->vy, &sim->vz,
+                          &sim->ax, &sim->ay, &sim->az, &sim->ax_new, &sim->ay_new, &sim->az_new,
+                          &sim->mass };
+    for (size_t a = 0; a < sizeof(arrays) / sizeof(arrays[0]); a++) {
+        *arrays[a] = malloc_aligned(Natoms);
+        if (*arrays[a] == NULL) {
+            printf("Memory allocation failed\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // Thread 0 accumulates straight into the acceleration arrays, the others into private buffers
+    sim->n_threads = n_threads > 1 ? n_threads : 1;
+    sim->thread_forces = NULL;
+    if (sim->n_threads > 1) {
+        sim->thread_forces = malloc_aligned(3 * Natoms * (size_t)(sim->n_threads - 1));
+        if (sim->thread_forces == NULL) {
+            printf("Memory allocation failed for %d per-thread force buffers\n", sim->n_threads - 1);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // With a cutoff the pairs come from a neighbor list, otherwise every pair interacts
+    sim->lj_row = lj_row_scalar;
+    sim->lj_kernel_name = "scalar";
+    sim->nlist = NULL;
+    if (cutoff > 0.0) {
+        init_neighbor_list(&sim->neighbor_list, Natoms, cutoff, skin);
+        sim->nlist = &sim->neighbor_list;
+    }
+    if (sim->symbol == NULL) {
+        printf("Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+
+    sim->energy_tail = 0.0;
+    sim->pressure_tail = 0.0;
+    sim->virial = 0.0;
+    sim->respa_steps = 1;
+    sim->switch_width = 0.0;
+    sim->ax_slow = sim->ay_slow = sim->az_slow = NULL;
+    sim->lj_table = NULL;
+    sim->reorder_interval = 0;
+    for (int dim = 0; dim < 3; dim++) {
+        sim->box[dim] = box != NULL ? box[dim] : 0.0;
+    }
+    if (box != NULL) {
+        lj_tail_corrections(species, box, cutoff, &sim->energy_tail, &sim->pressure_tail);
+    }
+
+    // Initialize coordinates, velocities, and masses
+    for (size_t i = 0; i < Natoms; i++) {
+        memcpy(sim->symbol[i], atoms[i].atom, sizeof(sim->symbol[i]));
+        sim->x[i] = atoms[i].x;
+        sim->y[i] = atoms[i].y;
+        sim->z[i] = atoms[i].z;
+        sim->vx[i] = 0.0;
+        sim->vy[i] = 0.0;
+        sim->vz[i] = 0.0;
+        sim->mass[i] = atoms[i].mass;
+    }
+}
+
+// Function to free the simulation state
+void free_simulation(Simulation* sim) {
+    free(sim->symbol);
+    double* arrays[] = { sim->x, sim->y, sim->z, sim->vx, sim->vy, sim->vz, sim->ax, sim->ay, sim->az,
+                         sim->ax_new, sim->ay_new, sim->az_new, sim->mass, sim->ax_slow, sim->ay_slow, sim->az_slow };
+    for (size_t a = 0; a < sizeof(arrays) / sizeof(arrays[0]); a++) {
+        free(arrays[a]);
+    }
+    free(sim->thread_forces);
+    if (sim->nlist != NULL) {
+        free_neighbor_list(sim->nlist);
+    }
+    if (sim->lj_table != NULL) {
+        free(sim->lj_table->coeff);
+    }
+    free(sim->type);
+    free(sim->atom_id);
+}
+
+// Function to build the LJ table of the (single) species with n_intervals intervals from LJ_TABLE_START
+// sigma to the cutoff.
+// Each knot holds the exact energy E and force over r F and their slopes in s = r^2,
+//   dE/ds = -F / 2,   dF/ds = 24 eps (4 (sigma^2/s)^3 - 14 (sigma^2/s)^6) / s^2,
+// so both splines are C1 and have an O(h^4) error. One more interval holds the values at the cutoff,
+// for r^2 that round onto the last knot. With report, prints the largest error against lj_pair,
+// sampled at 16 points per interval.
+void init_lj_table(Simulation* sim, size_t n_intervals, int report) {
+    LJTable* table = &sim->lj_table_data;
+    const LJCoefficients* lj = &sim->species.lj[0];
+    double s0 = LJ_TABLE_START * LJ_TABLE_START * lj->sigma2;
+    double h = (sim->nlist->cutoff * sim->nlist->cutoff - s0) / (double)n_intervals;
+    table->r2_min = s0;
+    table->lj = *lj;
+    table->inv_h = 1.0 / h;
+    table->n_intervals = n_intervals;
+    table->coeff = malloc_aligned(8 * (n_intervals + 1));
+    if (table->coeff == NULL) {
+        printf("Memory allocation failed for the LJ table\n");
+        exit(EXIT_FAILURE);
+    }
+
+    double E0 = 0.0, dE0 = 0.0, F0 = 0.0, dF0 = 0.0;
+    for (size_t k = 0; k <= n_intervals; k++) {
+        double s = s0 + (double)k * h;
+        double E, F = lj_pair(s, lj, &E);
+        double q3 = lj->sigma2 * lj->sigma2 * lj->sigma2 / (s * s * s);
+        double dE = -0.5 * F * h; // Slopes per interval
+        double dF = lj->eps24 * (4 * q3 - 14 * q3 * q3) / (s * s) * h;
+        if (k > 0) {
+            double* c = table->coeff + 8 * (k - 1);
+            c[0] = E0;
+            c[1] = dE0;
+            c[2] = 3 * (E - E0) - 2 * dE0 - dE;
+            c[3] = 2 * (E0 - E) + dE0 + dE;
+            c[4] = F0;
+            c[5] = dF0;
+            c[6] = 3 * (F - F0) - 2 * dF0 - dF;
+            c[7] = 2 * (F0 - F) + dF0 + dF;
+        }
+        E0 = E, dE0 = dE, F0 = F, dF0 = dF;
+    }
+    double* last = table->coeff + 8 * n_intervals;
+    memset(last, 0, 8 * sizeof(double));
+    last[0] = E0;
+    last[4] = F0;
+    sim->lj_table = table;
+    if (!report) {
+        return;
+    }
+
+    double energy_error = 0.0, force_error = 0.0;
+    for (size_t k = 0; k < n_intervals; k++) {
+        for (int p = 0; p < 16; p++) {
+            double s = s0 + ((double)k + (p + 0.5) / 16.0) * h;
+            double E, Et;
+            double dF = fabs(lj_pair_table(table, s, &Et) - lj_pair(s, lj, &E)) * sqrt(s);
+            energy_error = fmax(energy_error, fabs(Et - E));
+            force_error = fmax(force_error, dF);
+        }
+    }
+    printf("LJ table: %zu intervals in r^2 from %.4f nm, largest error %.1e eps (energy), %.1e eps/sigma (force)\n",
+           n_intervals, sqrt(s0), energy_error / sim->species.epsilon[0],
+           force_error * sim->species.sigma[0] / sim->species.epsilon[0]);
+}
+
+// Function to wrap the positions back into the periodic box, [0, L) along every periodic direction
+void wrap_positions(Simulation* sim) {
+    double* coord[3] = { sim->x, sim->y, sim->z };
+    for (int dim = 0; dim < 3; dim++) {
+        double L = sim->box[dim];
+        if (L <= 0.0) continue;
+        double* restrict c = coord[dim];
+        #pragma omp parallel for schedule(static)
+        for (size_t i = 0; i < sim->Natoms; i++) {
+            c[i] = wrap_coordinate(c[i], L);
+        }
+    }
+}
+
+// Function to spread the low 21 bits of v so that bit k lands on bit 3k, for a Morton code
+static inline uint64_t spread_bits(uint64_t v) {
+    v &= 0x1fffff;
+    v = (v | v << 32) & 0x1f00000000ffffULL;
+    v = (v | v << 16) & 0x1f0000ff0000ffULL;
+    v = (v | v << 8) & 0x100f00f00f00f00fULL;
+    v = (v | v << 4) & 0x10c30c30c30c30c3ULL;
+    v = (v | v << 2) & 0x1249249249249249ULL;
+    return v;
+}
+
+// Function to gather one per-atom array into the new order, a[k] = a[order[k]], through scratch
+static void permute_doubles(double* restrict a, const size_t* restrict order, size_t Natoms, double* restrict scratch) {
+    #pragma omp parallel for schedule(static)
+    for (size_t k = 0; k < Natoms; k++) {
+        scratch[k] = a[order[k]];
+    }
+    memcpy(a, scratch, Natoms * sizeof(double));
+}
+
+// Function to store the atoms in a new order: atom k becomes the old atom order[k]. Every per-atom
+// array is permuted in place, so pointers held by callers stay valid, and atom_id (allocated on
+// first use) follows, so the outputs keep input order. The neighbor list must be rebuilt afterwards.
+void permute_atoms(Simulation* sim, const size_t* order) {
+    size_t N = sim->Natoms;
+    double* scratch = malloc_aligned(N);
+    char (*symbol)[3] = malloc((N > 0 ? N : 1) * sizeof(*symbol));
+    size_t* atom_id = malloc((N > 0 ? N : 1) * sizeof(size_t));
+    if (scratch == NULL || symbol == NULL || atom_id == NULL) {
+        printf("Memory allocation failed for the atom reordering\n");
+        exit(EXIT_FAILURE);
+    }
+    double* arrays[] = { sim->x, sim->y, sim->z, sim->vx, sim->vy, sim->vz, sim->ax, sim->ay, sim->az,
+                         sim->ax_new, sim->ay_new, sim->az_new, sim->mass, sim->ax_slow, sim->ay_slow, sim->az_slow };
+    for (size_t a = 0; a < sizeof(arrays) / sizeof(arrays[0]); a++) {
+        if (arrays[a] != NULL) {
+            permute_doubles(arrays[a], order, N, scratch);
+        }
+    }
+    for (size_t k = 0; k < N; k++) {
+        memcpy(symbol[k], sim->symbol[order[k]], sizeof(*symbol));
+        atom_id[k] = sim->atom_id != NULL ? sim->atom_id[order[k]] : order[k];
+    }
+    memcpy(sim->symbol, symbol, N * sizeof(*symbol));
+    free(sim->atom_id);
+    sim->atom_id = atom_id;
+    if (sim->type != NULL) {
+        int* type = (int*)scratch; // An int fits in a double slot
+        for (size_t k = 0; k < N; k++) {
+            type[k] = sim->type[order[k]];
+        }
+        memcpy(sim->type, type, N * sizeof(int));
+    }
+    free(scratch);
+    free(symbol);
+}
+
+// Function to store the atoms along a Morton (Z-order) curve through the box, a mixture sorted by type
+// first. Atoms close in space then sit close in memory, so a neighbor-list row touches a few cache lines
+// instead of spreading over all of them, as it does once the atoms have diffused away from the input
+// order. Along periodic directions the positions must lie in [0, L).
+void reorder_atoms(Simulation* sim) {
+    size_t N = sim->Natoms;
+    const double* coord[3] = { sim->x, sim->y, sim->z };
+    const uint64_t max_cell = ((uint64_t)1 << MORTON_BITS) - 1;
+    double lo[3], scale[3];
+    for (int dim = 0; dim < 3; dim++) {
+        double hi = sim->box[dim];
+        lo[dim] = 0.0;
+        if (sim->box[dim] <= 0.0) {
+            lo[dim] = hi = N > 0 ? coord[dim][0] : 0.0;
+            for (size_t i = 1; i < N; i++) {
+                if (coord[dim][i] < lo[dim]) lo[dim] = coord[dim][i];
+                if (coord[dim][i] > hi) hi = coord[dim][i];
+            }
+        }
+        scale[dim] = hi > lo[dim] ? (double)max_cell / (hi - lo[dim]) : 0.0;
+    }
+
+    // Keys and atoms twice: the radix sort moves them back and forth between the halves
+    uint64_t* key = malloc((2 * N + 1) * sizeof(uint64_t));
+    size_t* order = malloc((2 * N + 1) * sizeof(size_t));
+    size_t* count = malloc((65536 + 1) * sizeof(size_t));
+    if (key == NULL || order == NULL || count == NULL) {
+        printf("Memory allocation failed for the atom reordering\n");
+        exit(EXIT_FAILURE);
+    }
+    #pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < N; i++) {
+        uint64_t code = sim->type != NULL ? (uint64_t)sim->type[i] << (3 * MORTON_BITS) : 0;
+        for (int dim = 0; dim < 3; dim++) {
+            double q = (coord[dim][i] - lo[dim]) * scale[dim];
+            uint64_t cell = q > 0.0 ? (uint64_t)q : 0;
+            code |= spread_bits(cell < max_cell ? cell : max_cell) << (2 - dim);
+        }
+        key[i] = code;
+        order[i] = i;
+    }
+
+    // LSD radix sort, 16 bits per pass; it is stable, so atoms with equal keys keep their order
+    uint64_t* key_out = key + N;
+    size_t* order_out = order + N;
+    for (int shift = 0; shift < 64; shift += 16) {
+        memset(count, 0, (65536 + 1) * sizeof(size_t));
+        for (size_t i = 0; i < N; i++) {
+            count[((key[i] >> shift) & 0xffff) + 1]++;
+        }
+        for (size_t d = 0; d < 65536; d++) {
+            count[d + 1] += count[d];
+        }
+        for (size_t i = 0; i < N; i++) {
+            size_t slot = count[(key[i] >> shift) & 0xffff]++;
+            key_out[slot] = key[i];
+            order_out[slot] = order[i];
+        }
+        uint64_t* key_swap = key;
+        key = key_out;
+        key_out = key_swap;
+        size_t* order_swap = order;
+        order = order_out;
+        order_out = order_swap;
+    }
+    // Four passes end in the first halves again
+    permute_atoms(sim, order);
+    free(key);
+    free(order);
+    free(count);
+}
+
+// Function to rebuild the neighbor list: wraps the positions into the box and, every reorder_interval-th
+// rebuild (the first included), reorders the atoms along the space-filling curve
+void rebuild_neighbor_list(Simulation* sim) {
+    wrap_positions(sim);
+    if (sim->reorder_interval > 0 && sim->nlist->rebuilds % (size_t)sim->reorder_interval == 0) {
+        reorder_atoms(sim);
+    }
+    build_neighbor_list(sim->nlist, sim->Natoms, sim->x, sim->y, sim->z, sim->box);
+}
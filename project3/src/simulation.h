@@ -0,0 +1,168 @@
+// File: src/simulation.h
+
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <math.h>
+#include <stddef.h>
+#include "atoms.h"
+#include "neighbor_list.h"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#define HAVE_X86_SIMD 1 // AVX2/AVX-512 kernels are compiled in and picked at run time
+#endif
+#define EPSILON 0.0661 // Lennard-Jones epsilon (in kcal/mol) of every species without parameters of its own
+#define SIGMA 0.3345   // Lennard-Jones sigma (in nm), likewise
+#define MAX_SPECIES 8 // Element symbols with their own LJ parameters in one run
+#define LJ_TABLE_START 0.8 // Tabulated LJ: the table starts at this many sigma, closer pairs use the formula
+#define MORTON_BITS 20 // Reordering: bits per dimension of the space-filling-curve key (the type takes the top bits)
+
+// Which part of the LJ force a neighbor-list evaluation computes. r-RESPA splits F = S(r) F + (1 - S(r)) F
+// with a smooth switch S; the short-range inner part is integrated with a smaller time step.
+enum { FORCE_FULL, FORCE_INNER, FORCE_OUTER };
+
+// LJ coefficients of one pair of species, in the form the kernels use
+typedef struct {
+    double sigma2;      // sigma^2 (in nm^2)
+    double eps4;        // 4 epsilon
+    double eps24;       // 24 epsilon
+    double shift;       // Pair energy at the cutoff, subtracted from every pair inside it (0 without a cutoff)
+} LJCoefficients;
+
+// LJ species of a run: every element symbol is a type. The parameters of each pair of types are mixed
+// once at start-up (Lorentz-Berthelot, or given explicitly), so the kernels only look them up.
+typedef struct {
+    int n_types;
+    char symbol[MAX_SPECIES][3];
+    size_t count[MAX_SPECIES];                  // Atoms of each type in the whole system
+    double epsilon[MAX_SPECIES * MAX_SPECIES];  // Pair parameters by [type_i * n_types + type_j]
+    double sigma[MAX_SPECIES * MAX_SPECIES];    // (in kcal/mol and nm)
+    LJCoefficients lj[MAX_SPECIES * MAX_SPECIES];
+} LJSpecies;
+
+// Tabulated LJ pair (--lj-table): cubic Hermite splines of the pair energy and of the force over r in
+// s = r^2, on n_intervals equal intervals from r2_min to the cutoff. Interval k holds 8 coefficients,
+// energy then force, of cubics in the fraction f of the interval, so a lookup reads one cache line.
+typedef struct {
+    double r2_min;      // Pairs closer than this use lj_pair
+    LJCoefficients lj;  // The (single) species pair the table holds
+    double inv_h;       // Intervals per nm^2
+    size_t n_intervals;
+    double* coeff;      // 8 * (n_intervals + 1) coefficients, 64-byte aligned
+} LJTable;
+
+// Pair-interaction settings shared by the neighbor-list kernels
+typedef struct {
+    double cutoff2;     // Squared cutoff
+    const LJCoefficients* lj; // LJ coefficients by [type_i * n_types + type_j]
+    const int* type;    // Type of every atom, NULL for a single species (lj[0])
+    int n_types;
+    double box[3];      // Periodic box lengths (in nm), zero along open directions
+    int split;          // FORCE_FULL, FORCE_INNER or FORCE_OUTER
+    double switch_start;     // S(r) = 1 below switch_start, 0 beyond switch_start + 1 / inv_switch_width
+    double inv_switch_width;
+    const LJTable* table;    // Tabulated LJ, NULL for the analytic lj_pair
+} PairParams;
+
+// LJ kernel for one neighbor-list row: adds the forces between atom i and its count partners
+// to the force buffers (third law on both atoms), adds sum r.F of the row to *virial and
+// returns the shifted pair energy of the row
+typedef double (*LJRowKernel)(size_t i, const int* neighbors, size_t count,
+                              const double* x, const double* y, const double* z, const PairParams* pair,
+                              double* fx_t, double* fy_t, double* fz_t, double* virial);
+
+// Simulation state: per-atom data as aligned structure-of-arrays, plus every work buffer
+// the time step needs. Everything is allocated once in init_simulation.
+typedef struct {
+    size_t Natoms;
+    char (*symbol)[3];         // Element symbols
+    double *x, *y, *z;         // Positions (in nm)
+    double *vx, *vy, *vz;      // Velocities
+    double *ax, *ay, *az;      // Accelerations
+    double *ax_new, *ay_new, *az_new; // Accelerations at the new positions, swapped with ax/ay/az
+    double* mass;              // Masses
+    int n_threads;             // Threads the force buffers are sized for
+    double* thread_forces;     // 3 * Natoms force accumulators for each thread but the first
+    NeighborList* nlist;       // Neighbor list, cutoff path only
+    NeighborList neighbor_list;
+    double box[3];             // Periodic box lengths (in nm), all zero for an isolated cluster
+    double energy_tail;        // Long-range LJ corrections beyond the cutoff (periodic box only)
+    double pressure_tail;
+    double virial;             // sum r.F over pairs from the last force evaluation (cutoff path)
+    int respa_steps;           // r-RESPA inner steps per time step, 1 for plain velocity Verlet
+    double switch_width;       // r-RESPA switching width (in nm)
+    double *ax_slow, *ay_slow, *az_slow; // r-RESPA: accelerations from the outer (long-range) forces
+    LJRowKernel lj_row;        // Neighbor-list kernel chosen by select_lj_kernel
+    const char* lj_kernel_name;
+    LJTable* lj_table;         // Tabulated LJ (--lj-table), NULL for the analytic formula
+    LJTable lj_table_data;
+    LJSpecies species;         // LJ parameters of every pair of types
+    int* type;                 // Type of every atom, NULL for a single species
+    size_t* atom_id;           // Input position of every atom, NULL while they are stored in input order
+    int reorder_interval;      // Atoms are put in Morton order at every reorder_interval-th rebuild, 0 = never
+} Simulation;
+
+// Function to evaluate one LJ pair with coefficients lj from r^2 without pow or sqrt.
+// Returns the force magnitude divided by r and stores the (unshifted) pair energy in *energy.
+static inline double lj_pair(double r2, const LJCoefficients* lj, double* energy) {
+    double sr2 = lj->sigma2 / r2;
+    double sr6 = sr2 * sr2 * sr2;
+    double sr12 = sr6 * sr6;
+    *energy = lj->eps4 * (sr12 - sr6);
+    return lj->eps24 * (2 * sr12 - sr6) / r2;
+}
+
+// Function to evaluate one LJ pair from the table, like lj_pair: returns the force magnitude divided by r
+// and stores the pair energy in *energy. r2 must be below the end of the table.
+static inline double lj_pair_table(const LJTable* table, double r2, double* energy) {
+    if (r2 < table->r2_min) {
+        return lj_pair(r2, &table->lj, energy);
+    }
+    double t = (r2 - table->r2_min) * table->inv_h;
+    int k = (int)t;
+    double f = t - (double)k;
+    const double* c = table->coeff + 8 * (size_t)k;
+    *energy = ((c[3] * f + c[2]) * f + c[1]) * f + c[0];
+    return ((c[7] * f + c[6]) * f + c[5]) * f + c[4];
+}
+
+// Function to apply the minimum-image convention to one component of a pair separation.
+// Valid for |d| < 3L/2, which holds between rebuilds since positions are wrapped at every rebuild.
+// With L = 0 (open direction) d is returned unchanged, so callers need no branch.
+static inline double minimum_image(double d, double L) {
+    return d - L * ((d > 0.5 * L) - (d < -0.5 * L));
+}
+
+// Function to wrap one coordinate into [0, L); unchanged along an open direction (L = 0)
+static inline double wrap_coordinate(double c, double L) {
+    return L > 0.0 ? c - L * floor(c / L) : c;
+}
+
+// Function to compute the long-range LJ energy and pressure corrections beyond the cutoff in a periodic box
+void lj_tail_corrections(const LJSpecies* species, const double box[3], double cutoff, double* energy_tail,
+                         double* pressure_tail);
+
+// Function to set up the simulation state from the loaded atoms; velocities start at zero
+void init_simulation(Simulation* sim, const Atom* atoms, size_t Natoms, const LJSpecies* species, const int* type,
+                     double cutoff, double skin, int n_threads, const double* box);
+
+// Function to free the simulation state
+void free_simulation(Simulation* sim);
+
+// Function to build the LJ table of the (single) species with n_intervals intervals up to the cutoff
+void init_lj_table(Simulation* sim, size_t n_intervals, int report);
+
+// Function to wrap the positions back into the periodic box
+void wrap_positions(Simulation* sim);
+
+// Function to store the atoms in a new order: atom k becomes the old atom order[k]
+void permute_atoms(Simulation* sim, const size_t* order);
+
+// Function to store the atoms along a Morton (Z-order) curve through the box
+void reorder_atoms(Simulation* sim);
+
+// Function to rebuild the neighbor list, wrapping (and every reorder_interval-th time reordering) the atoms first
+void rebuild_neighbor_list(Simulation* sim);
+
+#endif // SIMULATION_H
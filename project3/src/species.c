@@ -0,0 +1,144 @@
+// File: src/species.c
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "species.h"
+
+// Function to set up the LJ species of the loaded atoms. Every distinct symbol is a type, in order of
+// first appearance, with its 'species' parameters, or EPSILON and SIGMA without any. Unlike types are mixed
+// with the Lorentz-Berthelot rules, eps_ab = sqrt(eps_a eps_b) and sigma_ab = (sigma_a + sigma_b) / 2,
+// unless a 'species_pair' gives their parameters. The shifts are taken at cutoff (none for cutoff 0).
+// If every pair comes out alike the run has a single species and *type_out is NULL; otherwise it gets
+// the type of every atom. Returns 0 for more than MAX_SPECIES symbols.
+int init_species(const RunConfig* cfg, const Atom* atoms, size_t Natoms, double cutoff, LJSpecies* species,
+                 int** type_out) {
+    memset(species, 0, sizeof(*species));
+    int* type = malloc((Natoms > 0 ? Natoms : 1) * sizeof(int));
+    if (type == NULL) {
+        printf("Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    int t = 0;
+    for (size_t i = 0; i < Natoms; i++) {
+        if (species->n_types == 0 || strcmp(atoms[i].atom, species->symbol[t]) != 0) {
+            t = 0;
+            while (t < species->n_types && strcmp(atoms[i].atom, species->symbol[t]) != 0) {
+                t++;
+            }
+            if (t == MAX_SPECIES) {
+                printf("More than %d species in the input\n", MAX_SPECIES);
+                free(type);
+                return 0;
+            }
+            if (t == species->n_types) {
+                memcpy(species->symbol[t], atoms[i].atom, sizeof(species->symbol[t]));
+                species->n_types++;
+            }
+        }
+        type[i] = t;
+        species->count[t]++;
+    }
+
+    // Parameters of every pair of types, from the like pairs
+    int n = species->n_types > 0 ? species->n_types : 1;
+    double epsilon[MAX_SPECIES], sigma[MAX_SPECIES];
+    for (int a = 0; a < n; a++) {
+        epsilon[a] = EPSILON;
+        sigma[a] = SIGMA;
+        for (int k = 0; k < cfg->n_species; k++) {
+            if (strcmp(cfg->species[k].symbol[0], species->symbol[a]) == 0) {
+                epsilon[a] = cfg->species[k].epsilon;
+                sigma[a] = cfg->species[k].sigma;
+            }
+        }
+    }
+    int alike = 1;
+    for (int a = 0; a < n; a++) {
+        for (int b = 0; b < n; b++) {
+            double eps_ab = a == b ? epsilon[a] : sqrt(epsilon[a] * epsilon[b]);
+            double sigma_ab = a == b ? sigma[a] : 0.5 * (sigma[a] + sigma[b]);
+            for (int k = 0; k < cfg->n_species_pairs; k++) {
+                const SpeciesParams* p = &cfg->species_pairs[k];
+                if ((strcmp(p->symbol[0], species->symbol[a]) == 0 && strcmp(p->symbol[1], species->symbol[b]) == 0) ||
+                    (strcmp(p->symbol[0], species->symbol[b]) == 0 && strcmp(p->symbol[1], species->symbol[a]) == 0)) {
+                    eps_ab = p->epsilon;
+                    sigma_ab = p->sigma;
+                }
+            }
+            species->epsilon[a * n + b] = eps_ab;
+            species->sigma[a * n + b] = sigma_ab;
+            alike &= eps_ab == epsilon[0] && sigma_ab == sigma[0];
+        }
+    }
+    if (alike) {
+        species->count[0] = Natoms;
+        free(type);
+        type = NULL;
+    }
+    species->n_types = alike ? 1 : n;
+    for (int ab = 0; ab < species->n_types * species->n_types; ab++) {
+        LJCoefficients* lj = &species->lj[ab];
+        lj->sigma2 = species->sigma[ab] * species->sigma[ab];
+        lj->eps4 = 4 * species->epsilon[ab];
+        lj->eps24 = 24 * species->epsilon[ab];
+        lj->shift = 0.0;
+        if (cutoff > 0.0) {
+            lj_pair(cutoff * cutoff, lj, &lj->shift);
+        }
+    }
+    *type_out = type;
+    return 1;
+}
+
+// Function to store a mixture sorted by type (stable, so input order within a type): reorders atoms and
+// type in place and returns the input position of every sorted atom
+size_t* sort_atoms_by_type(Atom* atoms, int* type, size_t Natoms, int n_types) {
+    size_t start[MAX_SPECIES + 1] = { 0 };
+    for (size_t i = 0; i < Natoms; i++) {
+        start[type[i] + 1]++;
+    }
+    for (int t = 0; t < n_types; t++) {
+        start[t + 1] += start[t];
+    }
+    size_t* atom_id = malloc((Natoms > 0 ? Natoms : 1) * sizeof(size_t));
+    Atom* sorted = malloc((Natoms > 0 ? Natoms : 1) * sizeof(Atom));
+    if (atom_id == NULL || sorted == NULL) {
+        printf("Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < Natoms; i++) {
+        size_t slot = start[type[i]]++;
+        atom_id[slot] = i;
+        sorted[slot] = atoms[i];
+    }
+    memcpy(atoms, sorted, Natoms * sizeof(Atom));
+    size_t slot = 0;
+    for (int t = 0; t < n_types; t++) {
+        for (; slot < start[t]; slot++) { // start[t] is now the end of type t
+            type[slot] = t;
+        }
+    }
+    free(sorted);
+    return atom_id;
+}
+
+// Function to print the LJ parameters of a mixture or of a single species other than the default
+void report_species(const LJSpecies* species) {
+    int n = species->n_types;
+    if (n == 1 && species->epsilon[0] == EPSILON && species->sigma[0] == SIGMA) {
+        return;
+    }
+    printf("LJ species:");
+    for (int a = 0; a < n; a++) {
+        printf(" %s (%zu atoms)", n > 1 ? species->symbol[a] : "all", species->count[a]);
+    }
+    printf("\n");
+    for (int a = 0; a < n; a++) {
+        for (int b = a; b < n; b++) {
+            printf("  %s-%s: epsilon %.6g kcal/mol, sigma %.6g nm\n", species->symbol[a], species->symbol[b],
+                   species->epsilon[a * n + b], species->sigma[a * n + b]);
+        }
+    }
+}
@@ -0,0 +1,21 @@
+// File: src/species.h
+
+#ifndef SPECIES_H
+#define SPECIES_H
+
+#include "atoms.h"
+#include "config.h"
+#include "simulation.h"
+
+// Function to set up the LJ species of the loaded atoms and the type of every atom (*type_out is NULL
+// for a single species); returns 0 for more than MAX_SPECIES symbols
+int init_species(const RunConfig* cfg, const Atom* atoms, size_t Natoms, double cutoff, LJSpecies* species,
+                 int** type_out);
+
+// Function to store a mixture sorted by type; returns the input position of every sorted atom
+size_t* sort_atoms_by_type(Atom* atoms, int* type, size_t Natoms, int n_types);
+
+// Function to print the LJ parameters of a mixture or of a single species other than the default
+void report_species(const LJSpecies* species);
+
+#endif // SPECIES_H
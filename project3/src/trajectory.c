@@ -0,0 +1,250 @@
+// File: src/trajectory.c
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "trajectory.h"
+
+// Write the trajectory to an XYZ file; coordinates are wrapped into the box if there is one
+void write_xyz(FILE* file, const Simulation* sim, double LJ_potential, double kinetic_energy) {
+    fprintf(file, "%zu\n", sim->Natoms); // Number of atoms
+    fprintf(file, "LJ=%.6f, KE=%.6f, Total=%.6f\n", LJ_potential, kinetic_energy, LJ_potential + kinetic_energy); // Comment line
+
+    for (size_t i = 0; i < sim->Natoms; i++) {
+        fprintf(file, "%s %.6f %.6f %.6f\n", sim->symbol[i], wrap_coordinate(sim->x[i], sim->box[0]),
+                wrap_coordinate(sim->y[i], sim->box[1]), wrap_coordinate(sim->z[i], sim->box[2]));
+    }
+}
+
+// Write energies to a CSV file for plotting; pressure (periodic box only) may be NULL
+void write_energies(FILE* energy_file, int step, double LJ_potential, double kinetic_energy, const double* pressure) {
+    double total_energy = LJ_potential + kinetic_energy;
+    if (pressure != NULL) {
+        fprintf(energy_file, "%d,%.6f,%.6f,%.6f,%.6f\n", step, LJ_potential, kinetic_energy, total_energy, *pressure);
+    } else {
+        fprintf(energy_file, "%d,%.6f,%.6f,%.6f\n", step, LJ_potential, kinetic_energy, total_energy);
+    }
+}
+
+static const char btr_magic[8] = { 'L', 'J', 'B', 'T', 'R', 'A', 'J', '1' };
+static const char btr_index_magic[8] = { 'L', 'J', 'B', 'T', 'R', 'I', 'D', 'X' };
+
+// Function to append a signed integer as a zigzag varint; returns the new end of the buffer
+static inline unsigned char* put_varint(unsigned char* out, int64_t value) {
+    uint64_t u = ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+    while (u >= 0x80) {
+        *out++ = (unsigned char)(u | 0x80);
+        u >>= 7;
+    }
+    *out++ = (unsigned char)u;
+    return out;
+}
+
+// Function to read a zigzag varint from [*p, end); returns 0 if the data is truncated
+static inline int get_varint(const unsigned char** p, const unsigned char* end, int64_t* value) {
+    uint64_t u = 0;
+    for (int shift = 0; *p < end && shift < 64; shift += 7) {
+        unsigned char byte = *(*p)++;
+        u |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            *value = (int64_t)(u >> 1) ^ -(int64_t)(u & 1);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Function to create a binary trajectory and write its header. With resume the file is reopened for
+// appending instead, and n_frames, index and previous are kept as restored by read_checkpoint.
+void open_binary_trajectory(BinaryTrajectory* bt, const char* path, const Simulation* sim, double precision, int resume) {
+    bt->file = fopen(path, resume ? "r+b" : "wb");
+    bt->Natoms = sim->Natoms;
+    bt->precision = precision;
+    bt->buffer = malloc(3 * sim->Natoms * 10); // A varint never exceeds 10 bytes
+    if (!resume) {
+        bt->previous = malloc(3 * sim->Natoms * sizeof(int64_t));
+        bt->n_frames = 0;
+        bt->index_capacity = 64;
+        bt->index = malloc(bt->index_capacity * sizeof(uint64_t));
+    }
+    if (bt->file == NULL || bt->previous == NULL || bt->buffer == NULL || bt->index == NULL) {
+        perror("Error opening binary trajectory");
+        exit(EXIT_FAILURE);
+    }
+    if (resume) {
+        fseek(bt->file, 0, SEEK_END);
+        return;
+    }
+
+    uint64_t natoms = sim->Natoms;
+    uint32_t layout[2] = { KEYFRAME_INTERVAL, 0 };
+    int ok = fwrite(btr_magic, sizeof(btr_magic), 1, bt->file) == 1 && fwrite(&natoms, sizeof(natoms), 1, bt->file) == 1 &&
+             fwrite(&precision, sizeof(precision), 1, bt->file) == 1 && fwrite(layout, sizeof(layout), 1, bt->file) == 1;
+    if (sim->atom_id == NULL) {
+        ok = ok && fwrite(sim->symbol, sizeof(*sim->symbol), sim->Natoms, bt->file) == sim->Natoms;
+    } else {
+        // Frames are written in input order, so the symbols are too
+        char (*symbol)[3] = malloc(sim->Natoms * sizeof(*symbol));
+        if (symbol == NULL) {
+            printf("Memory allocation failed for the trajectory header\n");
+            exit(EXIT_FAILURE);
+        }
+        for (size_t i = 0; i < sim->Natoms; i++) {
+            memcpy(symbol[sim->atom_id[i]], sim->symbol[i], sizeof(*symbol));
+        }
+        ok = ok && fwrite(symbol, sizeof(*symbol), sim->Natoms, bt->file) == sim->Natoms;
+        free(symbol);
+    }
+    if (!ok) {
+        perror("Error writing binary trajectory");
+        exit(EXIT_FAILURE);
+    }
+}
+
+// Function to quantize, delta-encode and append one frame
+void write_binary_frame(BinaryTrajectory* bt, const Simulation* sim, double LJ_potential, double kinetic_energy) {
+    if (bt->n_frames == bt->index_capacity) {
+        bt->index_capacity *= 2;
+        bt->index = realloc(bt->index, bt->index_capacity * sizeof(uint64_t));
+        if (bt->index == NULL) {
+            printf("Memory allocation failed for the trajectory index\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    bt->index[bt->n_frames] = (uint64_t)ftell(bt->file);
+    int keyframe = bt->n_frames % KEYFRAME_INTERVAL == 0;
+    bt->n_frames++;
+
+    const double* coords[3] = { sim->x, sim->y, sim->z };
+    double scale = 1.0 / bt->precision;
+    unsigned char* out = bt->buffer;
+    int64_t last[3] = { 0, 0, 0 };
+    for (size_t i = 0; i < bt->Natoms; i++) {
+        for (int d = 0; d < 3; d++) {
+            int64_t q = llround(wrap_coordinate(coords[d][i], sim->box[d]) * scale);
+            int64_t* prev = &bt->previous[3 * i + d];
+            out = put_varint(out, keyframe ? q - last[d] : q - *prev);
+            last[d] = q;
+            *prev = q;
+        }
+    }
+
+    uint64_t bytes = (uint64_t)(out - bt->buffer);
+    double energies[2] = { LJ_potential, kinetic_energy };
+    if (fwrite(energies, sizeof(energies), 1, bt->file) != 1 || fwrite(&bytes, sizeof(bytes), 1, bt->file) != 1 ||
+        fwrite(bt->buffer, 1, bytes, bt->file) != bytes) {
+        perror("Error writing binary trajectory");
+        exit(EXIT_FAILURE);
+    }
+}
+
+// Function to write the frame index and footer and close the binary trajectory
+void close_binary_trajectory(BinaryTrajectory* bt) {
+    uint64_t footer[2] = { (uint64_t)ftell(bt->file), bt->n_frames };
+    int ok = fwrite(bt->index, sizeof(uint64_t), bt->n_frames, bt->file) == bt->n_frames &&
+             fwrite(footer, sizeof(footer), 1, bt->file) == 1 &&
+             fwrite(btr_index_magic, sizeof(btr_index_magic), 1, bt->file) == 1;
+    if (fclose(bt->file) != 0 || !ok) {
+        perror("Error writing binary trajectory index");
+        exit(EXIT_FAILURE);
+    }
+    free(bt->previous);
+    free(bt->buffer);
+    free(bt->index);
+}
+
+// Function to convert a binary trajectory back to XYZ (coordinates rounded to the stored precision).
+// Frames are located through the index; returns 0 on a malformed file.
+int convert_binary_trajectory(const char* input_path, const char* output_path) {
+    FILE* in = fopen(input_path, "rb");
+    if (in == NULL) {
+        perror("Error opening binary trajectory");
+        return 0;
+    }
+
+    char magic[8];
+    uint64_t natoms, footer[2];
+    double precision;
+    uint32_t layout[2];
+    long size = -1;
+    int ok = fread(magic, sizeof(magic), 1, in) == 1 && memcmp(magic, btr_magic, sizeof(magic)) == 0 &&
+             fread(&natoms, sizeof(natoms), 1, in) == 1 && fread(&precision, sizeof(precision), 1, in) == 1 &&
+             fread(layout, sizeof(layout), 1, in) == 1 && layout[0] > 0 && fseek(in, 0, SEEK_END) == 0 &&
+             (size = ftell(in)) >= 0;
+
+    // The counts in the file size the allocations below, so they are checked against the file size
+    // first: a corrupt or crafted file could otherwise overflow the products and overrun the buffers
+    long header_bytes = (long)(sizeof(magic) + sizeof(natoms) + sizeof(precision) + sizeof(layout));
+    long trailer_bytes = (long)(sizeof(footer) + sizeof(magic));
+    ok = ok && size >= header_bytes + trailer_bytes && natoms <= (uint64_t)(size - header_bytes - trailer_bytes) / 3 &&
+         natoms <= SIZE_MAX / (3 * 10) && fseek(in, header_bytes, SEEK_SET) == 0;
+    char (*symbol)[3] = ok ? malloc(natoms * sizeof(*symbol)) : NULL;
+    ok = ok && symbol != NULL && fread(symbol, sizeof(*symbol), natoms, in) == natoms;
+    ok = ok && fseek(in, -trailer_bytes, SEEK_END) == 0 &&
+         fread(footer, sizeof(footer), 1, in) == 1 && fread(magic, sizeof(magic), 1, in) == 1 &&
+         memcmp(magic, btr_index_magic, sizeof(magic)) == 0;
+    // The index runs from footer[0] up to the footer, one offset per frame
+    uint64_t index_end = ok ? (uint64_t)(size - trailer_bytes) : 0;
+    ok = ok && footer[0] >= (uint64_t)header_bytes + 3 * natoms && footer[0] <= index_end &&
+         (index_end - footer[0]) % sizeof(uint64_t) == 0 && footer[1] == (index_end - footer[0]) / sizeof(uint64_t);
+    uint64_t* index = ok ? malloc((footer[1] + 1) * sizeof(uint64_t)) : NULL;
+    ok = ok && index != NULL && fseek(in, (long)footer[0], SEEK_SET) == 0 &&
+         fread(index, sizeof(uint64_t), footer[1], in) == footer[1];
+    if (!ok) {
+        printf("'%s' is not a complete binary trajectory\n", input_path);
+        free(symbol);
+        free(index);
+        fclose(in);
+        return 0;
+    }
+
+    FILE* out = fopen(output_path, "w");
+    int64_t* q = malloc(3 * natoms * sizeof(int64_t));
+    unsigned char* payload = malloc(3 * natoms * 10);
+    if (out == NULL || q == NULL || payload == NULL) {
+        perror("Error opening XYZ output");
+        exit(EXIT_FAILURE);
+    }
+
+    for (uint64_t f = 0; f < footer[1] && ok; f++) {
+        double energies[2];
+        uint64_t bytes;
+        ok = fseek(in, (long)index[f], SEEK_SET) == 0 && fread(energies, sizeof(energies), 1, in) == 1 &&
+             fread(&bytes, sizeof(bytes), 1, in) == 1 && bytes <= 3 * natoms * 10 &&
+             fread(payload, 1, bytes, in) == bytes;
+
+        int keyframe = f % layout[0] == 0;
+        const unsigned char* p = payload;
+        int64_t last[3] = { 0, 0, 0 };
+        for (uint64_t i = 0; i < natoms && ok; i++) {
+            for (int d = 0; d < 3 && ok; d++) {
+                int64_t delta = 0;
+                ok = get_varint(&p, payload + bytes, &delta);
+                q[3 * i + d] = keyframe ? (last[d] += delta) : q[3 * i + d] + delta;
+            }
+        }
+        if (!ok) {
+            break;
+        }
+
+        fprintf(out, "%llu\n", (unsigned long long)natoms);
+        fprintf(out, "LJ=%.6f, KE=%.6f, Total=%.6f\n", energies[0], energies[1], energies[0] + energies[1]);
+        for (uint64_t i = 0; i < natoms; i++) {
+            fprintf(out, "%s %.6f %.6f %.6f\n", symbol[i], q[3 * i] * precision, q[3 * i + 1] * precision,
+                    q[3 * i + 2] * precision);
+        }
+    }
+    if (!ok) {
+        printf("'%s' is truncated or corrupt\n", input_path);
+    }
+
+    fclose(out);
+    fclose(in);
+    free(symbol);
+    free(index);
+    free(q);
+    free(payload);
+    return ok;
+}
@@ -0,0 +1,51 @@
+// File: src/trajectory.h
+
+#ifndef TRAJECTORY_H
+#define TRAJECTORY_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "simulation.h"
+
+#define KEYFRAME_INTERVAL 10 // Every n-th binary frame is stored without reference to the previous one
+
+// Binary trajectory (.btr), an XTC-like compact alternative to XYZ. All fields are little-endian.
+//   header : "LJBTRAJ1", uint64 Natoms, double precision (nm), uint32 keyframe interval, uint32 0,
+//            Natoms x char[3] symbols
+//   frame  : double LJ, double KE, uint64 payload bytes, payload
+//   index  : uint64 file offset of every frame
+//   footer : uint64 index offset, uint64 frame count, "LJBTRIDX"
+// Coordinates (wrapped into the box, if any) are rounded to integer multiples of the precision. A keyframe stores, per axis, the
+// difference to the previous atom (neighbors in the file are mostly neighbors in space); the other
+// frames store the difference to the same atom in the previous frame, which is tiny between output
+// steps. Differences are zigzag-mapped and written as variable-length integers (7 bits per byte),
+// so most coordinates take one or two bytes. The index lets a reader seek to any keyframe.
+typedef struct {
+    FILE* file;
+    size_t Natoms;
+    double precision;
+    int64_t* previous;     // Quantized coordinates of the last frame, 3 per atom
+    unsigned char* buffer; // Encoded payload of one frame
+    uint64_t* index;       // Offset of every frame
+    size_t n_frames, index_capacity;
+} BinaryTrajectory;
+
+// Write the trajectory to an XYZ file; coordinates are wrapped into the box if there is one
+void write_xyz(FILE* file, const Simulation* sim, double LJ_potential, double kinetic_energy);
+
+// Write energies to a CSV file for plotting; pressure (periodic box only) may be NULL
+void write_energies(FILE* energy_file, int step, double LJ_potential, double kinetic_energy, const double* pressure);
+
+// Function to create a binary trajectory and write its header, or with resume reopen it for appending
+void open_binary_trajectory(BinaryTrajectory* bt, const char* path, const Simulation* sim, double precision, int resume);
+
+// Function to quantize, delta-encode and append one frame
+void write_binary_frame(BinaryTrajectory* bt, const Simulation* sim, double LJ_potential, double kinetic_energy);
+
+// Function to write the frame index and footer and close the binary trajectory
+void close_binary_trajectory(BinaryTrajectory* bt);
+
+// Function to convert a binary trajectory back to XYZ; returns 0 on a malformed file
+int convert_binary_trajectory(const char* input_path, const char* output_path);
+
+#endif // TRAJECTORY_H
@@ -0,0 +1,22 @@
+// File: src/util.c
+
+#include <stdlib.h>
+#include <time.h>
+#include "util.h"
+
+// Function to allocate a 64-byte aligned array of n doubles
+double* malloc_aligned(size_t n) {
+    void* a = NULL;
+    size_t bytes = ((n * sizeof(double) + 63) / 64) * 64;
+    if (posix_memalign(&a, 64, bytes > 0 ? bytes : 64) != 0) {
+        return NULL;
+    }
+    return (double*)a;
+}
+
+// Function to return a monotonic wall-clock time in seconds
+double wall_time(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + 1e-9 * (double)ts.tv_nsec;
+}
@@ -0,0 +1,14 @@
+// File: src/util.h
+
+#ifndef UTIL_H
+#define UTIL_H
+
+#include <stddef.h>
+
+// Function to allocate a 64-byte aligned array of n doubles; NULL if out of memory
+double* malloc_aligned(size_t n);
+
+// Function to return a monotonic wall-clock time in seconds
+double wall_time(void);
+
+#endif // UTIL_H
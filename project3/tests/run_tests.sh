@@ -0,0 +1,172 @@
+#!/bin/bash
+# File: tests/run_tests.sh
+#
+# Consistency tests for the Lennard-Jones program.
+#
+# Small lattices are generated in a scratch directory and every run is compared
+# with another run that must give the same result:
+#
+#   neighbor list   a cutoff beyond the cluster gives the all-pairs energies and trajectory
+#   simd            the scalar, AVX2 and AVX-512 kernels agree (kernels the CPU lacks are skipped)
+#   restart         a run restarted from a checkpoint is cmp-identical to a straight run
+#   btr             a binary trajectory converted to xyz matches the xyz trajectory
+#   mpi             two MPI ranks give the serial energies and trajectory
+#   mixture         a second species with the Ar parameters gives the single-species energies
+#
+# Runs whose summation order differs are compared number by number within a
+# tolerance; the restart must match byte for byte.
+#
+# Usage: tests/run_tests.sh
+#
+# Environment:
+#   ENERGY_TOL  Absolute tolerance on printed energies and coordinates (default: 1e-5)
+#   MPIRUN      Command that starts two ranks (default: mpirun -np 2)
+
+cd "$(dirname "$0")/.." || exit 1
+
+EXEC=$PWD/program
+EXEC_MPI=$PWD/program_mpi
+
+ENERGY_TOL=${ENERGY_TOL:-1e-5}
+MPIRUN=${MPIRUN:-mpirun -np 2}
+
+for prog in "$EXEC" "$EXEC_MPI"; do
+    if [ ! -x "$prog" ]; then
+        echo "Missing $prog; run 'make all mpi' first." >&2
+        exit 1
+    fi
+done
+
+WORK=$(mktemp -d "${TMPDIR:-/tmp}/lj_tests.XXXXXX")
+trap 'rm -rf "$WORK"' EXIT
+
+# Writes an n x n x n simple cubic lattice with spacing $2 (in nm) and a fixed small jitter;
+# with $3 = 1 every other site is "Kr", which keeps the Ar mass
+lattice() {
+    awk -v n="$1" -v a="$2" -v mix="$3" 'BEGIN {
+        srand(3)
+        print n * n * n
+        for (i = 0; i < n; i++) for (j = 0; j < n; j++) for (k = 0; k < n; k++) {
+            symbol = (mix && (i + j + k) % 2) ? "Kr" : "Ar"
+            printf "%s %.4f %.4f %.4f 39.948\n", symbol, (i + 0.1 * (rand() - 0.5)) * a,
+                   (j + 0.1 * (rand() - 0.5)) * a, (k + 0.1 * (rand() - 0.5)) * a
+        }
+    }'
+}
+
+# Isolated cluster of 64 atoms, and a periodic box of 216 atoms (6 * 0.37 = 2.22 nm)
+lattice 4 0.38 0 > "$WORK/cluster.txt"
+lattice 6 0.37 0 > "$WORK/box.txt"
+lattice 6 0.37 1 > "$WORK/mix.txt"
+BOX="--box 2.22 2.22 2.22 --cutoff 0.85"
+
+# Runs the program in a fresh directory $WORK/$1 with the remaining arguments; the launcher
+# (e.g. mpirun) comes first when $2 is not the executable
+run() {
+    local dir=$WORK/$1
+    shift
+    mkdir -p "$dir"
+    if ! (cd "$dir" && "$@" > stdout.txt 2>&1); then
+        echo "FAIL $(basename "$dir"): the run exited with an error"
+        tail -3 "$dir/stdout.txt"
+        failures=$((failures + 1))
+        return 1
+    fi
+}
+
+# Compares two text files token by token: numbers within tolerance $4, everything else exactly;
+# $1 labels the check
+same_numbers() {
+    local result
+    result=$(awk -v tol="$4" '
+        NR == FNR { a[FNR] = $0; n = FNR; next }
+        {
+            m = FNR
+            if (FNR > n) { print "line " FNR ": extra line"; bad = 1; exit 1 }
+            gsub(/[,=]/, " & ", a[FNR]); gsub(/[,=]/, " & ")
+            k = split(a[FNR], x, " ")
+            if (split($0, y, " ") != k) { print "line " FNR ": field count differs"; bad = 1; exit 1 }
+            for (f = 1; f <= k; f++) {
+                numeric = x[f] ~ /^-?[0-9.]+(e[-+]?[0-9]+)?$/ && y[f] ~ /^-?[0-9.]+(e[-+]?[0-9]+)?$/
+                if (numeric ? (x[f] - y[f] > tol || y[f] - x[f] > tol) : x[f] != y[f]) {
+                    print "line " FNR ": " x[f] " vs " y[f]; bad = 1; exit 1
+                }
+            }
+        }
+        END { if (!bad && m < n) { print "line " m + 1 ": missing line"; exit 1 } }' "$2" "$3")
+    if [ $? -eq 0 ]; then
+        echo "ok   $1"
+    else
+        echo "FAIL $1: $result"
+        failures=$((failures + 1))
+    fi
+}
+
+# Compares two files byte by byte; $1 labels the check
+same_bytes() {
+    if cmp -s "$2" "$3"; then
+        echo "ok   $1"
+    else
+        echo "FAIL $1: $(cmp "$2" "$3" 2>&1)"
+        failures=$((failures + 1))
+    fi
+}
+
+failures=0
+
+# Neighbor list against all pairs: with a cutoff beyond the cluster every pair is in the list
+# and the shift of the potential at the cutoff is far below the printed digits
+if run all_pairs "$EXEC" --input ../cluster.txt --steps 200 &&
+   run neighbor_list "$EXEC" --input ../cluster.txt --steps 200 --cutoff 50; then
+    same_numbers "neighbor list: energies" "$WORK/all_pairs/energies.csv" "$WORK/neighbor_list/energies.csv" "$ENERGY_TOL"
+    same_numbers "neighbor list: trajectory" "$WORK/all_pairs/trajectory.xyz" "$WORK/neighbor_list/trajectory.xyz" "$ENERGY_TOL"
+fi
+
+# SIMD kernels against the scalar one, in the periodic box
+if run simd_scalar "$EXEC" --input ../box.txt $BOX --steps 200 --simd scalar; then
+    for kernel in avx2:avx2 avx512:avx512f; do
+        name=${kernel%%:*}
+        if ! grep -qw "${kernel#*:}" /proc/cpuinfo 2>/dev/null; then
+            echo "skip simd $name: not supported by this CPU"
+            continue
+        fi
+        run "simd_$name" "$EXEC" --input ../box.txt $BOX --steps 200 --simd "$name" || continue
+        same_numbers "simd $name: energies" "$WORK/simd_scalar/energies.csv" "$WORK/simd_$name/energies.csv" "$ENERGY_TOL"
+        same_numbers "simd $name: trajectory" "$WORK/simd_scalar/trajectory.xyz" "$WORK/simd_$name/trajectory.xyz" "$ENERGY_TOL"
+    done
+fi
+
+# Restart: stop at step 150 (checkpoint at step 100), then finish from the checkpoint
+RESTART="--input ../box.txt $BOX --checkpoint run.ckpt --checkpoint-interval 100"
+if run straight "$EXEC" $RESTART --steps 300 &&
+   run restarted "$EXEC" $RESTART --steps 150 &&
+   run restarted "$EXEC" $RESTART --steps 300 --restart; then
+    same_bytes "restart: energies" "$WORK/straight/energies.csv" "$WORK/restarted/energies.csv"
+    same_bytes "restart: trajectory" "$WORK/straight/trajectory.xyz" "$WORK/restarted/trajectory.xyz"
+fi
+
+# Binary trajectory: coordinates are stored to --precision, so they may move by half of it
+if run xyz "$EXEC" --input ../cluster.txt --steps 200 &&
+   run btr "$EXEC" --input ../cluster.txt --steps 200 --trajectory btr --precision 0.0001 &&
+   run btr "$EXEC" --convert trajectory.btr trajectory.xyz; then
+    same_numbers "btr -> xyz" "$WORK/xyz/trajectory.xyz" "$WORK/btr/trajectory.xyz" 0.000051
+fi
+
+# MPI domain decomposition over two ranks against the serial run
+if run mpi $MPIRUN "$EXEC_MPI" --input ../box.txt $BOX --steps 200; then
+    same_numbers "mpi: energies" "$WORK/simd_scalar/energies.csv" "$WORK/mpi/energies.csv" "$ENERGY_TOL"
+    same_numbers "mpi: trajectory" "$WORK/simd_scalar/trajectory.xyz" "$WORK/mpi/trajectory.xyz" "$ENERGY_TOL"
+fi
+
+# A mixture of two species with identical parameters is the single-species system; the atoms are
+# stored sorted by species, so only the energies are compared
+if run single "$EXEC" --input ../box.txt $BOX --steps 200 &&
+   run mixture "$EXEC" --input ../mix.txt $BOX --steps 200 --species Kr 0.0661 0.3345; then
+    same_numbers "mixture: energies" "$WORK/single/energies.csv" "$WORK/mixture/energies.csv" "$ENERGY_TOL"
+fi
+
+if [ "$failures" -gt 0 ]; then
+    echo "$failures check(s) failed"
+    exit 1
+fi
+echo "All checks passed"